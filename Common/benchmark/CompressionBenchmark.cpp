@@ -0,0 +1,343 @@
+// Сравнение методов сжатия на прошивках: размер, скорость сжатия и распаковки
+// на этой машине и время передачи по CAN. Кроме встроенных SBL и
+// сгенерированных образов принимает файлы: *.vbf разбираются, остальные
+// берутся как BIN целиком. Отдельно меряются глубина поиска LZSS против
+// перебора окна, Bosch с SSE2 против побайтового и подготовка чанков
+// UDSDownloadEncoder в один и в несколько потоков.
+//
+//     CompressionBenchmark [--baudrate 500000] [file...]
+
+#include "common/compression/BoschCompressor.hpp"
+#include "common/compression/CompressionSelector.hpp"
+#include "common/compression/LZSSCompressor.hpp"
+#include "common/protocols/UDSDownloadEncoder.hpp"
+#include "common/SBL.hpp"
+#include "common/VBFParser.hpp"
+
+#include <easylogging++.h>
+INITIALIZE_EASYLOGGINGPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace common;
+
+namespace {
+
+VBF makeVBF(std::vector<uint8_t> data)
+{
+    std::vector<VBFChunk> chunks;
+    chunks.emplace_back(0, std::move(data));
+    return VBF{ {}, std::move(chunks) };
+}
+
+// Код из небольшого набора инструкций, таблицы и заливка 0xFF.
+std::vector<uint8_t> makeCodeImage(size_t size)
+{
+    std::mt19937 random{ 42 };
+    std::vector<uint8_t> image;
+    image.reserve(size);
+    while (image.size() < size) {
+        const auto kind = random() % 4;
+        const size_t length = 256 + random() % 4096;
+        for (size_t i = 0; i < length && image.size() < size; ++i) {
+            switch (kind) {
+            case 0:
+                image.push_back(0xFF);
+                break;
+            case 1:
+                image.push_back(static_cast<uint8_t>(i * 3 + length));
+                break;
+            default:
+                image.push_back(static_cast<uint8_t>((random() % 24) * 7));
+                break;
+            }
+        }
+    }
+    return image;
+}
+
+// Зашифрованная или уже сжатая прошивка: совпадений почти нет.
+std::vector<uint8_t> makeRandomImage(size_t size)
+{
+    std::mt19937 random{ 7 };
+    std::vector<uint8_t> image(size);
+    for (auto& byte : image) {
+        byte = static_cast<uint8_t>(random());
+    }
+    return image;
+}
+
+// Прошивка занимает начало флеша, остальное стёрто.
+std::vector<uint8_t> makePaddedImage(size_t size)
+{
+    auto image = makeCodeImage(size / 4);
+    image.resize(size, 0xFF);
+    return image;
+}
+
+VBF loadFile(const std::string& path)
+{
+    std::ifstream file{ path, std::ios_base::binary };
+    if (!file) {
+        throw std::runtime_error("Can't open " + path);
+    }
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".vbf") == 0) {
+        return VBFParser{}.parse(file);
+    }
+    return makeVBF({ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} });
+}
+
+double megabytesPerSecond(size_t bytes, std::chrono::microseconds time)
+{
+    return time.count() > 0 ? static_cast<double>(bytes) / static_cast<double>(time.count()) : 0.0;
+}
+
+void report(const std::string& name, const VBF& flash, unsigned long baudrate)
+{
+    static const std::vector<CompressionOption> options = {
+        { CompressionType::None, false },
+        { CompressionType::Bosch, false },
+        { CompressionType::LZSS, false },
+        { CompressionType::LZSS, true },
+    };
+
+    std::cout << name << std::endl;
+    std::vector<CompressionEstimate> estimates;
+    for (const auto& option : options) {
+        // Как и CompressionSelector::select, не справившийся метод пропускается.
+        CompressionEstimate estimate;
+        try {
+            estimate = CompressionSelector::estimate(option, flash, baudrate);
+        }
+        catch (const std::exception& ex) {
+            std::cout << "  " << std::left << std::setw(14) << toString(option) << std::right
+                      << "  failed: " << ex.what() << std::endl;
+            continue;
+        }
+        estimates.push_back(estimate);
+        std::cout << "  " << std::left << std::setw(14) << toString(option) << std::right
+                  << std::setw(10) << estimate.outputBytes << " bytes"
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(8) << static_cast<double>(estimate.outputBytes) / static_cast<double>(estimate.inputBytes)
+                  << std::setprecision(1)
+                  << std::setw(9) << megabytesPerSecond(estimate.inputBytes, estimate.compressTime) << " MB/s comp"
+                  << std::setw(9) << megabytesPerSecond(estimate.inputBytes, estimate.decompressTime) << " MB/s decomp"
+                  << std::setw(9) << estimate.transferTime.count() / 1000 << " ms CAN"
+                  << std::setw(9) << estimate.getTotalTime().count() / 1000 << " ms total" << std::endl;
+    }
+
+    // То же, что выбрал бы CompressionSelector::select для ЭБУ с этим методом.
+    for (const auto accepted : { CompressionType::Bosch, CompressionType::LZSS }) {
+        const CompressionEstimate* best = nullptr;
+        for (const auto& estimate : estimates) {
+            const auto type = estimate.option.type;
+            if ((type == CompressionType::None || type == accepted)
+                && (!best || estimate.getTotalTime() < best->getTotalTime())) {
+                best = &estimate;
+            }
+        }
+        std::cout << "  best for " << toString({ accepted }) << " ECU: " << toString(best->option) << std::endl;
+    }
+}
+
+template<typename Work>
+std::chrono::microseconds measure(Work work)
+{
+    const auto start = std::chrono::steady_clock::now();
+    work();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+}
+
+// Прежний поиск LZSS перебором всего окна - эталон для цепочек хешей.
+// Формат и разбор те же, что у жадного LZSSCompressor без ограничения глубины.
+std::vector<uint8_t> compressBruteForce(const std::vector<uint8_t>& input)
+{
+    constexpr size_t WindowSize = 4096;
+    constexpr size_t LookaheadBuffer = 18;
+    constexpr size_t MinMatchLength = 3;
+
+    std::vector<uint8_t> flags;
+    std::vector<uint8_t> data;
+    uint8_t currentFlag = 0;
+    size_t flagBit = 0;
+    for (size_t pos = 0; pos < input.size();) {
+        size_t bestOffset = 0;
+        size_t bestLength = 0;
+        const size_t maxLength = std::min(LookaheadBuffer, input.size() - pos);
+        for (size_t i = pos > WindowSize ? pos - WindowSize : 0; i < pos; ++i) {
+            size_t length = 0;
+            while (length < maxLength && input[i + length] == input[pos + length]) {
+                length++;
+            }
+            if (length > bestLength) {
+                bestOffset = pos - i;
+                bestLength = length;
+            }
+        }
+
+        if (bestLength >= MinMatchLength) {
+            currentFlag |= static_cast<uint8_t>(1 << (7 - flagBit));
+            const auto token = static_cast<uint16_t>(((bestOffset - 1) << 4) | (bestLength - MinMatchLength));
+            data.push_back(static_cast<uint8_t>(token >> 8));
+            data.push_back(static_cast<uint8_t>(token & 0xFF));
+            pos += bestLength;
+        } else {
+            data.push_back(input[pos]);
+            pos++;
+        }
+        flagBit = (flagBit + 1) % 8;
+        if (flagBit == 0) {
+            flags.push_back(currentFlag);
+            currentFlag = 0;
+        }
+    }
+    if (flagBit != 0) {
+        flags.push_back(currentFlag);
+    }
+
+    std::vector<uint8_t> output{ static_cast<uint8_t>(flags.size() >> 8), static_cast<uint8_t>(flags.size() & 0xFF) };
+    output.insert(output.end(), flags.begin(), flags.end());
+    output.insert(output.end(), data.begin(), data.end());
+    return output;
+}
+
+// Поиск совпадений LZSS по цепочкам хешей: полная глубина против урезанной и
+// против перебора окна. Перебор медленный, поэтому он и все глубины меряются
+// на первых 64 КБ прошивки.
+void reportChainDepth(const VBF& flash)
+{
+    constexpr size_t SampleSize = 0x10000;
+    std::vector<uint8_t> sample;
+    for (const auto& chunk : flash.chunks) {
+        const size_t size = std::min(chunk.data.size(), SampleSize - sample.size());
+        sample.insert(sample.end(), chunk.data.begin(), chunk.data.begin() + size);
+    }
+
+    std::vector<uint8_t> reference;
+    const auto referenceTime = measure([&] { reference = compressBruteForce(sample); });
+    const double referenceSpeed = megabytesPerSecond(sample.size(), referenceTime);
+    std::cout << "  LZSS " << std::left << std::setw(11) << "brute force"
+              << std::right << std::setw(13) << reference.size() << " bytes"
+              << std::fixed << std::setprecision(1)
+              << std::setw(9) << referenceSpeed << " MB/s comp"
+              << " (first " << sample.size() / 1024 << " KB)" << std::endl;
+
+    for (const size_t depth : { size_t{ 0 }, size_t{ 16 }, size_t{ 4 } }) {
+        LZSSCompressor compressor{ LZSSCompressor::Parsing::Greedy, depth };
+        std::vector<uint8_t> compressed;
+        const auto time = measure([&] { compressor.compressTo(sample, compressed); });
+        const double speed = megabytesPerSecond(sample.size(), time);
+        std::cout << "  LZSS depth " << std::left << std::setw(5) << (depth ? std::to_string(depth) : "full")
+                  << std::right << std::setw(13) << compressed.size() << " bytes"
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(9) << speed << " MB/s comp"
+                  << std::setw(9) << (referenceSpeed > 0 ? speed / referenceSpeed : 0.0) << "x brute force";
+        if (depth == 0 && compressed != reference) {
+            std::cout << ", output differs";
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Поиск повторений и сумма Bosch: SSE2, если собрано с ним, против побайтовых.
+void reportBoschScan(const VBF& flash)
+{
+    double bytewiseSpeed = 0.0;
+    for (const bool vectorized : { false, true }) {
+        BoschCompressor compressor{ vectorized };
+        std::vector<uint8_t> compressed;
+        size_t inputBytes = 0;
+        size_t outputBytes = 0;
+        const auto time = measure([&] {
+            for (const auto& chunk : flash.chunks) {
+                compressor.compressTo(chunk.data, compressed);
+                inputBytes += chunk.data.size();
+                outputBytes += compressed.size();
+            }
+        });
+        const double speed = megabytesPerSecond(inputBytes, time);
+        std::cout << "  Bosch " << std::left << std::setw(10) << (vectorized ? "vectorized" : "bytewise")
+                  << std::right << std::setw(13) << outputBytes << " bytes"
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(9) << speed << " MB/s comp";
+        if (vectorized) {
+            std::cout << std::setw(9) << (bytewiseSpeed > 0 ? speed / bytewiseSpeed : 0.0) << "x bytewise";
+        }
+        else {
+            bytewiseSpeed = speed;
+        }
+        std::cout << std::endl;
+    }
+}
+
+// Подготовка чанков UDSDownloadEncoder: один рабочий поток против всех ядер.
+void reportEncoderWorkers()
+{
+    std::vector<VBFChunk> chunks;
+    for (uint32_t i = 0; i < 8; ++i) {
+        chunks.emplace_back(0x20000 * i, makeCodeImage(0x20000));
+    }
+    const VBF flash{ {}, std::move(chunks) };
+    std::cout << "UDSDownloadEncoder 8 x 128 KB, optimal LZSS + XOR" << std::endl;
+    for (const size_t workers : { size_t{ 1 }, size_t{ 0 } }) {
+        UDSDownloadEncoder encoder{ CompressionType::LZSS, EncryptionType::XOR, { { "key", "secret" } }, true, workers };
+        const auto time = measure([&] {
+            encoder.start(flash);
+            for (const auto& chunk : flash.chunks) {
+                encoder.get(chunk);
+            }
+        });
+        std::cout << "  " << std::left << std::setw(14) << (workers ? "1 worker" : "all cores") << std::right
+                  << std::setw(9) << time.count() / 1000 << " ms" << std::endl;
+    }
+}
+
+} // namespace
+
+int main(int argc, const char* argv[])
+{
+    unsigned long baudrate = 500000;
+    std::vector<std::pair<std::string, VBF>> corpus = {
+        { "P1 ME9 SBL", makeVBF(SBLData::P1_ME9_SBL) },
+        { "P2 ME7 data", makeVBF(SBLData::P2_ME7_DATA) },
+        { "P3 3.2 SBL", makeVBF(SBLData::P3_3_2_SBL) },
+        { "P3 ME9 SBL", makeVBF(SBLData::P3_ME9_SBL) },
+        { "synthetic code 1 MB", makeVBF(makeCodeImage(0x100000)) },
+        { "synthetic padded 2 MB", makeVBF(makePaddedImage(0x200000)) },
+        { "0xFF fill 2 MB", makeVBF(std::vector<uint8_t>(0x200000, 0xFF)) },
+        { "random 1 MB", makeVBF(makeRandomImage(0x100000)) },
+    };
+    try {
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], "--baudrate") == 0 && i + 1 < argc) {
+                baudrate = std::stoul(argv[++i]);
+            } else {
+                corpus.emplace_back(argv[i], loadFile(argv[i]));
+            }
+        }
+        std::cout << "CAN " << baudrate << " bit/s, ISO-TP 7 bytes per frame" << std::endl;
+        for (const auto& [name, flash] : corpus) {
+            report(name, flash, baudrate);
+            reportChainDepth(flash);
+            reportBoschScan(flash);
+        }
+        reportEncoderWorkers();
+    }
+    catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
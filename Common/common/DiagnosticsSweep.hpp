@@ -0,0 +1,74 @@
+#pragma once
+
+#include "CarPlatform.hpp"
+#include "ConfigurationInfo.hpp"
+#include "ECUInfo.hpp"
+#include "ProtocolType.hpp"
+#include "protocols/UDSTiming.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace common {
+
+class ICanChannel;
+
+struct DiagnosticRequest {
+    std::string name;
+    std::vector<uint8_t> data;
+};
+
+struct DiagnosticResult {
+    std::string name;
+    // UDS: ответ без SID, D2: ответ без эха requestId.
+    std::vector<uint8_t> response;
+    // Пусто, если получен положительный ответ.
+    std::string error;
+};
+
+struct EcuDiagnostics {
+    ECUInfo ecu;
+    std::string busName;
+    ProtocolType protocol;
+    std::vector<DiagnosticResult> results;
+};
+
+struct DiagnosticsSweepConfig {
+    std::vector<DiagnosticRequest> udsRequests{
+        { "Spare part number", { 0x22, 0xF1, 0x87 } },
+        { "Software version", { 0x22, 0xF1, 0x89 } },
+        { "Serial number", { 0x22, 0xF1, 0x8C } },
+        { "DTC", { 0x19, 0x02, 0xFF } },
+    };
+    std::vector<DiagnosticRequest> d2Requests{
+        { "Part numbers", { 0xB9, 0xF0 } },
+        { "DTC", { 0xAE, 0x14 } },
+    };
+    UDSTiming udsTiming;
+    std::chrono::milliseconds d2Timeout{ 1000 };
+};
+
+// Опрос всех ЭБУ платформы из встроенной конфигурации. Запросы к разным ЭБУ
+// идут одновременно: каждому ЭБУ отправляется следующий запрос, как только
+// он ответил на предыдущий, а ответы разбираются по CAN id (UDS) или по
+// ecuId первого кадра и CAN id серии (D2). Поэтому опрос всей машины длится
+// примерно как опрос самого медленного ЭБУ. Всё выполняется в вызывающем
+// потоке: каналы J2534 нельзя передавать между потоками.
+class DiagnosticsSweep {
+public:
+    DiagnosticsSweep(ConfigurationInfo configuration, DiagnosticsSweepConfig config = {});
+    explicit DiagnosticsSweep(CarPlatform carPlatform, DiagnosticsSweepConfig config = {});
+
+    // channels - по одному каналу на шину в порядке busInfo
+    // (J2534ChannelProvider::getAllChannels). Шины без канала и TP20 пропускаются.
+    std::vector<EcuDiagnostics> run(const std::vector<std::unique_ptr<ICanChannel>>& channels) const;
+
+private:
+    const ConfigurationInfo _configuration;
+    const DiagnosticsSweepConfig _config;
+};
+
+} // namespace common
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+namespace common {
+
+// Выдерживает минимальный интервал между кадрами, который назначил ЭБУ.
+// Дедлайн следующего кадра считается по монотонным часам от момента отправки
+// предыдущего. sleep_for просыпается на десятки микросекунд - миллисекунды
+// позже, поэтому до дедлайна поток спит с запасом, а остаток докручивает.
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+    using NowFunction = std::function<Clock::time_point()>;
+
+    // frameTime - время передачи одного кадра на шине. Если интервал не больше
+    // его, кадры и так разойдутся на шине, и готовые уходят одной пачкой.
+    // now - источник времени, тесты подставляют свои часы.
+    explicit FramePacer(std::chrono::microseconds interval = {}, std::chrono::microseconds frameTime = {},
+                        NowFunction now = Clock::now);
+
+    void setInterval(std::chrono::microseconds interval);
+    std::chrono::microseconds getInterval() const;
+
+    // Ждёт дедлайна следующего кадра. Возвращает, сколько из count готовых
+    // кадров можно отправить одним send.
+    size_t wait(size_t count = 1);
+    // Вызывается после отправки: следующий дедлайн через интервал.
+    void sent();
+    // Когда можно отправить следующий кадр, для циклов событий без сна.
+    Clock::time_point getDeadline() const;
+    // С таким запасом поток засыпает до дедлайна: он перекрывает опоздание
+    // пробуждения и на Linux, и на Windows с таймером 1 мс. Остаток wait()
+    // докручивает без сна.
+    static constexpr std::chrono::microseconds SleepMargin{ 2000 };
+
+    // Время передачи кадра CAN с 8 байтами данных на скорости baudrate.
+    static std::chrono::microseconds frameTimeForBaudrate(unsigned long baudrate);
+
+private:
+    std::chrono::microseconds _interval;
+    const std::chrono::microseconds _frameTime;
+    const NowFunction _now;
+    Clock::time_point _next;
+};
+
+} // namespace common
@@ -2,6 +2,7 @@
 
 #include "CanFrame.hpp"
 
+#include <span>
 #include <vector>
 
 namespace common {
@@ -12,6 +13,15 @@ public:
 
     virtual bool send(const CanFrame& frame, unsigned long timeout = 1000) = 0;
     virtual bool send(const std::vector<CanFrame>& frames, unsigned long timeout = 1000) = 0;
+    // Кадр собирается из заголовка и данных прямо в буфере транспорта.
+    // По умолчанию склеивается в CanFrame.
+    virtual bool send(uint32_t id, std::span<const uint8_t> header, std::span<const uint8_t> payload,
+                      unsigned long timeout = 1000)
+    {
+        CanFrame frame{ id, { header.begin(), header.end() } };
+        frame.data.insert(frame.data.end(), payload.begin(), payload.end());
+        return send(frame, timeout);
+    }
 
     virtual bool receive(CanFrame& frame, unsigned long timeout) = 0;
     virtual bool receive(std::vector<CanFrame>& frames, size_t messagesCount, unsigned long timeout) = 0;
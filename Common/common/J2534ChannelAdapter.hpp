@@ -17,6 +17,8 @@ public:
 
     bool send(const CanFrame& frame, unsigned long timeout = 1000) override;
     bool send(const std::vector<CanFrame>& frames, unsigned long timeout = 1000) override;
+    bool send(uint32_t id, std::span<const uint8_t> header, std::span<const uint8_t> payload,
+              unsigned long timeout = 1000) override;
 
     bool receive(CanFrame& frame, unsigned long timeout) override;
     bool receive(std::vector<CanFrame>& frames, size_t messagesCount, unsigned long timeout) override;
@@ -26,6 +26,9 @@ public:
     j2534::J2534& getJ2534() const;
     std::vector<std::unique_ptr<ICanChannel>> getAllChannels(uint32_t ecuId = 0) const;
     std::unique_ptr<ICanChannel> getChannelForEcu(uint32_t ecuId) const;
+    // CAN канал шины ЭБУ без транспортного уровня и без фильтров: кадры,
+    // которые идут мимо ISO-TP, вызывающий пропускает своими фильтрами.
+    std::unique_ptr<ICanChannel> getRawChannelForEcu(uint32_t ecuId) const;
 
 private:
     j2534::J2534& _j2534;
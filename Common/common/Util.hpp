@@ -12,8 +12,6 @@
 #include <type_traits>
 #include <ios>
 
-class ICanChannel;
-
 namespace j2534 {
     class J2534;
     class J2534Channel;
@@ -21,6 +19,8 @@ namespace j2534 {
 
 namespace common {
 
+    class ICanChannel;
+
     std::wstring toWstring(const std::string& str);
     std::string toString(const std::wstring& str);
 
@@ -54,6 +54,8 @@ namespace common {
         openUDSChannel(j2534::J2534& j2534, unsigned long Baudrate, uint32_t canId = 0);
 
     bool prepareUDSChannel(j2534::J2534Channel& channel, uint32_t canId);
+    // Добавляет в уже открытый ISO15765 канал flow control фильтр ещё одного ЭБУ.
+    bool prepareUDSChannel(ICanChannel& channel, uint32_t canId);
     bool prepareTP20Channel(j2534::J2534Channel& channel, uint32_t canId);
 
     std::unique_ptr<j2534::J2534Channel>
@@ -99,10 +101,14 @@ namespace common {
     CarPlatform parseCarPlatform(std::string input);
 
     std::array<uint8_t, 5> getPinArray(uint64_t pin);
+    uint64_t getPinFromArray(const std::array<uint8_t, 5>& pin);
 
     void initLogger(const std::string& logFilename, bool enableConsole = false, bool debugMode = false);
 
-    uint16_t crc16(const uint8_t* data_p, size_t length);
+    // crc - значение после предыдущей порции данных, для счёта по частям.
+    uint16_t crc16(const uint8_t* data_p, size_t length, uint16_t crc = 0xFFFF);
+    // CRC-32 (IEEE 802.3, как в zlib), по 8 байт за шаг.
+    uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0);
 
     template<typename T>
     std::string dumpArray(const T& vec)
@@ -6,8 +6,15 @@ namespace common {
 
 class BoschCompressor: public CompressorBase {
 public:
-    virtual std::vector<uint8_t> compress(const std::vector<uint8_t>& input) override;
-    virtual std::vector<uint8_t> decompress(const std::vector<uint8_t>& input) override;
+    // vectorized = false - побайтовый поиск повторений и подсчёт суммы даже там,
+    // где есть SSE2. Результат тот же, нужен для сравнения скорости.
+    explicit BoschCompressor(bool vectorized = true);
+
+    virtual void compressTo(std::span<const uint8_t> input, std::vector<uint8_t>& output) override;
+    virtual void decompressTo(std::span<const uint8_t> input, std::vector<uint8_t>& output) override;
+
+private:
+    const bool _vectorized;
 };
 
 } // namespace common
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "CompressionType.hpp"
+
+#include "common/VBF.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace common {
+
+// Вариант подготовки прошивки: метод сжатия и его настройка.
+struct CompressionOption {
+    CompressionType type{ CompressionType::None };
+    // Только для LZSS: оптимальный разбор вместо жадного.
+    bool optimalParsing{ false };
+};
+
+// Название варианта для логов и отчётов: "none", "bosch", "lzss", "lzss-optimal".
+std::string toString(const CompressionOption& option);
+
+struct CompressionEstimate {
+    CompressionOption option;
+    size_t inputBytes{ 0 };
+    size_t outputBytes{ 0 };
+    std::chrono::microseconds compressTime{ 0 };
+    std::chrono::microseconds decompressTime{ 0 };
+    std::chrono::microseconds transferTime{ 0 };
+
+    // Сжатие плюс передача. Сжатие отчасти идёт параллельно с передачей,
+    // так что это оценка сверху.
+    std::chrono::microseconds getTotalTime() const;
+};
+
+// Оценка вариантов сжатия на конкретной прошивке и выбор самого быстрого от
+// начала подготовки до конца передачи. ЭБУ принимает данные как есть или
+// сжатые своим методом (ECUInfo), из них и выбирается.
+class CompressionSelector {
+public:
+    // Варианты, которые можно отправить ЭБУ с методом accepted, включая несжатый.
+    static std::vector<CompressionOption> getOptions(CompressionType accepted);
+
+    // Сжимает и распаковывает все чанки flash, время передачи считается по
+    // числу кадров ISO-TP на скорости baudrate.
+    static CompressionEstimate estimate(const CompressionOption& option, const VBF& flash, unsigned long baudrate);
+
+    // Оценивает все варианты для accepted и возвращает самый быстрый. Варианты,
+    // на которых estimate бросает исключение, пропускаются.
+    static CompressionEstimate select(CompressionType accepted, const VBF& flash, unsigned long baudrate);
+
+    // Время передачи bytes байт в последовательных кадрах ISO-TP по 7 байт.
+    static std::chrono::microseconds estimateTransferTime(size_t bytes, unsigned long baudrate);
+};
+
+} // namespace common
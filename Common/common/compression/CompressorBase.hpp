@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cinttypes>
+#include <span>
 #include <vector>
 
 namespace common {
@@ -8,8 +9,14 @@ namespace common {
 class CompressorBase {
 public:
     virtual ~CompressorBase() = default;
-    virtual std::vector<uint8_t> compress(const std::vector<uint8_t>& input) = 0;
-    virtual std::vector<uint8_t> decompress(const std::vector<uint8_t>& input) = 0;
+
+    // Результат заменяет содержимое output, его память переиспользуется:
+    // если сжимать чанки в один буфер, он выделяется один раз.
+    virtual void compressTo(std::span<const uint8_t> input, std::vector<uint8_t>& output) = 0;
+    virtual void decompressTo(std::span<const uint8_t> input, std::vector<uint8_t>& output) = 0;
+
+    std::vector<uint8_t> compress(const std::vector<uint8_t>& input);
+    std::vector<uint8_t> decompress(const std::vector<uint8_t>& input);
 };
 
 } // namespace common
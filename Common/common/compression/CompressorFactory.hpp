@@ -10,7 +10,8 @@ class CompressorBase;
 
 class CompressorFactory {
 public:
-    static std::unique_ptr<CompressorBase> create(CompressionType compressionType);
+    // optimalParsing - для LZSS разбор с минимальным размером вместо жадного.
+    static std::unique_ptr<CompressorBase> create(CompressionType compressionType, bool optimalParsing = false);
 };
 
 } // namespace common
@@ -2,12 +2,47 @@
 
 #include "CompressorBase.hpp"
 
+#include <cstddef>
+#include <cstdint>
+
 namespace common {
 
 class LZSSCompressor: public CompressorBase {
 public:
-    virtual std::vector<uint8_t> compress(const std::vector<uint8_t>& input) override;
-    virtual std::vector<uint8_t> decompress(const std::vector<uint8_t>& input) override;
+    enum class Parsing {
+        // Самое длинное совпадение на каждой позиции.
+        Greedy,
+        // Минимум байт на выходе при том же формате, дороже по CPU и памяти.
+        Optimal
+    };
+
+    // Размеры всего, что сжал этот компрессор.
+    struct Stats {
+        size_t inputBytes{ 0 };
+        // Сколько дал бы жадный разбор тех же данных.
+        size_t greedyBytes{ 0 };
+        size_t outputBytes{ 0 };
+    };
+
+    // maxChainDepth - сколько кандидатов с тем же хешем проверять на каждой
+    // позиции. 0 - все в окне, результат совпадает с полным перебором окна.
+    explicit LZSSCompressor(Parsing parsing = Parsing::Greedy, size_t maxChainDepth = 0);
+
+    const Stats& getStats() const;
+
+    virtual void compressTo(std::span<const uint8_t> input, std::vector<uint8_t>& output) override;
+    virtual void decompressTo(std::span<const uint8_t> input, std::vector<uint8_t>& output) override;
+
+private:
+    const Parsing _parsing;
+    const size_t _maxChainDepth;
+    Stats _stats;
+    // Таблицы поиска совпадений, флаги и данные переиспользуются между вызовами.
+    std::vector<uint32_t> _head;
+    std::vector<uint32_t> _tail;
+    std::vector<uint32_t> _next;
+    std::vector<uint8_t> _flags;
+    std::vector<uint8_t> _data;
 };
 
 } // namespace common
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "common/CanFrame.hpp"
 #include "common/VBF.hpp"
 
 #include <functional>
@@ -8,6 +9,19 @@
 namespace common {
     class ICanChannel;
 
+    // Заранее подготовленные кадры записи VBF: пачки кадров 0xA8 и контрольные
+    // суммы по каждому чанку. Строится без обращения к каналу, поэтому может
+    // готовиться в фоне, пока идёт запись другого ЭБУ.
+    struct D2TransferPlan {
+        struct Chunk {
+            uint32_t writeOffset;
+            uint32_t endOffset;
+            uint8_t checksum;
+            std::vector<std::vector<CanFrame>> batches;
+        };
+        std::vector<Chunk> chunks;
+    };
+
 	class D2ProtocolCommonSteps {
 	public:
 		static bool fallAsleep(const std::vector<std::unique_ptr<ICanChannel>>& channels);
@@ -15,6 +29,9 @@ namespace common {
 		static void wakeUp(const std::vector<std::unique_ptr<ICanChannel>>& channels);
         static bool transferData(ICanChannel& channel, uint8_t ecuId, const VBF& data,
                                  const std::function<void(size_t)>& progressCallback);
+        static D2TransferPlan planTransfer(uint8_t ecuId, const VBF& data);
+        static bool transferData(ICanChannel& channel, uint8_t ecuId, const D2TransferPlan& plan,
+                                 const std::function<void(size_t)>& progressCallback);
         static bool eraseFlash(ICanChannel& channel, uint8_t ecuId, const VBF& data);
         static void jumpTo(ICanChannel& channel, uint8_t ecuId, uint32_t addr);
         static bool startRoutine(ICanChannel& channel, uint8_t ecuId, uint32_t addr);
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "D2Message.hpp"
+#include "D2ResponseParser.hpp"
 
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <vector>
 
 
@@ -16,8 +18,15 @@ public:
     explicit D2Request(D2Message message);
 
     std::vector<uint8_t> process(ICanChannel& channel, size_t timeout = 1000, size_t sendMessagesDelay = 0) const;
+    // Пишет данные ответа прямо в output и возвращает его заполненную часть.
+    // Данные сверх размера output отбрасываются.
+    std::span<const uint8_t> process(ICanChannel& channel, std::span<uint8_t> output,
+                                     size_t timeout = 1000, size_t sendMessagesDelay = 0) const;
 
 private:
+    void sendRequest(ICanChannel& channel, size_t timeout, size_t sendMessagesDelay) const;
+    void receiveResponse(ICanChannel& channel, D2ResponseParser& parser, size_t timeout) const;
+
     D2Message _message;
 };
 
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace common {
+
+struct CanFrame;
+
+// Потоковый разборщик ответа D2. Кадры подаются по одному через feed(),
+// полезные данные (без эха requestId) сразу пишутся в выходной буфер -
+// либо в переданный вызывающим span, либо в конец заранее зарезервированного
+// вектора. Эхо проверяется на лету и никуда не копируется.
+class D2ResponseParser {
+public:
+    enum class Status {
+        Skipped,    // чужой кадр, ожидаем первый кадр ответа
+        NeedMore,   // ответ ещё не закончен
+        Complete    // последний кадр ответа получен
+    };
+
+    // Данные сверх размера output отбрасываются, разбор кадров продолжается.
+    D2ResponseParser(uint8_t ecuId, const std::vector<uint8_t>& requestId, std::span<uint8_t> output);
+    // output очищается, ёмкость сохраняется.
+    D2ResponseParser(uint8_t ecuId, const std::vector<uint8_t>& requestId, std::vector<uint8_t>& output);
+
+    Status feed(const CanFrame& frame);
+
+    size_t size() const { return _outputSize; }
+    bool isTruncated() const { return _truncated; }
+    std::span<const uint8_t> data() const;
+
+private:
+    enum class ParseState { WaitFirst, WaitSeries };
+
+    bool consume(const uint8_t* data, size_t size);
+    void reset();
+
+    const uint8_t _ecuId;
+    const std::vector<uint8_t>& _requestId;
+    std::span<uint8_t> _output;
+    std::vector<uint8_t>* _outputVector{ nullptr };
+
+    ParseState _state{ ParseState::WaitFirst };
+    bool _isError{ false };
+    uint8_t _errorCode{ 0 };
+    size_t _echoRegionSize{ 0 };
+    size_t _streamSize{ 0 };
+    size_t _outputSize{ 0 };
+    bool _truncated{ false };
+    uint8_t _expectedSeriesId{ 0x09 };
+    size_t _frameCount{ 0 };
+};
+
+} // namespace common
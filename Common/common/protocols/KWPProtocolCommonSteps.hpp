@@ -15,10 +15,24 @@ namespace common {
 		static bool transferData(const RequestProcessorBase& requestProcessor, const VBF& data,
                                  const std::function<void(size_t)>& progressCallback);
 		static bool eraseFlash(const RequestProcessorBase& requestProcessor, const VBF& data);
-		static size_t requestDownload(const RequestProcessorBase& requestProcessor, const VBFChunk& data);
+		// Формат данных запроса 0x34: старшая тетрада - метод сжатия, младшая - шифрования.
+		static constexpr uint8_t DownloadDataFormat = 0x11;
+		static constexpr uint8_t PlainDataFormat = 0x00;
+
+		static size_t requestDownload(const RequestProcessorBase& requestProcessor, const VBFChunk& data,
+			uint8_t dataFormat = DownloadDataFormat);
 		static bool eraseFlash(const RequestProcessorBase& requestProcessor, const VBFChunk& data);
+		// Передаёт данные блока как есть.
 		static bool transferData(const RequestProcessorBase& requestProcessor, const VBFChunk& data, size_t maxSizeToTransfer,
 			const std::function<void(size_t)>& progressCallback);
+		// Передаёт encoded - данные блока в формате, объявленном в requestDownload.
+		// ЭБУ считает контрольную сумму по записанному образу, поэтому CRC-32
+		// берётся по исходным данным chunk, а прогресс - в байтах образа.
+		static bool transferData(const RequestProcessorBase& requestProcessor, const VBFChunk& chunk,
+			const std::vector<uint8_t>& encoded, size_t maxSizeToTransfer,
+			const std::function<void(size_t)>& progressCallback);
+		// Сравнивает crc (CRC-32 данных блока) с контрольной суммой, которую посчитал ЭБУ.
+		static bool checkMemory(const RequestProcessorBase& requestProcessor, const VBFChunk& chunk, uint32_t crc);
 
 		static bool startRoutine(const RequestProcessorBase& requestProcessor, uint32_t addr);
 	};
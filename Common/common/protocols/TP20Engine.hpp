@@ -0,0 +1,122 @@
+#pragma once
+
+#include "common/CanFrame.hpp"
+#include "common/CarPlatform.hpp"
+#include "common/FramePacer.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <vector>
+
+namespace common {
+
+class ICanChannel;
+
+// Несколько каналов TP20 к разным ЭБУ VAG поверх одного CAN канала.
+// Движок однопоточный и ничего не ждёт сам: poll() принимает один кадр или
+// срабатывание таймера и продвигает состояние того канала TP20, которому
+// событие адресовано (установка канала, отправка блока, ожидание ACK, сборка
+// ответа). Кадры разбираются по CAN id, у каждого канала TP20 свой id приёма.
+// Каналы J2534 привязаны к потоку, поэтому poll() вызывается из потока,
+// открывшего CAN канал. Keep-alive (0xA3) каждого канала шлёт адаптер
+// периодическим сообщением, так что между запросами poll() звать не нужно.
+class TP20Engine {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TP20Engine(ICanChannel& channel);
+    ~TP20Engine();
+
+    TP20Engine(const TP20Engine&) = delete;
+    TP20Engine& operator=(const TP20Engine&) = delete;
+
+    // Начинает установку канала TP20 к ЭБУ, возвращает номер канала.
+    size_t open(CarPlatform carPlatform, uint8_t ecuId);
+    void close(size_t channel);
+
+    // Сообщение уходит по мере событий. Буфер не копируется и должен жить,
+    // пока isSending() не вернёт false.
+    bool write(size_t channel, std::span<const uint8_t> message);
+
+    bool isConnecting(size_t channel) const;
+    bool isConnected(size_t channel) const;
+    bool isSending(size_t channel) const;
+
+    bool hasMessage(size_t channel) const;
+    std::vector<uint8_t> takeMessage(size_t channel);
+
+    // Отправляет всё, что можно, и ждёт следующего события не дольше timeout.
+    void poll(std::chrono::milliseconds timeout);
+
+    // Параметр времени из SetupChannelParameters (например, минимальный
+    // интервал между кадрами).
+    static std::chrono::microseconds decodeTimingParameter(uint8_t parameter);
+
+private:
+    enum class State {
+        Setup,
+        Parameters,
+        Open,
+        Closed
+    };
+
+    struct Channel {
+        Channel(uint8_t ecuId, uint32_t ecuCanId, uint32_t rxId, std::chrono::microseconds frameTime);
+
+        const uint8_t ecuId;
+        const uint32_t ecuCanId;
+        const uint32_t rxId;
+        uint32_t txId{ 0 };
+        State state{ State::Setup };
+        // Когда перестать ждать установки канала или ACK.
+        Clock::time_point deadline;
+        FramePacer pacer;
+        // Фильтры J2534: ответ на установку канала приходит с CAN id ЭБУ,
+        // данные - с id приёма канала.
+        unsigned long setupFilterId{ 0 };
+        unsigned long filterId{ 0 };
+        unsigned long keepAliveId{ 0 };
+        bool setupFilter{ false };
+        bool filter{ false };
+        bool keepAlive{ false };
+
+        std::span<const uint8_t> message;
+        size_t offset{ 0 };
+        uint8_t blockSize{ 1 };
+        uint8_t packetsTillAck{ 1 };
+        uint8_t sendCounter{ 0 };
+        bool waitingAck{ false };
+
+        std::vector<uint8_t> received;
+        size_t responseSize{ 0 };
+        bool receiving{ false };
+        std::deque<std::vector<uint8_t>> messages;
+    };
+
+    void onTimer(Channel& channel, Clock::time_point now);
+    void onFrame(const CanFrame& frame);
+    void onSetupResponse(Channel& channel, const CanFrame& frame);
+    void onParametersResponse(Channel& channel, const CanFrame& frame);
+    void onDataFrame(Channel& channel, const CanFrame& frame);
+    void sendBlock(Channel& channel);
+    bool sendAck(Channel& channel, uint8_t counter);
+    void fail(Channel& channel, const char* reason);
+    bool startPassFilter(uint32_t canId, unsigned long& filterId);
+
+    std::vector<CanFrame>& takeFrames(size_t count);
+    static size_t remainingFrames(const Channel& channel);
+    static void fillFrame(Channel& channel, CanFrame& frame);
+
+    ICanChannel& _channel;
+    const std::chrono::microseconds _frameTime;
+    std::vector<Channel> _channels;
+    // Кадры пачки не удаляются, а откладываются в запас: буферы данных
+    // выделяются только для первых пачек.
+    std::vector<CanFrame> _frames;
+    std::vector<CanFrame> _spareFrames;
+    CanFrame _rxFrame;
+};
+
+} // namespace common
@@ -3,15 +3,22 @@
 #include "common/CarPlatform.hpp"
 
 #include <chrono>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace common {
     class ICanChannel;
+    class TP20Engine;
     class TP20Request;
 
+    // Блокирующий канал TP20 к одному ЭБУ. Сессии, созданные на общем
+    // TP20Engine, работают через один CAN канал: пока одна ждёт ответа,
+    // движок обслуживает ACK и ответы остальных.
     class TP20Session {
     public:
         TP20Session(ICanChannel& channel, CarPlatform carPlatform, uint8_t ecuId);
+        TP20Session(TP20Engine& engine, CarPlatform carPlatform, uint8_t ecuId);
         ~TP20Session();
 
         bool start();
@@ -22,8 +29,17 @@ namespace common {
         bool writeMessage(const std::vector<uint8_t>& request) const;
         std::vector<uint8_t> readMessage(size_t timeout = 1000) const;
 
+        // Параметр времени из SetupChannelParameters (например, минимальный
+        // интервал между кадрами).
+        static std::chrono::microseconds decodeTimingParameter(uint8_t parameter);
+
     private:
-        std::unique_ptr<class TP20SessionImpl> _impl;
+        std::unique_ptr<TP20Engine> _ownEngine;
+        TP20Engine& _engine;
+        const CarPlatform _carPlatform;
+        const uint8_t _ecuId;
+        size_t _channel;
+        bool _started;
     };
 
 } // namespace common
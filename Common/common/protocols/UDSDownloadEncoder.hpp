@@ -0,0 +1,72 @@
+#pragma once
+
+#include "common/VBF.hpp"
+#include "common/compression/CompressionType.hpp"
+#include "common/encryption/EncryptionType.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace common {
+
+// Подготовка чанков к загрузке в ЭБУ, который принимает сжатые и/или
+// зашифрованные данные. Чанки сжимаются, затем шифруются на нескольких рабочих
+// потоках, каждый со своими компрессором и шифратором. Потоки берут чанки по
+// порядку и уходят вперёд не больше чем на readyAhead чанков от последнего
+// запрошенного, так что передача первого начинается сразу, а готовые, но ещё
+// не нужные данные не копятся. Сжатие LZSS идёт на весь чанк, поэтому делить
+// работу мельче чанка формат не позволяет.
+// В RequestDownload (0x34) формат объявляется dataFormatIdentifier: старшая
+// тетрада - метод сжатия, младшая - метод шифрования (0 - без изменений).
+// С optimalCompression LZSS сжимает оптимальным разбором в том же формате,
+// а после подготовки всех чанков в лог пишется выигрыш против жадного.
+class UDSDownloadEncoder {
+public:
+    // workers - число рабочих потоков, 0 - по числу ядер.
+    UDSDownloadEncoder(CompressionType compressionType, EncryptionType encryptionType,
+                       std::map<std::string, std::string>&& encryptionParams = {},
+                       bool optimalCompression = false, size_t workers = 0);
+    ~UDSDownloadEncoder();
+
+    uint8_t getDataFormatIdentifier() const;
+
+    // Запускает подготовку всех чанков data. data должен жить, пока идёт загрузка.
+    void start(const VBF& data);
+    // Ждёт готовности чанка из запущенного VBF. Для чужого чанка бросает исключение.
+    const std::vector<uint8_t>& get(const VBFChunk& chunk);
+
+private:
+    void encodeChunks();
+    void stop();
+    void reportCompression(size_t inputBytes, size_t greedyBytes, size_t outputBytes) const;
+
+    const CompressionType _compressionType;
+    const EncryptionType _encryptionType;
+    const std::map<std::string, std::string> _encryptionParams;
+    const bool _optimalCompression;
+    const size_t _workerCount;
+    const size_t _readyAhead;
+    uint8_t _dataFormatIdentifier{ 0 };
+
+    const VBF* _data{ nullptr };
+    std::vector<std::promise<std::vector<uint8_t>>> _promises;
+    std::vector<std::shared_future<std::vector<uint8_t>>> _encoded;
+    std::vector<std::future<void>> _workers;
+
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    size_t _nextChunk{ 0 };
+    size_t _requested{ 0 };
+    size_t _activeWorkers{ 0 };
+    bool _stopping{ false };
+    size_t _inputBytes{ 0 };
+    size_t _greedyBytes{ 0 };
+    size_t _outputBytes{ 0 };
+};
+
+} // namespace common
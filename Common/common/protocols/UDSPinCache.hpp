@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+
+namespace common {
+
+// PIN, с которым ЭБУ последний раз пустил SecurityAccess, по VIN машины и
+// физическому CAN id ЭБУ. Общий на процесс, можно сохранить в файл и
+// загрузить при следующем запуске. Строки файла: "VIN canId pin" в hex.
+// Без VIN PIN не запоминается и не ищется: CAN id у разных машин совпадают.
+class UDSPinCache {
+public:
+    static std::optional<uint64_t> find(const std::string& vin, uint32_t canId);
+    static void store(const std::string& vin, uint32_t canId, uint64_t pin);
+    static void erase(const std::string& vin, uint32_t canId);
+    static void clear();
+
+    static void load(std::istream& input);
+    static void save(std::ostream& output);
+};
+
+} // namespace common
@@ -1,12 +1,15 @@
 #pragma once
 
 #include "common/VBF.hpp"
+#include "common/protocols/UDSTiming.hpp"
 
 #include <functional>
 #include <memory>
+#include <string>
 
 namespace common {
     class ICanChannel;
+    class UDSDownloadEncoder;
 
 	class UDSProtocolCommonSteps {
 	public:
@@ -16,15 +19,28 @@ namespace common {
                                                      uint32_t funcCanId);
 		static void wakeUp(const std::vector<std::unique_ptr<ICanChannel>>& channels,
                             uint32_t funcCanId);
+		// Повторно запрашивает текущую сессию физическим 0x10, чтобы узнать P2/P2* ЭБУ.
+		static UDSTiming readSessionTiming(ICanChannel& channel, uint32_t canId, uint8_t session);
+		// Нулевой seed - ЭБУ уже разблокирован в этой сессии, ключ не отправляется.
 		static bool authorize(ICanChannel& channel, uint32_t canId, const std::array<uint8_t, 5>& pin);
+		// VIN из 0x22 F190, пустая строка, если ЭБУ его не отдал.
+		static std::string readVin(ICanChannel& channel, uint32_t canId);
+        // С encoder данные передаются сжатыми/зашифрованными. transferData сам
+        // запускает их подготовку, для transferChunk encoder должен быть уже запущен
+        // на VBF, которому принадлежит чанк.
         static bool transferData(ICanChannel& channel, uint32_t canId, const VBF& data,
-                                 const std::function<void(size_t)>& progressCallback);
+                                 const std::function<void(size_t)>& progressCallback,
+                                 const UDSTiming& timing = {}, UDSDownloadEncoder* encoder = nullptr);
         static bool transferChunk(ICanChannel& channel, uint32_t canId, const VBFChunk& chunk,
-                                 const std::function<void(size_t)>& progressCallback);
-        static bool eraseFlash(ICanChannel& channel, uint32_t canId, const VBF& data);
-        static bool eraseChunk(ICanChannel& channel, uint32_t canId, const VBFChunk& chunk);
-        static bool startRoutine(ICanChannel& channel, uint32_t canId, uint32_t addr);
-        static bool checkValidApplication(ICanChannel& channel, uint32_t canId);
+                                 const std::function<void(size_t)>& progressCallback,
+                                 const UDSTiming& timing = {}, UDSDownloadEncoder* encoder = nullptr);
+        // Стирание ждёт ответа ЭБУ, а не фиксированное время: ожидаемая длительность
+        // считается по размеру чанка и ранее замеренной скорости стирания ЭБУ.
+        static bool eraseFlash(ICanChannel& channel, uint32_t canId, const VBF& data, const UDSTiming& timing = {});
+        static bool eraseChunk(ICanChannel& channel, uint32_t canId, const VBFChunk& chunk,
+                               const UDSTiming& timing = {});
+        static bool startRoutine(ICanChannel& channel, uint32_t canId, uint32_t addr, const UDSTiming& timing = {});
+        static bool checkValidApplication(ICanChannel& channel, uint32_t canId, const UDSTiming& timing = {});
 	};
 
 } // namespace common
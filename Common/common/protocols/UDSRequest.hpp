@@ -1,5 +1,7 @@
 #pragma once
 
+#include "common/protocols/UDSTiming.hpp"
+
 #include <cstdint>
 #include <vector>
 
@@ -8,17 +10,21 @@ class ICanChannel;
 
 class UDSRequest {
 public:
-    UDSRequest(uint32_t canId, const std::vector<uint8_t>& data);
-    UDSRequest(uint32_t canId, std::vector<uint8_t>&& data);
+    UDSRequest(uint32_t canId, const std::vector<uint8_t>& data, const UDSTiming& timing = {});
+    UDSRequest(uint32_t canId, std::vector<uint8_t>&& data, const UDSTiming& timing = {});
 
-    std::vector<uint8_t> process(ICanChannel& channel, size_t timeout = 1000);
+    // Ответ ждётся P2, каждый NRC 0x78 продлевает ожидание на P2*.
+    std::vector<uint8_t> process(ICanChannel& channel);
+    // retryCount - сколько раз можно пропустить ответ с чужими данными или
+    // истёкший без ответа срок P2 (запрос при этом не повторяется).
     std::vector<uint8_t> process(ICanChannel& channel, const std::vector<uint8_t>& checkData,
-                                 size_t retryCount = 1, size_t timeout = 1000);
+                                 size_t retryCount = 1);
 
 private:
     uint32_t _canId;
     uint8_t _requestId;
     std::vector<uint8_t> _data;
+    UDSTiming _timing;
 };
 
 } // namespace common
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "common/protocols/UDSTiming.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace common {
+class ICanChannel;
+
+// Запуск подпрограммы ЭБУ (0x31 01) с ожиданием её завершения. Пока ЭБУ
+// присылает NRC 0x78, ждём окончательного ответа. Если ЭБУ замолчал, после
+// ожидаемого времени работы подпрограммы результат запрашивается
+// RequestRoutineResults (0x31 03), пока ЭБУ не ответит положительно или
+// не истечёт общий срок.
+class UDSRoutineControl {
+public:
+    UDSRoutineControl(uint32_t canId, uint16_t routineId, const UDSTiming& timing = {});
+
+    // Возвращает routineStatusRecord - байты ответа после идентификатора подпрограммы.
+    std::vector<uint8_t> run(ICanChannel& channel, const std::vector<uint8_t>& options,
+                             std::chrono::milliseconds expectedDuration = {});
+
+private:
+    bool sendRequest(ICanChannel& channel, uint8_t subFunction, const std::vector<uint8_t>& options) const;
+
+    const uint32_t _canId;
+    const uint16_t _routineId;
+    const UDSTiming _timing;
+};
+
+// Скорость стирания флеш, байт/мс, запоминается по CAN id ЭБУ на время
+// работы программы. Нужна, чтобы по размеру чанка понять, когда стоит
+// спрашивать результат стирания.
+class UDSEraseThroughput {
+public:
+    static std::chrono::milliseconds expectedDuration(uint32_t canId, size_t size);
+    static void update(uint32_t canId, size_t size, std::chrono::milliseconds elapsed);
+};
+
+} // namespace common
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "common/CarPlatform.hpp"
+#include "common/protocols/UDSTiming.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace j2534 {
+class J2534;
+} // namespace j2534
+
+namespace common {
+
+class ICanChannel;
+class J2534ChannelProvider;
+
+struct UDSSessionConfig {
+    // Без тестер презента ЭБУ выходит из сессии через S3.
+    std::chrono::milliseconds s3{ 5000 };
+    // Сколько сессия держится открытой между операциями, потом сеть будится.
+    std::chrono::milliseconds keepWarm{ std::chrono::minutes{ 10 } };
+};
+
+// Сессия программирования ЭБУ (засыпание сети, P2/P2*, SecurityAccess), общая для
+// нескольких операций подряд: чтение, проверка PIN, прошивка. Пока сессия открыта,
+// следующая операция не засыпает сеть и не авторизуется заново.
+//
+// Каналы J2534 привязаны к потоку и открываются каждой операцией заново, поэтому
+// между операциями тестер презент шлёт свой поток со своими каналами:
+// suspend() закрывает их перед открытием каналов операцией, resume() после
+// закрытия снова открывает. Сессия живёт до keepWarm после последней операции
+// или до S3 после последнего тестер презента, если его никто не шлёт.
+class UDSSession {
+public:
+    using ChannelsOpener = std::function<std::vector<std::unique_ptr<ICanChannel>>()>;
+
+    UDSSession(ChannelsOpener openChannels, uint32_t funcCanId, uint32_t physCanId, UDSSessionConfig config = {});
+    UDSSession(j2534::J2534& j2534, CarPlatform carPlatform, uint32_t ecuId, UDSSessionConfig config = {});
+    ~UDSSession();
+
+    UDSSession(const UDSSession&) = delete;
+    UDSSession& operator=(const UDSSession&) = delete;
+
+    bool isOpen() const;
+    const UDSTiming& getTiming() const;
+    const std::string& getVin() const;
+
+    // pin, если задан, иначе PIN из UDSPinCache для VIN машины. VIN читается
+    // один раз, пока ЭБУ ещё в сессии по умолчанию; без VIN кэш не используется.
+    std::optional<uint64_t> resolvePin(ICanChannel& channel, std::optional<uint64_t> pin);
+
+    // Операция открыла сессию, при авторизации PIN запоминается в UDSPinCache.
+    void opened(const UDSTiming& timing, std::optional<uint64_t> pin);
+    // ЭБУ не принял PIN. Если он взят из кэша, запись удаляется, чтобы
+    // следующая операция не тратила на него попытку SecurityAccess.
+    void authorizationFailed();
+    // Операция закончилась, сессию нужно держать.
+    void leave();
+    // Сессия закончилась: ЭБУ разбужены или перезагружены.
+    void close();
+
+    void suspend();
+    void resume();
+
+private:
+    void keepWarm();
+
+    std::unique_ptr<J2534ChannelProvider> _channelProvider;
+    const ChannelsOpener _openChannels;
+    const uint32_t _funcCanId;
+    const uint32_t _physCanId;
+    const UDSSessionConfig _config;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _stopCondition;
+    bool _stopRequested{ false };
+    bool _keepingWarm{ false };
+    std::thread _keepWarmThread;
+
+    bool _open{ false };
+    std::chrono::steady_clock::time_point _lastTesterPresent;
+    std::chrono::steady_clock::time_point _expiry;
+    UDSTiming _timing;
+    std::string _vin;
+    bool _vinRead{ false };
+    bool _cachedPinUsed{ false };
+};
+
+} // namespace common
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace common {
+
+class ICanChannel;
+struct CanFrame;
+
+// Тайминги сессии ISO 14229-2: P2 - время до первого ответа ЭБУ, P2* - время
+// до следующего ответа после NRC 0x78 (response pending). Реальные значения
+// ЭБУ сообщает в ответе на 0x10. Пока они не известны, первый ответ ждётся
+// DefaultResponseTimeout, как и до введения таймингов сессии; P2* взят из стандарта.
+struct UDSTiming {
+    // Запас клиента на задержку адаптера J2534 и сборку многокадрового ответа.
+    static constexpr std::chrono::milliseconds ClientMargin{ 250 };
+    static constexpr std::chrono::milliseconds DefaultResponseTimeout{ 1000 };
+
+    std::chrono::milliseconds p2{ DefaultResponseTimeout - ClientMargin };
+    std::chrono::milliseconds p2Star{ 5000 };
+
+    // Ответ 0x50: [0x50, сессия, P2 (2 байта, мс), P2* (2 байта, x10 мс)].
+    // Если значений в ответе нет, возвращаются тайминги по умолчанию.
+    static UDSTiming fromSessionResponse(const std::vector<uint8_t>& response);
+};
+
+// Срок ожидания ответа на один запрос: сначала P2, каждый 0x78 продлевает
+// его на P2* от момента получения.
+class UDSResponseTimer {
+public:
+    explicit UDSResponseTimer(const UDSTiming& timing);
+
+    void restart();
+    void responsePending();
+    // false, если до истечения срока ничего не пришло.
+    bool receive(ICanChannel& channel, CanFrame& frame) const;
+
+    std::chrono::milliseconds remaining() const;
+
+private:
+    const UDSTiming _timing;
+    std::chrono::steady_clock::time_point _deadline;
+};
+
+} // namespace common
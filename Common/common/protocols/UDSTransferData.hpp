@@ -0,0 +1,41 @@
+#pragma once
+
+#include "common/CanFrame.hpp"
+#include "common/protocols/UDSTiming.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+namespace common {
+class ICanChannel;
+
+// Передача данных сервисом TransferData (0x36) после RequestDownload.
+// Блок уходит в канал как заголовок {0x36, счётчик} и span в данные чанка,
+// без промежуточных векторов. Пока блок передаётся и ЭБУ его пишет, считается
+// CRC16 отправленных данных и готовится заголовок следующего блока.
+class UDSTransferData {
+public:
+    // Ответ на блок ждётся по таймингам сессии (P2, после 0x78 - P2*),
+    // retryCount - сколько раз можно пропустить чужой ответ или истёкший P2.
+    UDSTransferData(uint32_t canId, size_t maxBlockSize,
+                    const UDSTiming& timing = {}, size_t retryCount = 3);
+
+    // Возвращает CRC16 переданных данных.
+    uint16_t transfer(ICanChannel& channel, std::span<const uint8_t> data,
+                      const std::function<void(size_t)>& progressCallback);
+
+private:
+    void waitResponse(ICanChannel& channel, uint8_t blockIndex);
+
+    const uint32_t _canId;
+    const size_t _maxBlockSize;
+    const UDSTiming _timing;
+    const size_t _retryCount;
+    std::array<uint8_t, 2> _header{ 0x36, 0x01 };
+    CanFrame _response;
+};
+
+} // namespace common
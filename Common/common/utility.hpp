@@ -1,9 +1,30 @@
 #pragma once
 
 #include <type_traits>
+#include <utility>
 
 template<typename E>
 constexpr auto to_underlying(E e) -> typename std::underlying_type<E>::type
 {
     return static_cast<typename std::underlying_type<E>::type>(e);
 }
+
+// Вызывает функцию при выходе из области видимости, в том числе по исключению.
+template<typename F>
+class ScopeGuard {
+public:
+    explicit ScopeGuard(F f)
+        : _f{ std::move(f) }
+    {
+    }
+    ~ScopeGuard()
+    {
+        _f();
+    }
+
+    ScopeGuard(const ScopeGuard&) = delete;
+    ScopeGuard& operator=(const ScopeGuard&) = delete;
+
+private:
+    F _f;
+};
@@ -0,0 +1,274 @@
+#include "common/DiagnosticsSweep.hpp"
+
+#include "common/CanFrame.hpp"
+#include "common/ICanChannel.hpp"
+#include "common/Util.hpp"
+#include "common/protocols/D2Error.hpp"
+#include "common/protocols/D2Message.hpp"
+#include "common/protocols/D2ResponseParser.hpp"
+#include "common/protocols/UDSError.hpp"
+
+#define LOG_MODULE_NAME "common"
+#include "common/LogHelper.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace common {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Если ответа ждём сразу на нескольких шинах, каждая опрашивается
+// короткими порциями, чтобы медленная шина не задерживала остальные.
+constexpr std::chrono::milliseconds BusPollSlice{ 5 };
+
+std::string errorCodeString(const char* prefix, uint8_t code)
+{
+    std::stringstream stream;
+    stream << prefix << " 0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(code);
+    return stream.str();
+}
+
+struct Target {
+    Target(EcuDiagnostics& report, const std::vector<DiagnosticRequest>& requests, const UDSTiming& timing)
+        : report{ report }
+        , requests{ requests }
+        , timer{ timing }
+    {
+    }
+
+    EcuDiagnostics& report;
+    const std::vector<DiagnosticRequest>& requests;
+    size_t next{ 0 };
+    bool waiting{ false };
+
+    // UDS: ответ ждётся по P2/P2*.
+    UDSResponseTimer timer;
+    // D2: ответ ждётся фиксированное время, кадры серии приходят с CAN id первого кадра.
+    Clock::time_point deadline;
+    std::unique_ptr<D2Message> d2Message;
+    std::unique_ptr<D2ResponseParser> d2Parser;
+    std::vector<uint8_t> d2Response;
+    uint32_t d2ResponseCanId{ 0 };
+
+    std::chrono::milliseconds remaining(ProtocolType protocol) const
+    {
+        if (protocol == ProtocolType::ISO15765) {
+            return timer.remaining();
+        }
+        return std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+    }
+
+    void complete(std::vector<uint8_t> response, std::string error = {})
+    {
+        report.results.push_back({ requests[next].name, std::move(response), std::move(error) });
+        ++next;
+        waiting = false;
+        d2Parser.reset();
+        d2Message.reset();
+        d2ResponseCanId = 0;
+    }
+};
+
+struct Bus {
+    ICanChannel& channel;
+    ProtocolType protocol;
+    std::vector<Target> targets;
+};
+
+void sendRequest(Bus& bus, Target& target, std::chrono::milliseconds d2Timeout)
+{
+    const auto& request = target.requests[target.next];
+    bool sent = false;
+    try {
+        if (bus.protocol == ProtocolType::ISO15765) {
+            sent = bus.channel.send(CanFrame{ target.report.ecu.canId, request.data });
+            target.timer.restart();
+        }
+        else {
+            // Весь запрос - requestId, ЭБУ повторяет его в ответе.
+            target.d2Message = std::make_unique<D2Message>(static_cast<uint8_t>(target.report.ecu.ecuId),
+                                                           request.data);
+            target.d2Parser = std::make_unique<D2ResponseParser>(static_cast<uint8_t>(target.report.ecu.ecuId),
+                                                                 target.d2Message->getRequestId(), target.d2Response);
+            sent = bus.channel.send(target.d2Message->getFrames());
+            target.deadline = Clock::now() + d2Timeout;
+        }
+    }
+    catch (const std::exception& ex) {
+        LOG_MODULE(ERROR) << "Failed to send request to " << target.report.ecu.name << ", ex = " << ex.what();
+    }
+    if (!sent) {
+        target.complete({}, "Failed to send request");
+        return;
+    }
+    target.waiting = true;
+}
+
+void dispatchUDS(Bus& bus, CanFrame& frame)
+{
+    for (auto& target : bus.targets) {
+        if (!target.waiting || target.report.ecu.canId + 0x8 != frame.id || frame.data.empty()) {
+            continue;
+        }
+        const auto& data = frame.data;
+        const uint8_t requestId = target.requests[target.next].data[0];
+        if (data.size() >= 3 && data[0] == 0x7F && data[1] == requestId) {
+            if (data[2] == UDSError::ErrorCode::RequestReceivedResponsePending) {
+                target.timer.responsePending();
+            }
+            else {
+                target.complete({}, errorCodeString("NRC", data[2]));
+            }
+        }
+        else if (data[0] == requestId + 0x40) {
+            target.complete({ data.cbegin() + 1, data.cend() });
+        }
+        return;
+    }
+}
+
+void dispatchD2(Bus& bus, const CanFrame& frame)
+{
+    // Продолжение серии идёт тому ЭБУ, который начал её с этого CAN id,
+    // первый кадр по ecuId внутри узнаёт сам разборщик.
+    const auto seriesOwner = std::find_if(bus.targets.begin(), bus.targets.end(), [&frame](const Target& target) {
+        return target.waiting && target.d2ResponseCanId == frame.id;
+    });
+    for (auto it = bus.targets.begin(); it != bus.targets.end(); ++it) {
+        auto& target = *it;
+        if (!target.waiting || (seriesOwner != bus.targets.end() && it != seriesOwner)
+            || (seriesOwner == bus.targets.end() && target.d2ResponseCanId != 0)) {
+            continue;
+        }
+        try {
+            const auto status = target.d2Parser->feed(frame);
+            if (status == D2ResponseParser::Status::Skipped) {
+                target.d2ResponseCanId = 0;
+                continue;
+            }
+            if (status == D2ResponseParser::Status::Complete) {
+                target.complete(std::move(target.d2Response));
+                target.d2Response.clear();
+            }
+            else {
+                target.d2ResponseCanId = frame.id;
+            }
+        }
+        catch (const D2Error& ex) {
+            target.complete({}, errorCodeString("D2 error", ex.getErrorCode()));
+        }
+        catch (const std::exception& ex) {
+            target.complete({}, ex.what());
+        }
+        return;
+    }
+}
+
+} // namespace
+
+DiagnosticsSweep::DiagnosticsSweep(ConfigurationInfo configuration, DiagnosticsSweepConfig config)
+    : _configuration{ std::move(configuration) }
+    , _config{ std::move(config) }
+{
+}
+
+DiagnosticsSweep::DiagnosticsSweep(CarPlatform carPlatform, DiagnosticsSweepConfig config)
+    : DiagnosticsSweep{ getConfigurationInfoByCarPlatform(carPlatform), std::move(config) }
+{
+}
+
+std::vector<EcuDiagnostics> DiagnosticsSweep::run(const std::vector<std::unique_ptr<ICanChannel>>& channels) const
+{
+    LOG_SCOPE_DURATION(diagnosticsSweep);
+    const auto isSupported = [](const BusConfiguration& bus, const ECUInfo& ecu) {
+        return bus.protocol == ProtocolType::CAN || (bus.protocol == ProtocolType::ISO15765 && ecu.canId != 0);
+    };
+    // Цели ссылаются на отчёты, поэтому место под них выделяется заранее.
+    size_t ecuCount = 0;
+    for (size_t i = 0; i < _configuration.busInfo.size() && i < channels.size(); ++i) {
+        const auto& bus = _configuration.busInfo[i];
+        ecuCount += std::count_if(bus.ecuInfo.cbegin(), bus.ecuInfo.cend(), [&](const ECUInfo& ecu) {
+            return isSupported(bus, ecu);
+        });
+    }
+    std::vector<EcuDiagnostics> result;
+    result.reserve(ecuCount);
+
+    std::vector<Bus> buses;
+    for (size_t i = 0; i < _configuration.busInfo.size() && i < channels.size(); ++i) {
+        const auto& busInfo = _configuration.busInfo[i];
+        Bus bus{ *channels[i], busInfo.protocol, {} };
+        const auto& requests = busInfo.protocol == ProtocolType::ISO15765 ? _config.udsRequests : _config.d2Requests;
+        for (const auto& ecu : busInfo.ecuInfo) {
+            if (!isSupported(busInfo, ecu)) {
+                continue;
+            }
+            if (busInfo.protocol == ProtocolType::ISO15765 && !prepareUDSChannel(bus.channel, ecu.canId)) {
+                // Фильтр этого CAN id мог быть открыт вместе с каналом.
+                LOG_MODULE(DEBUG) << "Flow control filter isn't added, ecu = " << ecu.name;
+            }
+            result.push_back({ ecu, busInfo.name, busInfo.protocol, {} });
+            bus.targets.emplace_back(result.back(), requests, _config.udsTiming);
+        }
+        if (!bus.targets.empty()) {
+            bus.channel.clearRx();
+            buses.push_back(std::move(bus));
+        }
+    }
+
+    while (true) {
+        size_t activeBuses = 0;
+        for (auto& bus : buses) {
+            bool active = false;
+            for (auto& target : bus.targets) {
+                if (!target.waiting && target.next < target.requests.size()) {
+                    sendRequest(bus, target, _config.d2Timeout);
+                }
+                active = active || target.waiting;
+            }
+            activeBuses += active ? 1 : 0;
+        }
+        if (activeBuses == 0) {
+            break;
+        }
+
+        for (auto& bus : buses) {
+            auto timeout = std::chrono::milliseconds::max();
+            for (const auto& target : bus.targets) {
+                if (target.waiting) {
+                    timeout = std::min(timeout, target.remaining(bus.protocol));
+                }
+            }
+            if (timeout == std::chrono::milliseconds::max()) {
+                continue;
+            }
+            if (activeBuses > 1) {
+                timeout = std::min(timeout, BusPollSlice);
+            }
+            timeout = std::max(timeout, std::chrono::milliseconds::zero());
+            CanFrame frame;
+            // Забираем всё, что уже пришло, ожидание - только на первом кадре.
+            while (bus.channel.receive(frame, static_cast<unsigned long>(timeout.count()))) {
+                if (bus.protocol == ProtocolType::ISO15765) {
+                    dispatchUDS(bus, frame);
+                }
+                else {
+                    dispatchD2(bus, frame);
+                }
+                timeout = std::chrono::milliseconds::zero();
+            }
+            for (auto& target : bus.targets) {
+                if (target.waiting && target.remaining(bus.protocol).count() <= 0) {
+                    target.complete({}, "No response");
+                }
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace common
@@ -0,0 +1,64 @@
+#include "common/FramePacer.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+namespace common {
+
+namespace {
+
+// Кадр со стандартным id и 8 байтами данных - 111 бит без учёта stuff-битов.
+constexpr unsigned long CanFrameBits = 111;
+
+} // namespace
+
+FramePacer::FramePacer(std::chrono::microseconds interval, std::chrono::microseconds frameTime, NowFunction now)
+    : _interval{ interval }
+    , _frameTime{ frameTime }
+    , _now{ std::move(now) }
+    , _next{}
+{
+}
+
+void FramePacer::setInterval(std::chrono::microseconds interval)
+{
+    _interval = interval;
+}
+
+std::chrono::microseconds FramePacer::getInterval() const
+{
+    return _interval;
+}
+
+size_t FramePacer::wait(size_t count)
+{
+    // Сон на оставшееся время, а не до момента: так он верен и для подставленных часов.
+    if (const auto now = _now(); now + SleepMargin < _next) {
+        std::this_thread::sleep_for(_next - SleepMargin - now);
+    }
+    while (_now() < _next) {
+        std::this_thread::yield();
+    }
+    return _interval <= _frameTime ? count : std::min<size_t>(count, 1);
+}
+
+void FramePacer::sent()
+{
+    _next = _now() + _interval;
+}
+
+FramePacer::Clock::time_point FramePacer::getDeadline() const
+{
+    return _next;
+}
+
+/*static*/ std::chrono::microseconds FramePacer::frameTimeForBaudrate(unsigned long baudrate)
+{
+    if (baudrate == 0) {
+        return {};
+    }
+    return std::chrono::microseconds{ CanFrameBits * 1000000 / baudrate };
+}
+
+} // namespace common
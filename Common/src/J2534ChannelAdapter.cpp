@@ -7,32 +7,47 @@
 #include "common/LogHelper.hpp"
 
 #include <cstring>
+#include <span>
+#include <vector>
 
 namespace {
 
-void canFrameToPassthruMsg(const common::CanFrame& frame,
-                            unsigned long protocolId,
-                            unsigned long txFlags,
-                            PASSTHRU_MSG& msg) {
+void fillPassthruMsg(uint32_t id, bool isExtendedId,
+                     std::span<const uint8_t> header,
+                     std::span<const uint8_t> payload,
+                     unsigned long protocolId,
+                     unsigned long txFlags,
+                     PASSTHRU_MSG& msg) {
     const bool isUds = (protocolId == ISO15765 || protocolId == ISO15765_PS);
+    const size_t dataSize = header.size() + payload.size();
     std::memset(&msg, 0, sizeof(msg));
     msg.ProtocolID = protocolId;
     msg.RxStatus = 0;
-    msg.TxFlags = txFlags | (frame.isExtendedId ? CAN_29BIT_ID : 0) | (isUds ? ISO15765_FRAME_PAD : 0);
+    msg.TxFlags = txFlags | (isExtendedId ? CAN_29BIT_ID : 0) | (isUds ? ISO15765_FRAME_PAD : 0);
     msg.Timestamp = 0;
     msg.ExtraDataIndex = 0;
     // WORKAROUND: DiCE hangsup if DataSize < 12 bytes
     // Don't check for 8 bytes size for UDS protocol
-    msg.DataSize = 4ul + std::max(static_cast<unsigned long>(frame.data.size()), isUds ? 0ul : 8ul);
-    msg.Data[0] = (frame.id >> 24) & 0xFF;
-    msg.Data[1] = (frame.id >> 16) & 0xFF;
-    msg.Data[2] = (frame.id >> 8) & 0xFF;
-    msg.Data[3] = frame.id & 0xFF;
-    if (!frame.data.empty()) {
-        std::memcpy(msg.Data + 4, frame.data.data(), frame.data.size());
+    msg.DataSize = 4ul + std::max(static_cast<unsigned long>(dataSize), isUds ? 0ul : 8ul);
+    msg.Data[0] = (id >> 24) & 0xFF;
+    msg.Data[1] = (id >> 16) & 0xFF;
+    msg.Data[2] = (id >> 8) & 0xFF;
+    msg.Data[3] = id & 0xFF;
+    if (!header.empty()) {
+        std::memcpy(msg.Data + 4, header.data(), header.size());
+    }
+    if (!payload.empty()) {
+        std::memcpy(msg.Data + 4 + header.size(), payload.data(), payload.size());
     }
 }
 
+void canFrameToPassthruMsg(const common::CanFrame& frame,
+                            unsigned long protocolId,
+                            unsigned long txFlags,
+                            PASSTHRU_MSG& msg) {
+    fillPassthruMsg(frame.id, frame.isExtendedId, frame.data, {}, protocolId, txFlags, msg);
+}
+
 common::CanFrame passthruMsgToCanFrame(const PASSTHRU_MSG& msg) {
     common::CanFrame frame;
     frame.id = (static_cast<uint32_t>(msg.Data[0]) << 24) |
@@ -92,6 +107,23 @@ bool J2534ChannelAdapter::send(const std::vector<CanFrame>& frames, unsigned lon
     return rc == STATUS_NOERROR;
 }
 
+bool J2534ChannelAdapter::send(uint32_t id, std::span<const uint8_t> header, std::span<const uint8_t> payload,
+                               unsigned long timeout) {
+    // Буфер на поток: большие блоки TransferData не выделяют память на каждый кадр.
+    thread_local std::vector<PASSTHRU_MSG> msgs(1);
+    if (4 + header.size() + payload.size() > sizeof(msgs[0].Data)) {
+        LOG_MODULE(ERROR) << "send failed, frame too large: " << header.size() + payload.size();
+        return false;
+    }
+    fillPassthruMsg(id, false, header, payload, _protocolId, _txFlags, msgs[0]);
+    unsigned long numMsgs = 1;
+    auto rc = _channel->writeMsgs(msgs, numMsgs, timeout);
+    if (rc != STATUS_NOERROR) {
+        LOG_MODULE(DEBUG) << "send failed, rc=" << rc;
+    }
+    return rc == STATUS_NOERROR;
+}
+
 bool J2534ChannelAdapter::receive(CanFrame& frame, unsigned long timeout) {
     std::vector<PASSTHRU_MSG> msgs(1);
     auto rc = _channel->readMsgs(msgs, timeout);
@@ -92,4 +92,15 @@ std::unique_ptr<ICanChannel> J2534ChannelProvider::getChannelForEcu(uint32_t ecu
     return {};
 }
 
+std::unique_ptr<ICanChannel> J2534ChannelProvider::getRawChannelForEcu(uint32_t ecuId) const
+{
+    const auto bus{ std::get<0>(getEcuInfoByEcuId(_carPlatform, ecuId)) };
+    // TP20 тоже работает поверх CAN, без canId канал открывается без фильтров.
+    auto rawChannel{ openTP20Channel(_j2534, bus.baudrate) };
+    if (rawChannel) {
+        return std::make_unique<J2534ChannelAdapter>(std::move(rawChannel));
+    }
+    return {};
+}
+
 } // namespace common
@@ -16,6 +16,7 @@
 #include <easylogging++.h>
 
 #include <algorithm>
+#include <array>
 #include <codecvt>
 #include <cstdlib>
 #include <locale>
@@ -301,6 +302,12 @@ namespace common {
         return channel.startMsgFilter(FLOW_CONTROL_FILTER, &maskMsg, &patternMsg, &flowMsg, msgId) == STATUS_NOERROR;
     }
 
+    bool prepareUDSChannel(ICanChannel& channel, uint32_t canId) {
+        unsigned long filterId;
+        const CanFrame flow{ canId, {} };
+        return channel.startMsgFilter(FLOW_CONTROL_FILTER, { 0xFFFFFFFF, {} }, { canId + 0x8, {} }, &flow, filterId);
+    }
+
     bool prepareTP20Channel(j2534::J2534Channel& channel, uint32_t canId) {
         unsigned long msgId;
         PASSTHRU_MSG maskMsg =
@@ -726,10 +733,10 @@ namespace common {
 
     void checkUDSError(uint8_t requestId, const uint8_t* data, size_t dataSize)
     {
-        if(dataSize < 7 || data[4] != 0x7F || data[5] != requestId) {
+        if(dataSize < 3 || data[0] != 0x7F || data[1] != requestId) {
             return;
         }
-        throw UDSError(data[6]);
+        throw UDSError(data[2]);
     }
 
     CarPlatform parsePlatform(std::string input)
@@ -763,6 +770,15 @@ namespace common {
         return { (pin >> 32) & 0xFF, (pin >> 24) & 0xFF, (pin >> 16) & 0xFF, (pin >> 8) & 0xFF, pin & 0xFF };
     }
 
+    uint64_t getPinFromArray(const std::array<uint8_t, 5>& pin)
+    {
+        uint64_t result = 0;
+        for (const auto byte : pin) {
+            result = (result << 8) | byte;
+        }
+        return result;
+    }
+
     void initLogger(const std::string& logFilename, bool enableConsole, bool debugMode)
     {
         el::Configurations defaultConf;
@@ -819,10 +835,8 @@ namespace common {
         }
     }
 
-    uint16_t crc16(const uint8_t* data_p, size_t length)
+    uint16_t crc16(const uint8_t* data_p, size_t length, uint16_t crc)
     {
-        uint16_t crc = 0xFFFF;
-
         while (length--) {
             uint8_t x = crc >> 8 ^ *data_p++;
             x ^= x >> 4;
@@ -831,4 +845,45 @@ namespace common {
         return crc;
     }
 
+    namespace {
+
+        // Таблицы slicing-by-8: Crc32Tables[k][b] - CRC байта b, за которым идут k нулевых.
+        constexpr std::array<std::array<uint32_t, 256>, 8> makeCrc32Tables()
+        {
+            std::array<std::array<uint32_t, 256>, 8> tables{};
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+                }
+                tables[0][i] = crc;
+            }
+            for (uint32_t i = 0; i < 256; ++i) {
+                for (size_t k = 1; k < tables.size(); ++k) {
+                    tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+                }
+            }
+            return tables;
+        }
+
+        constexpr auto Crc32Tables{ makeCrc32Tables() };
+
+    } // namespace
+
+    uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc)
+    {
+        const auto& t{ Crc32Tables };
+        crc = ~crc;
+        for (; length >= 8; data += 8, length -= 8) {
+            const uint32_t low = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24));
+            const uint32_t high = data[4] | (data[5] << 8) | (data[6] << 16) | (static_cast<uint32_t>(data[7]) << 24);
+            crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24]
+                ^ t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^ t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        }
+        while (length--) {
+            crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+        }
+        return ~crc;
+    }
+
 } // namespace common
@@ -1,7 +1,13 @@
-#pragma once
-
 #include "common/compression/BoschCompressor.hpp"
 
+#include <algorithm>
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOSCH_COMPRESSOR_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace common {
 
 namespace {
@@ -14,38 +20,88 @@ static constexpr uint8_t BOSCH_HEADER2 = 0x01;        // Второй байт 
 static constexpr uint8_t CHECKSUM_MARKER = 0xC0;      // Маркер начала контрольной суммы
 static constexpr uint16_t RLE_COMMAND_FLAG = 0x4000;  // Флаг RLE-команды
 
-static size_t countRepeats(const std::vector<uint8_t>& input, size_t pos)
+// Первая позиция от pos, с которой идут RLE_THRESHOLD одинаковых байт
+// (с неё сжатие начинает RLE-блок), или размер данных.
+static size_t findRun(std::span<const uint8_t> input, size_t pos, bool vectorized)
 {
-    if(pos >= input.size())
-        return 0;
+    const uint8_t* data = input.data();
+    const size_t size = input.size();
+#ifdef BOSCH_COMPRESSOR_SSE2
+    // 16 позиций за шаг: байт сравнивается сразу с четырьмя следующими.
+    for (; vectorized && pos + 16 + RLE_THRESHOLD - 1 <= size; pos += 16) {
+        const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i equal = _mm_cmpeq_epi8(first, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + 1)));
+        for (size_t shift = 2; shift < RLE_THRESHOLD; ++shift) {
+            const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + shift));
+            equal = _mm_and_si128(equal, _mm_cmpeq_epi8(first, next));
+        }
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(equal));
+        if (mask != 0) {
+            return pos + std::countr_zero(mask);
+        }
+    }
+#endif
+    for (; pos + RLE_THRESHOLD <= size; ++pos) {
+        size_t count = 1;
+        while (count < RLE_THRESHOLD && data[pos + count] == data[pos]) {
+            count++;
+        }
+        if (count == RLE_THRESHOLD) {
+            return pos;
+        }
+    }
+    return size;
+}
 
-    const uint8_t value = input[pos];
+// Сколько байт подряд равны байту на pos, не больше MAX_BLOCK_SIZE.
+static size_t countRepeats(std::span<const uint8_t> input, size_t pos, bool vectorized)
+{
+    const uint8_t* data = input.data();
+    const size_t limit = std::min(input.size() - pos, static_cast<size_t>(MAX_BLOCK_SIZE));
     size_t count = 1;
-
-    while (pos + count < input.size() &&
-           input[pos + count] == value &&
-           count < MAX_BLOCK_SIZE) {  // Используем константу
+#ifdef BOSCH_COMPRESSOR_SSE2
+    const __m128i value = _mm_set1_epi8(static_cast<char>(data[pos]));
+    for (; vectorized && count + 16 <= limit; count += 16) {
+        const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos + count));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(next, value)));
+        if (mask != 0xFFFF) {
+            return count + std::countr_zero(~mask);
+        }
+    }
+#endif
+    while (count < limit && data[pos + count] == data[pos]) {
         count++;
     }
-
     return count;
 }
 
-static void writeRawBlock(std::vector<uint8_t>& output,
-                          const std::vector<uint8_t>& input,
-                          size_t current_pos,
-                          size_t& bytes_not_touched)
+static uint32_t sum(std::span<const uint8_t> input, bool vectorized)
 {
-    if (bytes_not_touched == 0) return;
-
-    output.push_back(static_cast<uint8_t>((bytes_not_touched >> 8) & 0xFF));
-    output.push_back(static_cast<uint8_t>(bytes_not_touched & 0xFF));
-
-    output.insert(output.end(),
-                  input.begin() + current_pos - bytes_not_touched,
-                  input.begin() + current_pos);
+    const uint8_t* data = input.data();
+    size_t pos = 0;
+    uint64_t total = 0;
+#ifdef BOSCH_COMPRESSOR_SSE2
+    // psadbw складывает каждые 8 байт в 64-битное слово.
+    __m128i sums = _mm_setzero_si128();
+    for (; vectorized && pos + 16 <= input.size(); pos += 16) {
+        const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(next, _mm_setzero_si128()));
+    }
+    // Контрольной сумме нужны только младшие 32 бита.
+    total = static_cast<uint32_t>(_mm_cvtsi128_si32(sums))
+          + static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_unpackhi_epi64(sums, sums)));
+#endif
+    for (; pos < input.size(); ++pos) {
+        total += data[pos];
+    }
+    return static_cast<uint32_t>(total);
+}
 
-    bytes_not_touched = 0;
+static void writeRawBlock(std::vector<uint8_t>& output, std::span<const uint8_t> block)
+{
+    output.push_back(static_cast<uint8_t>((block.size() >> 8) & 0xFF));
+    output.push_back(static_cast<uint8_t>(block.size() & 0xFF));
+    output.insert(output.end(), block.begin(), block.end());
 }
 
 static void writeRleBlock(std::vector<uint8_t>& output, uint8_t value, size_t count)
@@ -56,79 +112,28 @@ static void writeRleBlock(std::vector<uint8_t>& output, uint8_t value, size_t co
     output.push_back(value);
 }
 
-static void writeChecksum(std::vector<uint8_t>& output, const std::vector<uint8_t>& input)
+static void writeChecksum(std::vector<uint8_t>& output, uint32_t checksum)
 {
-    uint32_t checksum = 0;
-    for (uint8_t byte : input) {
-        checksum += byte;
-    }
-
     output.push_back(CHECKSUM_MARKER);
     output.push_back(0x00); // Первый байт суммы обнулен
     output.push_back(static_cast<uint8_t>((checksum >> 16) & 0xFF));
     output.push_back(static_cast<uint8_t>((checksum >> 8) & 0xFF));
     output.push_back(static_cast<uint8_t>(checksum & 0xFF));
 }
-}
 
-std::vector<uint8_t> BoschCompressor::compress(const std::vector<uint8_t>& input)
+// Больше данных сжатие дать не может: заголовок, байты как есть, заголовки
+// блоков (не чаще раза на SAFE_BLOCK_SIZE байт или на RLE-блок, который сам
+// короче своих повторений) и контрольная сумма.
+static size_t maxCompressedSize(size_t input_size)
 {
-    std::vector<uint8_t> output;
-    output.reserve(input.size()); // Оптимизация: резервируем память заранее
-
-    // Заголовок
-    output.push_back(BOSCH_HEADER1);
-    output.push_back(BOSCH_HEADER2);
-
-    size_t i = 0;
-    const size_t input_size = input.size();
-    size_t bytes_not_touched = 0;
-
-    while (i < input_size) {
-        // Проверяем лимит для неповторяющихся байтов
-        if (bytes_not_touched >= SAFE_BLOCK_SIZE) {
-            writeRawBlock(output, input, i, bytes_not_touched);
-        }
-
-        // Ищем последовательность одинаковых байтов
-        size_t repeat_count = countRepeats(input, i);
-
-        if (repeat_count >= RLE_THRESHOLD) {
-            // Записываем накопленные неповторяющиеся байты
-            if (bytes_not_touched > 0) {
-                writeRawBlock(output, input, i, bytes_not_touched);
-            }
-
-            // Записываем RLE-блок (но не превышаем максимальный размер)
-            size_t actual_repeats = std::min(repeat_count, static_cast<size_t>(MAX_BLOCK_SIZE));
-            writeRleBlock(output, input[i], actual_repeats);
-            i += actual_repeats;
-        } else {
-            bytes_not_touched++;
-            i++;
-        }
-    }
-
-    // Записываем оставшиеся байты
-    if (bytes_not_touched > 0) {
-        writeRawBlock(output, input, i, bytes_not_touched);
-    }
-
-    // Контрольная сумма
-    writeChecksum(output, input);
-
-    return output;
+    return input_size + 2 * (input_size / SAFE_BLOCK_SIZE) + 9;
 }
 
-std::vector<uint8_t> BoschCompressor::decompress(const std::vector<uint8_t>& input)
+// Обходит блоки сжатых данных: rle(value, count) для повторений,
+// raw(pos, size) для байтов как есть.
+template<typename Rle, typename Raw>
+static void forEachBlock(std::span<const uint8_t> input, Rle rle, Raw raw)
 {
-    if (input.size() < 7 || input[0] != BOSCH_HEADER1 || input[1] != BOSCH_HEADER2) {
-        return {};
-    }
-
-    std::vector<uint8_t> output;
-    output.reserve(input.size() * 2); // Эвристика для резервирования памяти
-
     for (size_t i = 2; i < input.size() - 5;) {
         if (i + 1 >= input.size()) break;
 
@@ -139,17 +144,75 @@ std::vector<uint8_t> BoschCompressor::decompress(const std::vector<uint8_t>& inp
             uint16_t count = command & MAX_BLOCK_SIZE;
             if (i >= input.size()) break;
 
-            uint8_t value = input[i++];
-            output.insert(output.end(), count, value);
+            rle(input[i++], count);
         } else { // Raw-блок
             if (i + command > input.size()) break;
 
-            output.insert(output.end(), input.begin() + i, input.begin() + i + command);
+            raw(i, command);
             i += command;
         }
     }
+}
+}
+
+BoschCompressor::BoschCompressor(bool vectorized)
+    : _vectorized{ vectorized }
+{
+}
+
+void BoschCompressor::compressTo(std::span<const uint8_t> input, std::vector<uint8_t>& output)
+{
+    output.clear();
+    output.reserve(maxCompressedSize(input.size()));
+
+    // Заголовок
+    output.push_back(BOSCH_HEADER1);
+    output.push_back(BOSCH_HEADER2);
+
+    const size_t input_size = input.size();
+    uint32_t checksum = 0;
+
+    for (size_t i = 0; i < input_size;) {
+        // Всё до следующего повторения идёт как есть блоками по SAFE_BLOCK_SIZE
+        const size_t run_pos = findRun(input, i, _vectorized);
+        checksum += sum(input.subspan(i, run_pos - i), _vectorized);
+        while (i < run_pos) {
+            const size_t block_size = std::min(run_pos - i, static_cast<size_t>(SAFE_BLOCK_SIZE));
+            writeRawBlock(output, input.subspan(i, block_size));
+            i += block_size;
+        }
+
+        // RLE-блок (но не превышаем максимальный размер)
+        if (run_pos < input_size) {
+            const size_t repeat_count = countRepeats(input, run_pos, _vectorized);
+            writeRleBlock(output, input[run_pos], repeat_count);
+            checksum += static_cast<uint32_t>(input[run_pos] * repeat_count);
+            i = run_pos + repeat_count;
+        }
+    }
+
+    // Контрольная сумма
+    writeChecksum(output, checksum);
+}
+
+void BoschCompressor::decompressTo(std::span<const uint8_t> input, std::vector<uint8_t>& output)
+{
+    output.clear();
+    if (input.size() < 7 || input[0] != BOSCH_HEADER1 || input[1] != BOSCH_HEADER2) {
+        return;
+    }
 
-    return output;
+    // Сначала точный размер, затем один проход без перевыделений.
+    size_t size = 0;
+    forEachBlock(input,
+        [&size](uint8_t, size_t count) { size += count; },
+        [&size](size_t, size_t count) { size += count; });
+    output.resize(size);
+
+    uint8_t* out = output.data();
+    forEachBlock(input,
+        [&out](uint8_t value, size_t count) { out = std::fill_n(out, count, value); },
+        [&out, &input](size_t pos, size_t count) { out = std::copy_n(input.begin() + pos, count, out); });
 }
 
 } // namespace common
@@ -0,0 +1,119 @@
+#include "common/compression/CompressionSelector.hpp"
+
+#include "common/compression/CompressorBase.hpp"
+#include "common/compression/CompressorFactory.hpp"
+#include "common/FramePacer.hpp"
+
+#define LOG_MODULE_NAME "common"
+#include "common/LogHelper.hpp"
+
+#include <optional>
+#include <stdexcept>
+
+namespace common {
+
+namespace {
+
+constexpr size_t IsoTpFrameBytes = 7;
+
+std::chrono::microseconds elapsedSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+}
+
+} // namespace
+
+std::string toString(const CompressionOption& option)
+{
+    switch (option.type) {
+    case CompressionType::LZSS:
+        return option.optimalParsing ? "lzss-optimal" : "lzss";
+    case CompressionType::Bosch:
+        return "bosch";
+    case CompressionType::None:
+        return "none";
+    }
+    return {};
+}
+
+std::chrono::microseconds CompressionEstimate::getTotalTime() const
+{
+    return compressTime + transferTime;
+}
+
+/*static*/ std::vector<CompressionOption> CompressionSelector::getOptions(CompressionType accepted)
+{
+    std::vector<CompressionOption> options{ { CompressionType::None, false } };
+    switch (accepted) {
+    case CompressionType::LZSS:
+        options.push_back({ CompressionType::LZSS, false });
+        options.push_back({ CompressionType::LZSS, true });
+        break;
+    case CompressionType::Bosch:
+        options.push_back({ CompressionType::Bosch, false });
+        break;
+    case CompressionType::None:
+        break;
+    }
+    return options;
+}
+
+/*static*/ CompressionEstimate CompressionSelector::estimate(const CompressionOption& option, const VBF& flash,
+                                                             unsigned long baudrate)
+{
+    CompressionEstimate result{ option };
+    const auto compressor = CompressorFactory::create(option.type, option.optimalParsing);
+    std::vector<uint8_t> compressed;
+    std::vector<uint8_t> decompressed;
+    for (const auto& chunk : flash.chunks) {
+        result.inputBytes += chunk.data.size();
+        if (!compressor) {
+            result.outputBytes += chunk.data.size();
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        compressor->compressTo(chunk.data, compressed);
+        result.compressTime += elapsedSince(start);
+        result.outputBytes += compressed.size();
+
+        start = std::chrono::steady_clock::now();
+        compressor->decompressTo(compressed, decompressed);
+        result.decompressTime += elapsedSince(start);
+        if (decompressed != chunk.data) {
+            throw std::runtime_error("Compression doesn't round trip");
+        }
+    }
+    result.transferTime = estimateTransferTime(result.outputBytes, baudrate);
+    return result;
+}
+
+/*static*/ CompressionEstimate CompressionSelector::select(CompressionType accepted, const VBF& flash,
+                                                           unsigned long baudrate)
+{
+    std::optional<CompressionEstimate> best;
+    for (const auto& option : getOptions(accepted)) {
+        // Метод, который не справился с прошивкой (формат не вмещает данные,
+        // распаковка не сходится), просто не участвует в выборе. Без сжатия
+        // оценка не падает, так что выбор есть всегда.
+        CompressionEstimate estimate;
+        try {
+            estimate = CompressionSelector::estimate(option, flash, baudrate);
+        }
+        catch (const std::exception& ex) {
+            LOG_MODULE(WARNING) << "Compression " << toString(option) << " is skipped: " << ex.what();
+            continue;
+        }
+        LOG_MODULE(DEBUG) << "Compression " << toString(option) << ": " << estimate.outputBytes << " bytes, " << estimate.getTotalTime().count() << " us";
+        if (!best || estimate.getTotalTime() < best->getTotalTime()) {
+            best = estimate;
+        }
+    }
+    return *best;
+}
+
+/*static*/ std::chrono::microseconds CompressionSelector::estimateTransferTime(size_t bytes, unsigned long baudrate)
+{
+    return FramePacer::frameTimeForBaudrate(baudrate) * static_cast<long>((bytes + IsoTpFrameBytes - 1) / IsoTpFrameBytes);
+}
+
+} // namespace common
@@ -0,0 +1,19 @@
+#include "common/compression/CompressorBase.hpp"
+
+namespace common {
+
+std::vector<uint8_t> CompressorBase::compress(const std::vector<uint8_t>& input)
+{
+    std::vector<uint8_t> output;
+    compressTo(input, output);
+    return output;
+}
+
+std::vector<uint8_t> CompressorBase::decompress(const std::vector<uint8_t>& input)
+{
+    std::vector<uint8_t> output;
+    decompressTo(input, output);
+    return output;
+}
+
+} // namespace common
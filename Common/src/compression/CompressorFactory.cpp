@@ -5,13 +5,14 @@
 
 namespace common {
 
-std::unique_ptr<CompressorBase> CompressorFactory::create(CompressionType compressionType)
+std::unique_ptr<CompressorBase> CompressorFactory::create(CompressionType compressionType, bool optimalParsing)
 {
     switch(compressionType) {
     case CompressionType::Bosch:
         return std::make_unique<BoschCompressor>();
     case CompressionType::LZSS:
-        return std::make_unique<LZSSCompressor>();
+        return std::make_unique<LZSSCompressor>(
+            optimalParsing ? LZSSCompressor::Parsing::Optimal : LZSSCompressor::Parsing::Greedy);
     case CompressionType::None:
         return {};
     }
@@ -1,5 +1,8 @@
 #include "common/compression/LZSSCompressor.hpp"
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace common {
 
 namespace {
@@ -8,90 +11,151 @@ static constexpr size_t WINDOW_SIZE = 4096;    // Размер скользящ
 static constexpr size_t LOOKAHEAD_BUFFER = 18; // Размер буфера предпросмотра
 static constexpr size_t MIN_MATCH_LENGTH = 3;  // Минимальная длина совпадения
 
+static constexpr size_t LITERAL_BITS = 9;      // Флаг и байт
+static constexpr size_t TOKEN_BITS = 17;       // Флаг и два байта ссылки
+
+static constexpr size_t HASH_BITS = 16;
+static constexpr uint32_t NO_POSITION = static_cast<uint32_t>(-1);
+
 struct Match {
     size_t offset;
     size_t length;
 };
 
-Match find_match(const std::vector<uint8_t>& data, size_t pos) {
-    Match best = {0, 0};
-    if (pos >= data.size()) return best;
+// Цепочки позиций с одинаковым хешем первых трёх байт. Совпадение длиной от
+// MIN_MATCH_LENGTH начинается с тех же трёх байт, поэтому искать его нужно
+// только в цепочке. Цепочка идёт от старых позиций к новым: из совпадений
+// максимальной длины выбирается самое дальнее, как при переборе окна с начала,
+// и поиск останавливается на первом совпадении предельной длины. На заливке
+// 0xFF это первая же позиция цепочки. Таблицы принадлежат компрессору.
+class MatchFinder {
+public:
+    MatchFinder(std::span<const uint8_t> data, size_t maxChainDepth,
+                std::vector<uint32_t>& head, std::vector<uint32_t>& tail, std::vector<uint32_t>& next)
+        : _data{ data }
+        , _maxChainDepth{ maxChainDepth }
+        , _head{ head }
+        , _tail{ tail }
+        , _next{ next }
+    {
+        _head.assign(size_t{ 1 } << HASH_BITS, NO_POSITION);
+        _tail.assign(size_t{ 1 } << HASH_BITS, NO_POSITION);
+        _next.assign(data.size(), NO_POSITION);
+    }
 
-    size_t start = (pos > WINDOW_SIZE) ? pos - WINDOW_SIZE : 0;
-    start = std::max(start, (size_t)0);
+    // Позиции добавляются по порядку, включая позиции внутри совпадений.
+    void insert(size_t pos)
+    {
+        if (pos + MIN_MATCH_LENGTH > _data.size()) return;
 
-    for (size_t i = start; i < pos; ++i) {
-        size_t len = 0;
-        while (len < LOOKAHEAD_BUFFER &&
-               pos + len < data.size() &&
-               i + len < data.size() &&
-               data[i + len] == data[pos + len]) {
-            len++;
+        const size_t h = hash(pos);
+        if (_head[h] == NO_POSITION) {
+            _head[h] = static_cast<uint32_t>(pos);
+        } else {
+            _next[_tail[h]] = static_cast<uint32_t>(pos);
         }
-        if (len > best.length) {
-            best = {pos - i, len};
+        _tail[h] = static_cast<uint32_t>(pos);
+    }
+
+    Match find(size_t pos)
+    {
+        Match best = {0, 0};
+        const size_t max_length = std::min(LOOKAHEAD_BUFFER, _data.size() - pos);
+        if (max_length < MIN_MATCH_LENGTH) return best;
+
+        // Позиции, вышедшие из окна, больше не понадобятся.
+        const size_t start = (pos > WINDOW_SIZE) ? pos - WINDOW_SIZE : 0;
+        uint32_t& head = _head[hash(pos)];
+        while (head != NO_POSITION && head < start) {
+            head = _next[head];
         }
+
+        size_t depth = 0;
+        for (uint32_t i = head; i != NO_POSITION && i < pos; i = _next[i]) {
+            size_t len = 0;
+            while (len < max_length && _data[i + len] == _data[pos + len]) {
+                len++;
+            }
+            if (len > best.length) {
+                best = {pos - i, len};
+                if (len == max_length) break;
+            }
+            if (++depth == _maxChainDepth) break;
+        }
+        return best;
     }
-    return best;
-}
 
+private:
+    size_t hash(size_t pos) const
+    {
+        const uint32_t value = (_data[pos] << 16) | (_data[pos + 1] << 8) | _data[pos + 2];
+        return (value * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    const std::span<const uint8_t> _data;
+    const size_t _maxChainDepth;
+    std::vector<uint32_t>& _head;
+    std::vector<uint32_t>& _tail;
+    std::vector<uint32_t>& _next;
+};
+
+size_t encoded_size(size_t items, size_t data_bytes)
+{
+    return 2 + (items + 7) / 8 + data_bytes;
 }
 
-std::vector<uint8_t> LZSSCompressor::compress(const std::vector<uint8_t>& input)
+// Разбор с минимальным числом бит: для каждой позиции с конца выбирается
+// литерал или ссылка любой длины до самого длинного совпадения (более
+// короткая по тому же смещению тоже совпадает). Заполняет parse выбранными
+// ссылками (length 0 - литерал) и возвращает размер жадного разбора.
+size_t optimal_parse(std::span<const uint8_t> data, MatchFinder& finder, std::vector<Match>& parse)
 {
-    std::vector<uint8_t> output;
-    std::vector<uint8_t> flags;
-    uint8_t current_flag = 0;
-    size_t flag_bit = 0;
+    const size_t size = data.size();
+    std::vector<Match> longest(size);
+    for (size_t pos = 0; pos < size; ++pos) {
+        longest[pos] = finder.find(pos);
+        finder.insert(pos);
+    }
 
-    for (size_t pos = 0; pos < input.size();) {
-        Match match = find_match(input, pos);
+    std::vector<size_t> cost(size + 1, 0);
+    parse.assign(size, {0, 0});
+    for (size_t pos = size; pos-- > 0;) {
+        cost[pos] = LITERAL_BITS + cost[pos + 1];
+        for (size_t len = MIN_MATCH_LENGTH; len <= longest[pos].length; ++len) {
+            if (TOKEN_BITS + cost[pos + len] <= cost[pos]) {
+                cost[pos] = TOKEN_BITS + cost[pos + len];
+                parse[pos] = {longest[pos].offset, len};
+            }
+        }
+    }
 
-        if (match.length >= MIN_MATCH_LENGTH && match.offset <= WINDOW_SIZE) {
-            current_flag |= (1 << (7 - flag_bit));
-            uint16_t token = ((match.offset - 1) << 4) | (match.length - MIN_MATCH_LENGTH);
-            output.push_back(token >> 8);
-            output.push_back(token & 0xFF);
-            pos += match.length;
+    size_t items = 0;
+    size_t data_bytes = 0;
+    for (size_t pos = 0; pos < size; ++items) {
+        if (longest[pos].length >= MIN_MATCH_LENGTH) {
+            data_bytes += 2;
+            pos += longest[pos].length;
         } else {
-            output.push_back(input[pos]);
+            data_bytes++;
             pos++;
         }
-
-        flag_bit = (flag_bit + 1) % 8;
-        if (flag_bit == 0) {
-            flags.push_back(current_flag);
-            current_flag = 0;
-        }
     }
-
-    if (flag_bit != 0) flags.push_back(current_flag);
-
-    // Добавляем заголовок с размером флагов (big-endian)
-    uint16_t flag_size = flags.size();
-    std::vector<uint8_t> header = {
-        static_cast<uint8_t>((flag_size >> 8) & 0xFF),
-        static_cast<uint8_t>(flag_size & 0xFF)
-    };
-    output.insert(output.begin(), flags.begin(), flags.end());
-    output.insert(output.begin(), header.begin(), header.end());
-
-    return output;
+    return encoded_size(items, data_bytes);
 }
 
-std::vector<uint8_t> LZSSCompressor::decompress(const std::vector<uint8_t>& input)
+// Обходит элементы сжатых данных: literal(pos) для байта как есть,
+// match(offset, length) для ссылки. Останавливается, если обработчик вернул
+// false. Возвращает размер распакованных данных.
+template<typename Literal, typename Reference>
+size_t for_each_item(std::span<const uint8_t> input, Literal literal, Reference match)
 {
-    if (input.size() < 2) return {};
-
     // Читаем размер флагов (big-endian)
-    size_t flag_bytes = (input[0] << 8) | input[1];
-    if (input.size() < 2 + flag_bytes) return {};
-
-    std::vector<uint8_t> flags(input.begin() + 2, input.begin() + 2 + flag_bytes);
-    std::vector<uint8_t> output;
+    const size_t flag_bytes = (input[0] << 8) | input[1];
+    const auto flags = input.subspan(2, flag_bytes);
     size_t data_pos = 2 + flag_bytes;
     size_t flag_idx = 0;
     size_t bit_idx = 0;
+    size_t size = 0;
 
     while (data_pos < input.size() && flag_idx < flags.size()) {
         bool is_compressed = (flags[flag_idx] & (1 << (7 - bit_idx)));
@@ -102,23 +166,123 @@ std::vector<uint8_t> LZSSCompressor::decompress(const std::vector<uint8_t>& inpu
             uint16_t token = (input[data_pos] << 8) | input[data_pos + 1];
             size_t offset = (token >> 4) + 1;
             size_t length = (token & 0x0F) + MIN_MATCH_LENGTH;
+            // Ссылка раньше начала данных - поток испорчен.
+            if (offset > size || !match(offset, length)) break;
 
-            size_t copy_pos = output.size() - std::min(offset, output.size());
-            for (size_t i = 0; i < length; ++i) {
-                output.push_back(output[copy_pos + (i % offset)]);
-            }
-
+            size += length;
             data_pos += 2;
         } else {
-            output.push_back(input[data_pos]);
+            if (!literal(data_pos)) break;
+
+            size++;
             data_pos++;
         }
 
         bit_idx = (bit_idx + 1) % 8;
         if (bit_idx == 0) flag_idx++;
     }
+    return size;
+}
+
+}
+
+LZSSCompressor::LZSSCompressor(Parsing parsing, size_t maxChainDepth)
+    : _parsing{ parsing }
+    , _maxChainDepth{ maxChainDepth }
+{
+}
+
+const LZSSCompressor::Stats& LZSSCompressor::getStats() const
+{
+    return _stats;
+}
+
+void LZSSCompressor::compressTo(std::span<const uint8_t> input, std::vector<uint8_t>& output)
+{
+    // Флаги стоят в формате перед всеми данными, а их число известно только в
+    // конце, поэтому флаги и данные копятся отдельно и собираются одним копированием.
+    _flags.clear();
+    _flags.reserve(input.size() / 8 + 1);
+    _data.clear();
+    _data.reserve(input.size());
+    uint8_t current_flag = 0;
+    size_t flag_bit = 0;
+    MatchFinder finder{ input, _maxChainDepth, _head, _tail, _next };
+    size_t inserted = 0;
+    std::vector<Match> parse;
+    size_t greedy_size = 0;
+    if (_parsing == Parsing::Optimal) {
+        greedy_size = optimal_parse(input, finder, parse);
+        inserted = input.size();
+    }
+
+    for (size_t pos = 0; pos < input.size();) {
+        Match match = parse.empty() ? finder.find(pos) : parse[pos];
+
+        if (match.length >= MIN_MATCH_LENGTH && match.offset <= WINDOW_SIZE) {
+            current_flag |= (1 << (7 - flag_bit));
+            uint16_t token = static_cast<uint16_t>(((match.offset - 1) << 4) | (match.length - MIN_MATCH_LENGTH));
+            _data.push_back(static_cast<uint8_t>(token >> 8));
+            _data.push_back(static_cast<uint8_t>(token & 0xFF));
+            pos += match.length;
+        } else {
+            _data.push_back(input[pos]);
+            pos++;
+        }
+        for (; inserted < pos; ++inserted) {
+            finder.insert(inserted);
+        }
+
+        flag_bit = (flag_bit + 1) % 8;
+        if (flag_bit == 0) {
+            _flags.push_back(current_flag);
+            current_flag = 0;
+        }
+    }
 
-    return output;
+    if (flag_bit != 0) _flags.push_back(current_flag);
+
+    // В заголовке на размер флагов два байта, больше 0xFFFF * 8 элементов
+    // формат не описывает.
+    if (_flags.size() > 0xFFFF) {
+        throw std::runtime_error("LZSS input is too large: too many flag bytes");
+    }
+
+    // Заголовок с размером флагов (big-endian), флаги, данные
+    const uint16_t flag_size = static_cast<uint16_t>(_flags.size());
+    output.resize(2 + _flags.size() + _data.size());
+    output[0] = static_cast<uint8_t>((flag_size >> 8) & 0xFF);
+    output[1] = static_cast<uint8_t>(flag_size & 0xFF);
+    std::copy(_data.begin(), _data.end(), std::copy(_flags.begin(), _flags.end(), output.begin() + 2));
+
+    _stats.inputBytes += input.size();
+    _stats.greedyBytes += _parsing == Parsing::Optimal ? greedy_size : output.size();
+    _stats.outputBytes += output.size();
+}
+
+void LZSSCompressor::decompressTo(std::span<const uint8_t> input, std::vector<uint8_t>& output)
+{
+    output.clear();
+    if (input.size() < 2 || input.size() < 2 + size_t((input[0] << 8) | input[1])) return;
+
+    // Сначала точный размер, затем один проход без перевыделений.
+    output.resize(for_each_item(input,
+        [](size_t) { return true; },
+        [](size_t, size_t) { return true; }));
+
+    uint8_t* out = output.data();
+    for_each_item(input,
+        [&out, &input](size_t pos) {
+            *out++ = input[pos];
+            return true;
+        },
+        [&out](size_t offset, size_t length) {
+            // Ссылка может перекрывать то, что сама дописывает.
+            for (const uint8_t* from = out - offset; length > 0; --length) {
+                *out++ = *from++;
+            }
+            return true;
+        });
 }
 
 } // namespace common
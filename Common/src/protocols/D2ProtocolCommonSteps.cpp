@@ -184,13 +184,31 @@ namespace {
     bool D2ProtocolCommonSteps::transferData(ICanChannel& channel, uint8_t ecuId, const VBF& data,
                                              const std::function<void(size_t)>& progressCallback)
 	{
-        LOG_MODULE(TRACE) << "transferData enter";
+        return transferData(channel, ecuId, planTransfer(ecuId, data), progressCallback);
+    }
+
+    D2TransferPlan D2ProtocolCommonSteps::planTransfer(uint8_t ecuId, const VBF& data)
+    {
+        D2TransferPlan plan;
+        plan.chunks.reserve(data.chunks.size());
         for(const auto& chunk: data.chunks) {
-            LOG_MODULE(TRACE) << "write chunk " << std::hex << chunk.writeOffset;
-            auto batches = createWriteDataFrames(ecuId, chunk.data, 0, chunk.data.size());
+            plan.chunks.push_back({
+                chunk.writeOffset,
+                static_cast<uint32_t>(chunk.writeOffset + chunk.data.size()),
+                calculateCheckSum(chunk.data, 0, chunk.data.size()),
+                createWriteDataFrames(ecuId, chunk.data, 0, chunk.data.size()) });
+        }
+        return plan;
+    }
 
+    bool D2ProtocolCommonSteps::transferData(ICanChannel& channel, uint8_t ecuId, const D2TransferPlan& plan,
+                                             const std::function<void(size_t)>& progressCallback)
+	{
+        LOG_MODULE(TRACE) << "transferData enter";
+        for(const auto& chunk: plan.chunks) {
+            LOG_MODULE(TRACE) << "write chunk " << std::hex << chunk.writeOffset;
             writeDataOffsetAndCheckAnswer(channel, ecuId, chunk.writeOffset);
-            for (const auto& batch : batches) {
+            for (const auto& batch : chunk.batches) {
                 channel.clearRx();
                 if (!channel.send(batch, 50000)) {
                     throw std::runtime_error("write msgs error");
@@ -198,15 +216,14 @@ namespace {
                 progressCallback(6 * batch.size());
             }
             writeDataOffsetAndCheckAnswer(channel, ecuId, chunk.writeOffset);
-            uint32_t endOffset =  chunk.writeOffset + chunk.data.size();
-            uint8_t checksum = calculateCheckSum(chunk.data, 0, chunk.data.size());
+            const uint32_t endOffset = chunk.endOffset;
             if (!writeMessagesAndCheckAnswer(
                     channel,
                     makeBootloaderFrame(ecuId, {0xB4, static_cast<uint8_t>((endOffset >> 24) & 0xFF),
                                                   static_cast<uint8_t>((endOffset >> 16) & 0xFF),
                                                   static_cast<uint8_t>((endOffset >> 8) & 0xFF),
                                                   static_cast<uint8_t>(endOffset & 0xFF)}),
-                    { 0xB1, checksum }))
+                    { 0xB1, chunk.checksum }))
                 throw std::runtime_error("Failed. Checksums are not equal.");
             }
         LOG_MODULE(TRACE) << "transferData exit";
@@ -0,0 +1,184 @@
+#include "common/protocols/D2ResponseParser.hpp"
+
+#include "common/protocols/D2Error.hpp"
+#include "common/CanFrame.hpp"
+#include "common/Util.hpp"
+
+#define LOG_MODULE_NAME "flasher"
+#include <common/LogHelper.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Каждый фрейм серии несёт не более 7 байт полезных данных.
+constexpr size_t maxResponseSize = 64 * 1024;
+constexpr size_t maxFrameCount = maxResponseSize / 7 + 4;
+
+} // namespace
+
+namespace common {
+
+D2ResponseParser::D2ResponseParser(uint8_t ecuId, const std::vector<uint8_t>& requestId, std::span<uint8_t> output)
+    : _ecuId{ ecuId }
+    , _requestId{ requestId }
+    , _output{ output }
+{
+}
+
+D2ResponseParser::D2ResponseParser(uint8_t ecuId, const std::vector<uint8_t>& requestId, std::vector<uint8_t>& output)
+    : _ecuId{ ecuId }
+    , _requestId{ requestId }
+    , _outputVector{ &output }
+{
+    output.clear();
+}
+
+std::span<const uint8_t> D2ResponseParser::data() const
+{
+    if (_outputVector) {
+        return { _outputVector->data(), _outputVector->size() };
+    }
+    return _output.first(_outputSize);
+}
+
+// Поток ответа: frame[1..] первого кадра + data-байты кадров серии.
+//   нормальный ответ: [0]=ecuId, [1]=requestId[0]+0x40, [2..requestIdSize]=requestId[1..]
+//                      эхо = requestIdSize + 1 байт, может выходить за первый кадр
+//   ошибка:           [0]=ecuId, [1]=0x7F (маркер), [2]=requestId[0] (эхо сервиса) —
+//                      регион 3 байта, [3]=код ошибки (throw D2Error, без кода → 0)
+D2ResponseParser::Status D2ResponseParser::feed(const CanFrame& frame)
+{
+    if (++_frameCount > maxFrameCount) {
+        LOG_MODULE(ERROR) << "Too many frames in D2 response";
+        throw std::runtime_error("Too many frames in D2 response");
+    }
+    const auto& frameData = frame.data;
+    if (frameData.empty()) {
+        LOG_MODULE(ERROR) << "Empty response received:" << dumpArray(frameData);
+        return _state == ParseState::WaitFirst ? Status::Skipped : Status::NeedMore;
+    }
+
+    const uint8_t header = frameData[0];
+    bool endSeries = false;
+    size_t frameDataSize = 0;
+
+    if (_state == ParseState::WaitFirst) {
+        // Классификация первого фрейма: кадр без бита «первого», слишком
+        // короткий или с несовпавшим маркером — чужой трафик, пропускаем.
+        if (!(header & 0x80) || frameData.size() < 3 ||
+            frameData[1] != _ecuId ||
+            (frameData[2] != 0x7F && frameData[2] != _requestId[0] + 0x40)) {
+            return Status::Skipped;
+        }
+        // Заголовок первого фрейма: 0x88..0x8F (серия) / 0xC8..0xCF (single-frame).
+        if ((header & 0x0F) < 0x08) {
+            LOG_MODULE(ERROR) << "Invalid header of first D2 response frame";
+            throw std::runtime_error("Invalid header of first D2 response frame");
+        }
+        _isError = (frameData[2] == 0x7F);
+        _echoRegionSize = _isError ? 3 : _requestId.size() + 1;
+        _expectedSeriesId = 0x09;
+        _state = ParseState::WaitSeries;
+        endSeries = (header & 0x40) != 0;   // single-frame ответ
+        frameDataSize = frameData.size() - 1;
+    }
+    else if (header & 0x40) {
+        // Последний фрейм серии: 0x48..0x4F, длина данных = header - 0x48.
+        if (header < 0x48 || header > 0x4F) {
+            LOG_MODULE(ERROR) << "Wrong data length in series";
+            throw std::runtime_error("Wrong data length in series");
+        }
+        frameDataSize = header - 0x48;
+        if (frameData.size() < 1 + frameDataSize) {
+            LOG_MODULE(ERROR) << "Wrong data length in series";
+            throw std::runtime_error("Wrong data length in series");
+        }
+        endSeries = true;
+    }
+    else {
+        // Серийный кадр: seriesId обязан идти по порядку 0x09→0x0A→…→0x0F→0x08→…
+        if (header != _expectedSeriesId) {
+            LOG_MODULE(ERROR) << "Unexpected seriesId in D2 response";
+            throw std::runtime_error("Unexpected seriesId in D2 response");
+        }
+        _expectedSeriesId = 0x08 + ((header - 0x08 + 1) & 0x07);
+        frameDataSize = frameData.size() - 1;
+    }
+
+    if (!consume(frameData.data() + 1, frameDataSize)) {
+        // Эхо не совпало — чужой трафик: сброс и ждём новый первый кадр.
+        LOG_MODULE(DEBUG) << "D2 response echo mismatch, waiting for new first frame";
+        reset();
+        return Status::Skipped;
+    }
+    if (_isError && _streamSize >= _echoRegionSize) {
+        LOG_MODULE(ERROR) << "D2 respond with error: " << static_cast<int>(_errorCode);
+        throw D2Error(_streamSize > _echoRegionSize ? _errorCode : 0);
+    }
+
+    if (endSeries) {
+        if (_streamSize < _echoRegionSize) {
+            LOG_MODULE(ERROR) << "D2 response ended before requestId echo completed";
+            throw std::runtime_error("D2 response ended before requestId echo completed");
+        }
+        return Status::Complete;
+    }
+    return Status::NeedMore;
+}
+
+bool D2ResponseParser::consume(const uint8_t* data, size_t size)
+{
+    if (_streamSize + size > maxResponseSize) {
+        LOG_MODULE(ERROR) << "D2 response too large";
+        throw std::runtime_error("D2 response too large");
+    }
+
+    // Эхо-префикс сверяется побайтно и в выходной буфер не попадает.
+    size_t pos = 0;
+    for (; pos < size && _streamSize < _echoRegionSize; ++pos, ++_streamSize) {
+        if (_isError) {
+            continue;
+        }
+        const uint8_t expected = (_streamSize == 0) ? _ecuId
+                                 : (_streamSize == 1) ? _requestId[0] + 0x40
+                                 : _requestId[_streamSize - 1];
+        if (data[pos] != expected) {
+            return false;
+        }
+    }
+    if (pos == size) {
+        return true;
+    }
+
+    const size_t payloadSize = size - pos;
+    if (_isError) {
+        _errorCode = data[pos];
+    }
+    else if (_outputVector) {
+        _outputVector->insert(_outputVector->end(), data + pos, data + size);
+        _outputSize += payloadSize;
+    }
+    else {
+        const size_t bytes = std::min(payloadSize, _output.size() - _outputSize);
+        std::copy_n(data + pos, bytes, _output.begin() + _outputSize);
+        _outputSize += bytes;
+        _truncated = _truncated || bytes < payloadSize;
+    }
+    _streamSize += payloadSize;
+    return true;
+}
+
+void D2ResponseParser::reset()
+{
+    _state = ParseState::WaitFirst;
+    _streamSize = 0;
+    _outputSize = 0;
+    _truncated = false;
+    if (_outputVector) {
+        _outputVector->clear();
+    }
+}
+
+} // namespace common
@@ -9,6 +9,7 @@
 #include "common/LogHelper.hpp"
 
 #include <array>
+#include <future>
 #include <thread>
 #include <variant>
 
@@ -105,7 +106,8 @@ namespace common {
         LOG_MODULE(TRACE) << "eraseFlash exit (VBF)";
 	}
 
-	size_t KWPProtocolCommonSteps::requestDownload(const RequestProcessorBase& requestProcessor, const VBFChunk& chunk)
+	size_t KWPProtocolCommonSteps::requestDownload(const RequestProcessorBase& requestProcessor, const VBFChunk& chunk,
+		uint8_t dataFormat)
     {
         LOG_MODULE(TRACE) << "requestDownload enter";
 		try {
@@ -113,7 +115,7 @@ namespace common {
 			const auto dataSize = chunk.data.size();
 			const auto downloadResponse{ requestProcessor.process({ 0x34 },
 				{ (startAddr >> 16) & 0xFF, (startAddr >> 8) & 0xFF, startAddr & 0xFF,
-				0x11,
+				dataFormat,
 				(dataSize >> 16) & 0xFF, (dataSize >> 8) & 0xFF, dataSize & 0xFF }) };
             return encodeBigEndian(downloadResponse[1], downloadResponse[0]) - 2;;
 		}
@@ -143,21 +145,34 @@ namespace common {
 
 	bool KWPProtocolCommonSteps::transferData(const RequestProcessorBase& requestProcessor, const VBFChunk& chunk,
 		size_t maxSizeToTransfer, const std::function<void(size_t)>& progressCallback)
+	{
+		return transferData(requestProcessor, chunk, chunk.data, maxSizeToTransfer, progressCallback);
+	}
+
+	bool KWPProtocolCommonSteps::transferData(const RequestProcessorBase& requestProcessor, const VBFChunk& chunk,
+		const std::vector<uint8_t>& encoded, size_t maxSizeToTransfer, const std::function<void(size_t)>& progressCallback)
 	{
         LOG_MODULE(TRACE) << "transferData enter (chunk)";
         try {
+			// CRC считается в фоне, пока данные идут по шине, и к концу передачи уже готов.
+			auto crc{ std::async(std::launch::async, [&chunk]() {
+				return crc32(chunk.data.data(), chunk.data.size());
+			}) };
 			maxSizeToTransfer -= 5;
-			for (size_t i = 0; i < chunk.data.size(); i += maxSizeToTransfer) {
-				const auto chunkEnd{ std::min(i + maxSizeToTransfer, chunk.data.size()) };
+			size_t reported = 0;
+			for (size_t i = 0; i < encoded.size(); i += maxSizeToTransfer) {
+				const auto chunkEnd{ std::min(i + maxSizeToTransfer, encoded.size()) };
 				std::vector<uint8_t> dataToTransfer;
-				dataToTransfer.insert(dataToTransfer.end(), chunk.data.cbegin() + i, chunk.data.cbegin() + chunkEnd);
+				dataToTransfer.insert(dataToTransfer.end(), encoded.cbegin() + i, encoded.cbegin() + chunkEnd);
 				requestProcessor.process({ 0x36 }, std::move(dataToTransfer), 60000);
-				progressCallback(chunkEnd - i);
+				const size_t done = chunk.data.size() * chunkEnd / encoded.size();
+				progressCallback(done - reported);
+				reported = done;
 			}
 			const auto transferExitResponse{ requestProcessor.process({ 0x37 }) };
-			// TODO: add calculation of chunks' CRC32 here and check for download results
-				//&& transferExitResponse[2] == static_cast<uint8_t>(chunk.crc >> 8)
-				//&& transferExitResponse[2] == static_cast<uint8_t>(chunk.crc);
+			if (!checkMemory(requestProcessor, chunk, crc.get())) {
+				return false;
+			}
 		}
 		catch (...) {
 			return false;
@@ -166,6 +181,37 @@ namespace common {
 		return true;
 	}
 
+	bool KWPProtocolCommonSteps::checkMemory(const RequestProcessorBase& requestProcessor, const VBFChunk& chunk, uint32_t crc)
+	{
+        LOG_MODULE(TRACE) << "checkMemory enter";
+		std::vector<uint8_t> checksumResult;
+		try {
+			const auto startAddr = toVector(chunk.writeOffset);
+			const auto endAddr = toVector(chunk.writeOffset + static_cast<uint32_t>(chunk.data.size()) - 1);
+			requestProcessor.process({ 0x31, 0xC5 }, {
+				startAddr[1], startAddr[2], startAddr[3],
+				endAddr[1], endAddr[2], endAddr[3] }, 10000);
+			checksumResult = requestProcessor.process({ 0x33, 0xC5 }, {}, 10000);
+		}
+		catch (const std::exception& ex) {
+			// Не все загрузчики умеют считать контрольную сумму, прошивку это не останавливает.
+			LOG_MODULE(WARNING) << "Checksum routine failed, chunk isn't verified, ex = " << ex.what();
+			return true;
+		}
+		if (checksumResult.size() < 6) {
+			LOG_MODULE(WARNING) << "Checksum routine returned no CRC, chunk isn't verified";
+			return true;
+		}
+		const auto ecuCrc = encodeBigEndian(checksumResult[5], checksumResult[4], checksumResult[3], checksumResult[2]);
+		if (ecuCrc != crc) {
+			LOG_MODULE(ERROR) << "Chunk CRC32 mismatch, offset = " << std::hex << chunk.writeOffset
+				<< ", data crc = " << crc << ", ECU crc = " << ecuCrc;
+			return false;
+		}
+        LOG_MODULE(TRACE) << "checkMemory exit";
+		return true;
+	}
+
 	bool KWPProtocolCommonSteps::startRoutine(const RequestProcessorBase& requestProcessor, uint32_t addr)
     {
         LOG_MODULE(TRACE) << "startRoutine enter addr: " << std::hex << addr;
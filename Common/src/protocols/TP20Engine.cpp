@@ -0,0 +1,401 @@
+#include "common/protocols/TP20Engine.hpp"
+
+#include "common/protocols/TP20Service.hpp"
+#include "common/ICanChannel.hpp"
+#include "common/Util.hpp"
+
+#define LOG_MODULE_NAME "common"
+#include "common/LogHelper.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace common {
+
+namespace {
+
+constexpr uint32_t ChannelSetupCanId{ 0x200 };
+// Id приёма, который запрашивается у ЭБУ; следующему каналу - следующий.
+constexpr uint32_t FirstRxCanId{ 0x300 };
+
+constexpr std::chrono::milliseconds SetupTimeout{ 1000 };
+constexpr std::chrono::milliseconds ParametersTimeout{ 2000 };
+constexpr std::chrono::milliseconds AckTimeout{ 10000 };
+constexpr unsigned long KeepAliveInterval{ 1000 };
+
+constexpr size_t MaxFrameSize{ 8 };
+// Первый кадр сообщения несёт длину, в нём 5 байт данных, в остальных 7.
+constexpr size_t FirstFrameHeaderSize{ 3 };
+constexpr size_t MaxMessageSize{ 4096 };
+
+// Код операции - старшая тетрада первого байта кадра данных.
+constexpr uint8_t WaitAckMoreFollows{ 0x00 };
+constexpr uint8_t WaitAckLast{ 0x10 };
+constexpr uint8_t NoAckMoreFollows{ 0x20 };
+constexpr uint8_t NotReadyAck{ 0x90 };
+constexpr uint8_t Ack{ 0xB0 };
+
+constexpr uint8_t ChannelTest{ 0xA3 };
+constexpr uint8_t Disconnect{ 0xA8 };
+
+} // namespace
+
+TP20Engine::Channel::Channel(uint8_t ecuId, uint32_t ecuCanId, uint32_t rxId, std::chrono::microseconds frameTime)
+    : ecuId{ ecuId }
+    , ecuCanId{ ecuCanId }
+    , rxId{ rxId }
+    , deadline{ Clock::now() + SetupTimeout }
+    , pacer{ {}, frameTime }
+{
+}
+
+TP20Engine::TP20Engine(ICanChannel& channel)
+    : _channel{ channel }
+    , _frameTime{ FramePacer::frameTimeForBaudrate(channel.getBaudrate()) }
+{
+}
+
+TP20Engine::~TP20Engine()
+{
+    for (size_t i = 0; i < _channels.size(); ++i) {
+        close(i);
+    }
+}
+
+size_t TP20Engine::open(CarPlatform carPlatform, uint8_t ecuId)
+{
+    const auto ecuCanId{ std::get<1>(getEcuInfoByEcuId(carPlatform, ecuId)).canId };
+    const uint32_t rxId{ FirstRxCanId + static_cast<uint32_t>(_channels.size()) };
+    auto& channel{ _channels.emplace_back(ecuId, ecuCanId, rxId, _frameTime) };
+    // Канал J2534 открывается с фильтром только для первого ЭБУ.
+    channel.setupFilter = startPassFilter(ecuCanId, channel.setupFilterId);
+    if (!channel.setupFilter) {
+        fail(channel, "failed to start channel setup filter");
+        return _channels.size() - 1;
+    }
+    const bool sent{ _channel.send({ ChannelSetupCanId,
+        { ecuId, TP20ServiceID::ChannelSetup, 0x00, 0x10, static_cast<uint8_t>(rxId & 0xFF),
+          static_cast<uint8_t>((rxId >> 8) & 0xFF), 0x01 } }) };
+    if (!sent) {
+        fail(channel, "failed to send channel setup");
+    }
+    return _channels.size() - 1;
+}
+
+void TP20Engine::close(size_t channelIndex)
+{
+    auto& channel{ _channels.at(channelIndex) };
+    if (channel.keepAlive) {
+        _channel.stopPeriodicMsg(channel.keepAliveId);
+        channel.keepAlive = false;
+    }
+    if (channel.filter) {
+        _channel.stopMsgFilter(channel.filterId);
+        channel.filter = false;
+    }
+    if (channel.setupFilter) {
+        _channel.stopMsgFilter(channel.setupFilterId);
+        channel.setupFilter = false;
+    }
+    channel.state = State::Closed;
+    channel.message = {};
+    channel.waitingAck = false;
+}
+
+bool TP20Engine::write(size_t channelIndex, std::span<const uint8_t> message)
+{
+    auto& channel{ _channels.at(channelIndex) };
+    if (message.size() > MaxMessageSize) {
+        throw std::runtime_error("Can't send request. Datasize too long");
+    }
+    if (channel.state != State::Open || isSending(channelIndex)) {
+        return false;
+    }
+    channel.message = message;
+    channel.offset = 0;
+    // Последний кадр прошлого сообщения подтверждён, блок начинается заново.
+    channel.packetsTillAck = channel.blockSize;
+    return true;
+}
+
+bool TP20Engine::isConnecting(size_t channel) const
+{
+    const auto state{ _channels.at(channel).state };
+    return state == State::Setup || state == State::Parameters;
+}
+
+bool TP20Engine::isConnected(size_t channel) const
+{
+    return _channels.at(channel).state == State::Open;
+}
+
+bool TP20Engine::isSending(size_t channelIndex) const
+{
+    const auto& channel{ _channels.at(channelIndex) };
+    return channel.offset < channel.message.size() || channel.waitingAck;
+}
+
+bool TP20Engine::hasMessage(size_t channel) const
+{
+    return !_channels.at(channel).messages.empty();
+}
+
+std::vector<uint8_t> TP20Engine::takeMessage(size_t channelIndex)
+{
+    auto& messages{ _channels.at(channelIndex).messages };
+    if (messages.empty()) {
+        return {};
+    }
+    auto message{ std::move(messages.front()) };
+    messages.pop_front();
+    return message;
+}
+
+void TP20Engine::poll(std::chrono::milliseconds timeout)
+{
+    auto now{ Clock::now() };
+    auto next{ now + timeout };
+    for (auto& channel : _channels) {
+        onTimer(channel, now);
+        if (channel.state == State::Setup || channel.state == State::Parameters || channel.waitingAck) {
+            next = std::min(next, channel.deadline);
+        }
+        else if (channel.offset < channel.message.size()) {
+            next = std::min(next, channel.pacer.getDeadline() - FramePacer::SleepMargin);
+        }
+    }
+    now = Clock::now();
+    const auto wait{ next > now ? std::chrono::ceil<std::chrono::milliseconds>(next - now).count() : 0 };
+    if (_channel.receive(_rxFrame, static_cast<unsigned long>(wait))) {
+        onFrame(_rxFrame);
+    }
+}
+
+void TP20Engine::onTimer(Channel& channel, Clock::time_point now)
+{
+    switch (channel.state) {
+    case State::Setup:
+    case State::Parameters:
+        if (now >= channel.deadline) {
+            fail(channel, "channel setup timeout");
+        }
+        break;
+    case State::Open:
+        if (channel.waitingAck) {
+            if (now >= channel.deadline) {
+                fail(channel, "ack timeout");
+            }
+        }
+        else if (channel.offset < channel.message.size()
+            && now + FramePacer::SleepMargin >= channel.pacer.getDeadline()) {
+            sendBlock(channel);
+        }
+        break;
+    case State::Closed:
+        break;
+    }
+}
+
+void TP20Engine::onFrame(const CanFrame& frame)
+{
+    if (frame.data.empty()) {
+        return;
+    }
+    for (auto& channel : _channels) {
+        if (channel.state == State::Setup && frame.id == channel.ecuCanId) {
+            onSetupResponse(channel, frame);
+            return;
+        }
+        if (channel.state == State::Closed || frame.id != channel.rxId) {
+            continue;
+        }
+        const uint8_t op = frame.data[0] & 0xF0;
+        if (channel.state == State::Parameters) {
+            onParametersResponse(channel, frame);
+        }
+        else if (frame.data[0] == Disconnect) {
+            LOG_MODULE(INFO) << "TP20 channel to ECU " << std::hex << static_cast<int>(channel.ecuId) << " is closed by ECU";
+            close(&channel - _channels.data());
+        }
+        else if (op == Ack && channel.waitingAck) {
+            channel.waitingAck = false;
+            channel.packetsTillAck = channel.blockSize;
+        }
+        else if (op == NotReadyAck && channel.waitingAck) {
+            channel.deadline = Clock::now() + AckTimeout;
+        }
+        else if (op <= 0x30) {
+            onDataFrame(channel, frame);
+        }
+        // 0xA1 - ответ на keep-alive.
+        return;
+    }
+}
+
+void TP20Engine::onSetupResponse(Channel& channel, const CanFrame& frame)
+{
+    const auto& data{ frame.data };
+    if (data.size() < 6 || data[0] != 0 || data[1] != TP20ServiceID::ChannelSetupPositiveResponse
+        || encodeBigEndian(data[2], data[3]) != channel.rxId) {
+        fail(channel, "channel setup rejected");
+        return;
+    }
+    channel.txId = encodeBigEndian(data[4], data[5]);
+    channel.filter = startPassFilter(channel.rxId, channel.filterId);
+    if (!channel.filter) {
+        fail(channel, "failed to start channel filter");
+        return;
+    }
+    channel.state = State::Parameters;
+    channel.deadline = Clock::now() + ParametersTimeout;
+    if (!_channel.send({ channel.txId, { TP20ServiceID::SetupChannelParameters, 0xF, 0x8A, 0xFF, 0x32, 0xFF } })) {
+        fail(channel, "failed to send channel parameters");
+    }
+}
+
+void TP20Engine::onParametersResponse(Channel& channel, const CanFrame& frame)
+{
+    const auto& data{ frame.data };
+    if (data.size() < 6 || data[0] != TP20ServiceID::SetupChannelParametersPositiveResponse) {
+        return;
+    }
+    // Размер блока: сколько кадров ЭБУ принимает до подтверждения.
+    channel.blockSize = std::max<uint8_t>(data[1], 1);
+    channel.packetsTillAck = channel.blockSize;
+    channel.sendCounter = 0;
+    channel.pacer.setInterval(decodeTimingParameter(data[4]));
+    LOG_MODULE(DEBUG) << "TP20 minimum send delay: " << channel.pacer.getInterval().count() << " us";
+    channel.keepAlive = _channel.startPeriodicMsg({ channel.txId, { ChannelTest } }, KeepAliveInterval, channel.keepAliveId);
+    channel.state = State::Open;
+}
+
+void TP20Engine::onDataFrame(Channel& channel, const CanFrame& frame)
+{
+    // Ответ пришёл - значит, ЭБУ принял запрос, даже если ACK потерялся.
+    if (channel.offset == channel.message.size()) {
+        channel.waitingAck = false;
+    }
+    const uint8_t op = frame.data[0] & 0xF0;
+    const size_t dataOffset{ channel.receiving ? 1 : FirstFrameHeaderSize };
+    if (frame.data.size() < dataOffset) {
+        return;
+    }
+    if (!channel.receiving) {
+        // Буфер под весь ответ выделяется один раз по длине из заголовка.
+        channel.responseSize = (frame.data[1] << 8) | frame.data[2];
+        channel.received.reserve(channel.responseSize);
+        channel.receiving = true;
+    }
+    const auto size{ std::min(frame.data.size() - dataOffset, channel.responseSize - channel.received.size()) };
+    channel.received.insert(channel.received.end(), frame.data.cbegin() + dataOffset,
+        frame.data.cbegin() + dataOffset + size);
+    // ЭБУ не шлёт следующий блок, пока этот не подтверждён.
+    if (!(op & NoAckMoreFollows) && !sendAck(channel, frame.data[0] + 1)) {
+        fail(channel, "failed to send ack");
+        return;
+    }
+    if (op & WaitAckLast) {
+        channel.messages.push_back(std::move(channel.received));
+        channel.received = {};
+        channel.receiving = false;
+    }
+}
+
+void TP20Engine::sendBlock(Channel& channel)
+{
+    // Кадры до конца блока ЭБУ принимает без подтверждения, они уходят
+    // одной пачкой, если интервал ЭБУ позволяет отправить их подряд.
+    const size_t count{ channel.pacer.wait(std::min<size_t>(channel.packetsTillAck, remainingFrames(channel))) };
+    auto& frames{ takeFrames(count) };
+    for (auto& frame : frames) {
+        fillFrame(channel, frame);
+    }
+    const auto result{ count == 1 ? _channel.send(frames.front()) : _channel.send(frames) };
+    channel.pacer.sent();
+    if (!result) {
+        fail(channel, "failed to send data");
+        return;
+    }
+    if (channel.packetsTillAck == 0 || channel.offset == channel.message.size()) {
+        channel.waitingAck = true;
+        channel.deadline = Clock::now() + AckTimeout;
+    }
+}
+
+bool TP20Engine::sendAck(Channel& channel, uint8_t counter)
+{
+    channel.pacer.wait();
+    const uint8_t ack = Ack | (counter & 0x0F);
+    const auto result{ _channel.send(channel.txId, { &ack, 1 }, {}) };
+    channel.pacer.sent();
+    return result;
+}
+
+void TP20Engine::fail(Channel& channel, const char* reason)
+{
+    LOG_MODULE(ERROR) << "TP20 channel to ECU " << std::hex << static_cast<int>(channel.ecuId) << ": " << reason;
+    close(&channel - _channels.data());
+}
+
+bool TP20Engine::startPassFilter(uint32_t canId, unsigned long& filterId)
+{
+    const unsigned long passFilter = 0x00000001;
+    return _channel.startMsgFilter(passFilter, { 0xFFFFFFFF, {} }, { canId, {} }, nullptr, filterId);
+}
+
+std::vector<CanFrame>& TP20Engine::takeFrames(size_t count)
+{
+    while (_frames.size() > count) {
+        _spareFrames.push_back(std::move(_frames.back()));
+        _frames.pop_back();
+    }
+    while (_frames.size() < count) {
+        if (_spareFrames.empty()) {
+            _frames.emplace_back().data.reserve(MaxFrameSize);
+        }
+        else {
+            _frames.push_back(std::move(_spareFrames.back()));
+            _spareFrames.pop_back();
+        }
+    }
+    return _frames;
+}
+
+/*static*/ size_t TP20Engine::remainingFrames(const Channel& channel)
+{
+    const auto headerSize{ channel.offset == 0 ? FirstFrameHeaderSize : 1 };
+    const auto remaining{ channel.message.size() - channel.offset };
+    if (remaining <= MaxFrameSize - headerSize) {
+        return 1;
+    }
+    return 1 + (remaining - (MaxFrameSize - headerSize) + MaxFrameSize - 2) / (MaxFrameSize - 1);
+}
+
+/*static*/ void TP20Engine::fillFrame(Channel& channel, CanFrame& frame)
+{
+    const auto& message{ channel.message };
+    frame.id = channel.txId;
+    frame.data.resize(1);
+    if (channel.offset == 0) {
+        frame.data.push_back((message.size() >> 8) & 0xFF);
+        frame.data.push_back(message.size() & 0xFF);
+    }
+    const auto size{ std::min(MaxFrameSize - frame.data.size(), message.size() - channel.offset) };
+    const auto data{ message.subspan(channel.offset, size) };
+    frame.data.insert(frame.data.end(), data.begin(), data.end());
+    channel.offset += size;
+    --channel.packetsTillAck;
+    const bool last{ channel.offset == message.size() };
+    const uint8_t op{ last ? WaitAckLast : channel.packetsTillAck == 0 ? WaitAckMoreFollows : NoAckMoreFollows };
+    frame.data[0] = op | (channel.sendCounter++ & 0x0F);
+}
+
+/*static*/ std::chrono::microseconds TP20Engine::decodeTimingParameter(uint8_t parameter)
+{
+    // Биты 7-6 - единица: 0.1 мс, 1 мс, 10 мс, 100 мс; биты 5-0 - значение.
+    static constexpr std::array<std::chrono::microseconds::rep, 4> Units{ 100, 1000, 10000, 100000 };
+    return std::chrono::microseconds{ (parameter & 0x3F) * Units[parameter >> 6] };
+}
+
+} // namespace common
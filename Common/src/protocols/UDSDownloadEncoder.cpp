@@ -0,0 +1,169 @@
+#include "common/protocols/UDSDownloadEncoder.hpp"
+
+#include "common/compression/CompressionSelector.hpp"
+#include "common/compression/CompressorBase.hpp"
+#include "common/compression/CompressorFactory.hpp"
+#include "common/compression/LZSSCompressor.hpp"
+#include "common/encryption/EncryptorBase.hpp"
+#include "common/encryption/EncryptorFactory.hpp"
+
+#define LOG_MODULE_NAME "common"
+#include "common/LogHelper.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace common {
+
+namespace {
+
+// Для оценки времени на шине: прошивка UDS идёт по HS-CAN 500 кбит/с.
+constexpr unsigned long FlashBaudrate = 500000;
+
+size_t getWorkerCount(size_t workers)
+{
+    return workers != 0 ? workers : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+} // namespace
+
+UDSDownloadEncoder::UDSDownloadEncoder(CompressionType compressionType, EncryptionType encryptionType,
+                                       std::map<std::string, std::string>&& encryptionParams,
+                                       bool optimalCompression, size_t workers)
+    : _compressionType{ compressionType }
+    , _encryptionType{ encryptionType }
+    , _encryptionParams{ std::move(encryptionParams) }
+    , _optimalCompression{ optimalCompression }
+    , _workerCount{ getWorkerCount(workers) }
+    , _readyAhead{ _workerCount + 1 }
+{
+    // Здесь же проверяются параметры шифрования, пока загрузка не началась.
+    auto params = _encryptionParams;
+    const bool compressed = CompressorFactory::create(_compressionType) != nullptr;
+    const bool encrypted = EncryptorFactory::create(_encryptionType, std::move(params)) != nullptr;
+    // Какой именно алгоритм скрывается за методом 1, ЭБУ знает сам.
+    _dataFormatIdentifier = (compressed ? 0x10 : 0x00) | (encrypted ? 0x01 : 0x00);
+}
+
+UDSDownloadEncoder::~UDSDownloadEncoder()
+{
+    stop();
+}
+
+uint8_t UDSDownloadEncoder::getDataFormatIdentifier() const
+{
+    return _dataFormatIdentifier;
+}
+
+void UDSDownloadEncoder::start(const VBF& data)
+{
+    stop();
+    _data = &data;
+    _promises = std::vector<std::promise<std::vector<uint8_t>>>(data.chunks.size());
+    _encoded.clear();
+    for (auto& promise : _promises) {
+        _encoded.push_back(promise.get_future().share());
+    }
+    _nextChunk = 0;
+    _requested = 0;
+    _stopping = false;
+    _inputBytes = _greedyBytes = _outputBytes = 0;
+    const size_t workers = std::min(_workerCount, data.chunks.size());
+    _activeWorkers = workers;
+    for (size_t i = 0; i < workers; ++i) {
+        _workers.push_back(std::async(std::launch::async, &UDSDownloadEncoder::encodeChunks, this));
+    }
+}
+
+const std::vector<uint8_t>& UDSDownloadEncoder::get(const VBFChunk& chunk)
+{
+    for (size_t i = 0; _data && i < _data->chunks.size(); ++i) {
+        if (&_data->chunks[i] == &chunk) {
+            {
+                std::lock_guard<std::mutex> lock{ _mutex };
+                _requested = std::max(_requested, i + 1);
+            }
+            _condition.notify_all();
+            return _encoded[i].get();
+        }
+    }
+    throw std::runtime_error("Chunk isn't prepared for download");
+}
+
+void UDSDownloadEncoder::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock{ _mutex };
+        _stopping = true;
+    }
+    _condition.notify_all();
+    for (auto& worker : _workers) {
+        worker.wait();
+    }
+    _workers.clear();
+}
+
+void UDSDownloadEncoder::encodeChunks()
+{
+    const auto compressor = CompressorFactory::create(_compressionType, _optimalCompression);
+    auto params = _encryptionParams;
+    const auto encryptor = EncryptorFactory::create(_encryptionType, std::move(params));
+    const size_t count = _data->chunks.size();
+    for (;;) {
+        size_t i = 0;
+        {
+            std::unique_lock<std::mutex> lock{ _mutex };
+            _condition.wait(lock, [this, count]() {
+                return _stopping || _nextChunk >= count || _nextChunk < _requested + _readyAhead;
+            });
+            if (_stopping || _nextChunk >= count) {
+                break;
+            }
+            i = _nextChunk++;
+        }
+        try {
+            std::vector<uint8_t> result;
+            if (compressor) {
+                compressor->compressTo(_data->chunks[i].data, result);
+            } else {
+                result = _data->chunks[i].data;
+            }
+            if (encryptor) {
+                result = encryptor->encrypt(result);
+            }
+            LOG_MODULE(DEBUG) << "Chunk " << std::hex << _data->chunks[i].writeOffset << " prepared, "
+                              << std::dec << _data->chunks[i].data.size() << " -> " << result.size() << " bytes";
+            _promises[i].set_value(std::move(result));
+        }
+        catch (...) {
+            _promises[i].set_exception(std::current_exception());
+        }
+    }
+
+    std::unique_lock<std::mutex> lock{ _mutex };
+    if (const auto lzss = dynamic_cast<const LZSSCompressor*>(compressor.get())) {
+        _inputBytes += lzss->getStats().inputBytes;
+        _greedyBytes += lzss->getStats().greedyBytes;
+        _outputBytes += lzss->getStats().outputBytes;
+    }
+    if (--_activeWorkers == 0 && !_stopping) {
+        reportCompression(_inputBytes, _greedyBytes, _outputBytes);
+    }
+}
+
+void UDSDownloadEncoder::reportCompression(size_t inputBytes, size_t greedyBytes, size_t outputBytes) const
+{
+    if (!_optimalCompression || greedyBytes <= outputBytes) {
+        return;
+    }
+    const size_t saved = greedyBytes - outputBytes;
+    const auto savedTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+        CompressionSelector::estimateTransferTime(saved, FlashBaudrate));
+    LOG_MODULE(INFO) << "LZSS optimal parse: " << inputBytes << " -> " << outputBytes
+                     << " bytes, " << saved << " bytes less than greedy, about " << savedTime.count()
+                     << " ms less on the bus";
+}
+
+} // namespace common
@@ -0,0 +1,97 @@
+#include "common/protocols/UDSPinCache.hpp"
+
+#define LOG_MODULE_NAME "common"
+#include "common/LogHelper.hpp"
+
+#include <istream>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <utility>
+
+namespace common {
+
+namespace {
+
+// Так старые версии писали в файл PIN без VIN, такие строки пропускаются.
+constexpr const char* UnknownVin = "-";
+
+std::mutex& cacheMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::map<std::pair<std::string, uint32_t>, uint64_t>& cachedPins()
+{
+    static std::map<std::pair<std::string, uint32_t>, uint64_t> pins;
+    return pins;
+}
+
+} // namespace
+
+std::optional<uint64_t> UDSPinCache::find(const std::string& vin, uint32_t canId)
+{
+    if (vin.empty()) {
+        return std::nullopt;
+    }
+    std::unique_lock<std::mutex> lock(cacheMutex());
+    const auto it = cachedPins().find({ vin, canId });
+    if (it == cachedPins().end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void UDSPinCache::store(const std::string& vin, uint32_t canId, uint64_t pin)
+{
+    if (vin.empty()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(cacheMutex());
+    cachedPins()[{ vin, canId }] = pin;
+}
+
+void UDSPinCache::erase(const std::string& vin, uint32_t canId)
+{
+    std::unique_lock<std::mutex> lock(cacheMutex());
+    cachedPins().erase({ vin, canId });
+}
+
+void UDSPinCache::clear()
+{
+    std::unique_lock<std::mutex> lock(cacheMutex());
+    cachedPins().clear();
+}
+
+void UDSPinCache::load(std::istream& input)
+{
+    std::unique_lock<std::mutex> lock(cacheMutex());
+    std::string line;
+    while (std::getline(input, line)) {
+        std::istringstream stream{ line };
+        std::string vin;
+        uint32_t canId = 0;
+        uint64_t pin = 0;
+        if (!(stream >> vin >> std::hex >> canId >> pin)) {
+            LOG_MODULE(ERROR) << "Wrong PIN cache line: " << line;
+            continue;
+        }
+        if (vin == UnknownVin) {
+            continue;
+        }
+        cachedPins()[{ vin, canId }] = pin;
+    }
+}
+
+void UDSPinCache::save(std::ostream& output)
+{
+    std::unique_lock<std::mutex> lock(cacheMutex());
+    for (const auto& [key, pin] : cachedPins()) {
+        output << key.first << " " << std::hex << key.second << " " << pin
+               << std::dec << std::endl;
+    }
+}
+
+} // namespace common
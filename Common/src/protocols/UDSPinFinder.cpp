@@ -1,6 +1,7 @@
 #include "common/protocols/UDSPinFinder.hpp"
 #include "common/CanIdProvider.hpp"
 
+#include "common/protocols/UDSPinCache.hpp"
 #include "common/protocols/UDSProtocolCommonSteps.hpp"
 #include "common/ICanChannel.hpp"
 #include "common/Util.hpp"
@@ -10,6 +11,7 @@
 
 #include <array>
 #include <optional>
+#include <string>
 
 namespace common {
 
@@ -67,6 +69,9 @@ namespace common {
         void fallAsleep()
         {
             setCurrentState(UDSPinFinder::State::FallAsleep);
+            // VIN для кэша PIN, пока ЭБУ ещё в сессии по умолчанию.
+            _vin = UDSProtocolCommonSteps::readVin(getChannelByEcuId(_finderData.carPlatform, _finderData.ecuId, _channels),
+                                                   _canIdProvider->getPhysCanId());
             if (!common::UDSProtocolCommonSteps::fallAsleep(_channels, _canIdProvider->getFuncCanId())) {
                 setFailed();
             }
@@ -90,6 +95,7 @@ namespace common {
             }
             else {
                 _foundPin = _currentPin;
+                UDSPinCache::store(_vin, _canIdProvider->getPhysCanId(), _currentPin);
                 return true;
             }
         }
@@ -166,6 +172,7 @@ namespace common {
         bool _stop;
         bool _isFailed;
         std::optional<uint64_t> _foundPin;
+        std::string _vin;
 
     };
 
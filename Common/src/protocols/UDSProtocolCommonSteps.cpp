@@ -1,6 +1,9 @@
 #include "common/protocols/UDSProtocolCommonSteps.hpp"
 
+#include "common/protocols/UDSDownloadEncoder.hpp"
 #include "common/protocols/UDSRequest.hpp"
+#include "common/protocols/UDSRoutineControl.hpp"
+#include "common/protocols/UDSTransferData.hpp"
 #include "common/protocols/UDSError.hpp"
 #include "common/ICanChannel.hpp"
 #include "common/KeyGenerators.hpp"
@@ -14,6 +17,53 @@
 
 namespace common {
 
+namespace {
+
+// RequestDownload, блоки TransferData и RequestTransferExit для одного чанка.
+// С encoder передаются подготовленные им данные, а в 0x34 объявляется их формат.
+bool downloadChunk(ICanChannel& channel, uint32_t canId, const VBFChunk& chunk,
+                   const std::function<void(size_t)>& progressCallback, const UDSTiming& timing,
+                   UDSDownloadEncoder* encoder)
+{
+    const auto startAddr = chunk.writeOffset;
+    const auto dataSize = chunk.data.size();
+    const uint8_t dataFormat = encoder ? encoder->getDataFormatIdentifier() : 0x00;
+    const auto& data = dataFormat != 0x00 ? encoder->get(chunk) : chunk.data;
+    UDSRequest requestDownloadRequest{ canId, { 0x34, dataFormat, 0x44,
+        (startAddr >> 24) & 0xFF, (startAddr >> 16) & 0xFF, (startAddr >> 8) & 0xFF, startAddr & 0xFF,
+        (dataSize >> 24) & 0xFF, (dataSize >> 16) & 0xFF, (dataSize >> 8) & 0xFF, dataSize & 0xFF }, timing };
+    const auto downloadResponse{ requestDownloadRequest.process(channel, { 0x20 }, 10) };
+    if (downloadResponse.size() < 2) {
+        return false;
+    }
+    const size_t maxSizeToTransfer = encodeBigEndian(downloadResponse[1], downloadResponse[0]) - 2;
+    UDSTransferData transferData{ canId, maxSizeToTransfer, timing };
+    // Прогресс считается по исходному размеру чанка, как и его максимум.
+    size_t sent = 0;
+    size_t reported = 0;
+    const auto crc = transferData.transfer(channel, data, [&](size_t size) {
+        sent += size;
+        const size_t progress = data.empty() ? dataSize : sent * dataSize / data.size();
+        progressCallback(progress - reported);
+        reported = progress;
+    });
+    // Переданные данные не совпадают с VBF: 0x37 с CRC из VBF не шлётся.
+    if (dataFormat == 0x00 && crc != chunk.crc) {
+        LOG_MODULE(ERROR) << "Chunk CRC mismatch, offset = " << std::hex << startAddr
+                          << ", VBF crc = " << chunk.crc << ", data crc = " << crc;
+        return false;
+    }
+    LOG_MODULE(INFO) << "transferChunk finish transfer, crc: {" << std::hex
+                     << ((chunk.crc >> 8) & 0xFF) << ", " << (chunk.crc & 0xFF) <<"}"
+                     << ", sent " << std::dec << data.size() << " of " << dataSize << " bytes";
+    UDSRequest transferExitRequest{ canId, { 0x37 }, timing };
+    transferExitRequest.process(
+        channel, { static_cast<uint8_t>(chunk.crc >> 8), static_cast<uint8_t>(chunk.crc) }, 3);
+    return true;
+}
+
+} // namespace
+
 	bool UDSProtocolCommonSteps::fallAsleep(const std::vector<std::unique_ptr<ICanChannel>>& channels,
                                              uint32_t funcCanId)
 	{
@@ -60,6 +110,22 @@ namespace common {
         return;
 	}
 
+	UDSTiming UDSProtocolCommonSteps::readSessionTiming(ICanChannel& channel, uint32_t canId, uint8_t session)
+	{
+        UDSRequest sessionRequest{ canId, { 0x10, session } };
+        try {
+            channel.clearRx();
+            const auto timing{ UDSTiming::fromSessionResponse(sessionRequest.process(channel)) };
+            LOG_MODULE(INFO) << "Session timing: P2 = " << timing.p2.count()
+                             << " ms, P2* = " << timing.p2Star.count() << " ms";
+            return timing;
+        }
+        catch (const std::exception& ex) {
+            LOG_MODULE(ERROR) << "readSessionTiming error, ex = " << ex.what() << ", default timing is used";
+        }
+        return {};
+	}
+
 	bool UDSProtocolCommonSteps::authorize(ICanChannel& channel, uint32_t canId,
 		const std::array<uint8_t, 5>& pin)
 	{
@@ -73,6 +139,10 @@ namespace common {
                 if (seedResponse.size() < 5)
                     return false;
                 std::array<uint8_t, 3> seed = { seedResponse[2], seedResponse[3], seedResponse[4] };
+                if (seed == std::array<uint8_t, 3>{}) {
+                    LOG_MODULE(INFO) << "authorize skipped, ECU is already unlocked";
+                    return true;
+                }
                 uint32_t key = generateKeyVolvoFord(pin, seed);
                 channel.clearRx();
                 UDSRequest keyRequest(canId, { 0x27, 0x02, (key >> 16) & 0xFF, (key >> 8) & 0xFF, key & 0xFF });
@@ -88,51 +158,56 @@ namespace common {
                     return result;
                 }
                 catch(UDSError& error) {
-                    if(error.getErrorCode() == UDSError::ErrorCode::RequiredTimeDelayHasNotExpired) {
-                    }
                     LOG_MODULE(ERROR) << "authorize error: " << error.what() << ", pin = "
                                << std::hex << pin[0] << pin[1] << pin[2] << pin[3] << pin[4];
                 }
             }
+            catch (const UDSError& error) {
+                // Ждать стоит только задержку после неверных ключей, остальные
+                // ошибки и таймауты повторяются сразу.
+                LOG_MODULE(ERROR) << "authorize seed error: " << error.what();
+                if (error.getErrorCode() == UDSError::ErrorCode::RequiredTimeDelayHasNotExpired
+                    || error.getErrorCode() == UDSError::ErrorCode::ExceedNumberOfAttempts) {
+                    std::this_thread::sleep_for(std::chrono::seconds(5));
+                }
+            }
+            catch (const std::exception& ex) {
+                LOG_MODULE(ERROR) << "authorize seed error: " << ex.what();
+            }
             catch (...) {
-                std::this_thread::sleep_for(std::chrono::seconds(5));
+                LOG_MODULE(ERROR) << "authorize seed error";
             }
         }
         LOG_MODULE(TRACE) << "authorization failed, pin: "<< std::hex << pin[0] << pin[1] << pin[2] << pin[3] << pin[4];
         return false;
 	}
 
+    std::string UDSProtocolCommonSteps::readVin(ICanChannel& channel, uint32_t canId)
+    {
+        UDSRequest vinRequest{ canId, { 0x22, 0xF1, 0x90 } };
+        try {
+            channel.clearRx();
+            const auto response{ vinRequest.process(channel) };
+            if (response.size() > 3) {
+                return { response.cbegin() + 3, response.cend() };
+            }
+        }
+        catch (const std::exception& ex) {
+            LOG_MODULE(ERROR) << "readVin error, ex = " << ex.what();
+        }
+        return {};
+    }
+
     bool UDSProtocolCommonSteps::transferChunk(ICanChannel& channel, uint32_t canId, const VBFChunk& chunk,
-                                              const std::function<void(size_t)>& progressCallback)
+                                              const std::function<void(size_t)>& progressCallback,
+                                              const UDSTiming& timing, UDSDownloadEncoder* encoder)
 	{
         LOG_SCOPE_DURATION(transferChunk);
         LOG_MODULE(TRACE) << "transferChunk enter chunk: " << std::hex << chunk.writeOffset;
         try {
-            const auto startAddr = chunk.writeOffset;
-            const auto dataSize = chunk.data.size();
-            UDSRequest requestDownloadRequest{ canId, { 0x34, 0x00, 0x44,
-                (startAddr >> 24) & 0xFF, (startAddr >> 16) & 0xFF, (startAddr >> 8) & 0xFF, startAddr & 0xFF,
-                (dataSize >> 24) & 0xFF, (dataSize >> 16) & 0xFF, (dataSize >> 8) & 0xFF, dataSize & 0xFF } };
-            const auto downloadResponse{ requestDownloadRequest.process(channel, { 0x20 }, 10) };
-            if (downloadResponse.size() < 2) {
+            if (!downloadChunk(channel, canId, chunk, progressCallback, timing, encoder)) {
                 return false;
             }
-            const size_t maxSizeToTransfer = encodeBigEndian(downloadResponse[1], downloadResponse[0]) - 2;
-            uint8_t chunkIndex = 1;
-            for (size_t i = 0; i < chunk.data.size(); i += maxSizeToTransfer, ++chunkIndex) {
-                const auto chunkEnd{ std::min(i + maxSizeToTransfer, chunk.data.size()) };
-                LOG_MODULE(INFO) << "transferChunk write chunk: {" << std::hex << i << ", " << chunkEnd <<"}";
-                std::vector<uint8_t> data{ 0x36, chunkIndex };
-                data.insert(data.end(), chunk.data.cbegin() + i, chunk.data.cbegin() + chunkEnd);
-                UDSRequest transferDataRequest{ canId, std::move(data) };
-                transferDataRequest.process(channel, { chunkIndex }, 10, 60000);
-                progressCallback(chunkEnd - i);
-            }
-            LOG_MODULE(INFO) << "transferChunk finish transfer, crc: {" << std::hex
-                      << ((chunk.crc >> 8) & 0xFF) << ", " << (chunk.crc & 0xFF) <<"}";
-            UDSRequest transferExitRequest{ canId, { 0x37 } };
-            transferExitRequest.process(
-                channel, { static_cast<uint8_t>(chunk.crc >> 8), static_cast<uint8_t>(chunk.crc) }, 3, 10000);
 		}
         catch(const std::exception& ex) {
             LOG_MODULE(ERROR) << "transferChunk error, ex = " << ex.what() << ", offset = " << std::hex << chunk.writeOffset;
@@ -147,34 +222,19 @@ namespace common {
 	}
 
     bool UDSProtocolCommonSteps::transferData(ICanChannel& channel, uint32_t canId, const VBF& data,
-                                              const std::function<void(size_t)>& progressCallback)
+                                              const std::function<void(size_t)>& progressCallback,
+                                              const UDSTiming& timing, UDSDownloadEncoder* encoder)
     {
         LOG_SCOPE_DURATION(transferData);
         LOG_MODULE(TRACE) << "transferData enter";
         try {
+            if (encoder) {
+                encoder->start(data);
+            }
             for (const auto& chunk : data.chunks) {
-                const auto startAddr = chunk.writeOffset;
-                const auto dataSize = chunk.data.size();
-                UDSRequest requestDownloadRequest{ canId, { 0x34, 0x00, 0x44,
-                                                          (startAddr >> 24) & 0xFF, (startAddr >> 16) & 0xFF, (startAddr >> 8) & 0xFF, startAddr & 0xFF,
-                                                          (dataSize >> 24) & 0xFF, (dataSize >> 16) & 0xFF, (dataSize >> 8) & 0xFF, dataSize & 0xFF } };
-                const auto downloadResponse{ requestDownloadRequest.process(channel, { 0x20 }, 10) };
-                if (downloadResponse.size() < 2) {
+                if (!downloadChunk(channel, canId, chunk, progressCallback, timing, encoder)) {
                     return false;
                 }
-                const size_t maxSizeToTransfer = encodeBigEndian(downloadResponse[1], downloadResponse[0]) - 2;
-                uint8_t chunkIndex = 1;
-                for (size_t i = 0; i < chunk.data.size(); i += maxSizeToTransfer, ++chunkIndex) {
-                    const auto chunkEnd{ std::min(i + maxSizeToTransfer, chunk.data.size()) };
-                    std::vector<uint8_t> data{ 0x36, chunkIndex };
-                    data.insert(data.end(), chunk.data.cbegin() + i, chunk.data.cbegin() + chunkEnd);
-                    UDSRequest transferDataRequest{ canId, std::move(data) };
-                    transferDataRequest.process(channel, { chunkIndex }, 10, 60000);
-                    progressCallback(chunkEnd - i);
-                }
-                UDSRequest transferExitRequest{ canId, { 0x37 } };
-                transferExitRequest.process(
-                    channel, { static_cast<uint8_t>(chunk.crc >> 8), static_cast<uint8_t>(chunk.crc) }, 3, 10000);
             }
         }
         catch(const std::exception& ex) {
@@ -190,75 +250,76 @@ namespace common {
         return true;
     }
 
-    bool UDSProtocolCommonSteps::eraseFlash(ICanChannel& channel, uint32_t canId, const VBF& data)
+    bool UDSProtocolCommonSteps::eraseFlash(ICanChannel& channel, uint32_t canId, const VBF& data,
+                                            const UDSTiming& timing)
     {
         LOG_SCOPE_DURATION(eraseFlash);
         LOG_MODULE(TRACE) << "eraseFlash enter";
         for (const auto& chunk : data.chunks) {
-			const auto eraseAddr = toVector(chunk.writeOffset);
-			const auto eraseSize = toVector(static_cast<uint32_t>(chunk.data.size()));
-            for(size_t i = 0; i < 10; ++i) {
-                if (!channel.send({canId, {0x31, 0x01, 0xff, 0x00,
-                    eraseAddr[0], eraseAddr[1], eraseAddr[2], eraseAddr[3],
-                    eraseSize[0], eraseSize[1], eraseSize[2], eraseSize[3]}})) {
-                    continue;
-                }
-                const auto result{ readMessageCheckAndGet(channel, { 0x71, 0x01, 0xff, 0x00, 0x00 }, {}, 10) };
-                if(result.empty()) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-                    continue;
-                }
-                LOG_MODULE(TRACE) << "eraseFlash completed";
-                return true;
+            if (!eraseChunk(channel, canId, chunk, timing)) {
+                LOG_MODULE(ERROR) << "Failed to erase data";
+                return false;
             }
 		}
-        LOG_MODULE(ERROR) << "Failed to erase data";
-        return false;
+        LOG_MODULE(TRACE) << "eraseFlash completed";
+        return true;
 	}
 
-    bool UDSProtocolCommonSteps::eraseChunk(ICanChannel& channel, uint32_t canId, const VBFChunk& chunk)
+    bool UDSProtocolCommonSteps::eraseChunk(ICanChannel& channel, uint32_t canId, const VBFChunk& chunk,
+                                            const UDSTiming& timing)
     {
         LOG_MODULE(TRACE) << "eraseChunk enter chunk: " << std::hex << chunk.writeOffset;
         const auto eraseAddr = toVector(chunk.writeOffset);
         const auto eraseSize = toVector(static_cast<uint32_t>(chunk.data.size()));
-        for(size_t i = 0; i < 1; ++i) {
-            if (!channel.send({canId, {0x31, 0x01, 0xff, 0x00,
-                                       eraseAddr[0], eraseAddr[1], eraseAddr[2], eraseAddr[3],
-                                       eraseSize[0], eraseSize[1], eraseSize[2], eraseSize[3]}})) {
-                continue;
-            }
-            const auto result{ readMessageCheckAndGet(channel, { 0x71, 0x01, 0xff, 0x00, 0x00 }, {}, 10) };
-            if(result.empty()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(500));
-                continue;
+        const auto expectedDuration = UDSEraseThroughput::expectedDuration(canId, chunk.data.size());
+        UDSRoutineControl eraseRoutine{ canId, 0xFF00, timing };
+        try {
+            const auto startTime = std::chrono::steady_clock::now();
+            const auto status = eraseRoutine.run(channel, { eraseAddr[0], eraseAddr[1], eraseAddr[2], eraseAddr[3],
+                                                            eraseSize[0], eraseSize[1], eraseSize[2], eraseSize[3] },
+                                                 expectedDuration);
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - startTime);
+            if (status.empty() || status[0] != 0x00) {
+                LOG_MODULE(ERROR) << "Failed to erase chunk: " << std::hex << chunk.writeOffset
+                                  << ", status = " << (status.empty() ? -1 : static_cast<int>(status[0]));
+                return false;
             }
-            LOG_MODULE(TRACE) << "eraseChunk completed, offset = " << std::hex << chunk.writeOffset;
-            return true;
+            UDSEraseThroughput::update(canId, chunk.data.size(), elapsed);
+            LOG_MODULE(TRACE) << "eraseChunk completed, offset = " << std::hex << chunk.writeOffset << std::dec
+                              << ", expected = " << expectedDuration.count() << " ms, elapsed = " << elapsed.count() << " ms";
         }
-        LOG_MODULE(ERROR) << "Failed to erase chunk: " << std::hex << chunk.writeOffset;
-        return false;
+        catch(const std::exception& ex) {
+            LOG_MODULE(ERROR) << "Failed to erase chunk: " << std::hex << chunk.writeOffset << ", ex = " << ex.what();
+            return false;
+        }
+        return true;
     }
 
-    bool UDSProtocolCommonSteps::startRoutine(ICanChannel& channel, uint32_t canId, uint32_t addr)
+    bool UDSProtocolCommonSteps::startRoutine(ICanChannel& channel, uint32_t canId, uint32_t addr,
+                                              const UDSTiming& timing)
     {
         LOG_MODULE(TRACE) << "startRoutine enter, addr = " << std::hex << addr;
         const auto callAddr = common::toVector(addr);
-        if (!channel.send({canId, {0x31, 0x01, 0x03, 0x01, callAddr[0], callAddr[1], callAddr[2], callAddr[3]}})) {
-            LOG_MODULE(ERROR) << "startRoutine failed to write message, addr = " << std::hex << addr;
-            return false;
-		}
-		if (!common::readMessageAndCheck(channel, { 0x71, 0x01, 0x03, 0x01 }, {}, 10)) {
-            LOG_MODULE(ERROR) << "startRoutine failed to read message, addr = " << std::hex << addr;
+        // Переход в SBL не опрашивается через 0x31 03: после прыжка ЭБУ
+        // исполняет уже другой код, поэтому ждём обычный ответ.
+        UDSRequest startRoutineRequest{ canId, { 0x31, 0x01, 0x03, 0x01, callAddr[0], callAddr[1], callAddr[2], callAddr[3] },
+                                        timing };
+        try {
+            startRoutineRequest.process(channel, { 0x01, 0x03, 0x01 });
+        }
+        catch(const std::exception& ex) {
+            LOG_MODULE(ERROR) << "startRoutine failed, addr = " << std::hex << addr << ", ex = " << ex.what();
             return false;
 		}
         LOG_MODULE(TRACE) << "startRoutine completed, addr = " << std::hex << addr;
         return true;
 	}
 
-    bool UDSProtocolCommonSteps::checkValidApplication(ICanChannel& channel, uint32_t canId)
+    bool UDSProtocolCommonSteps::checkValidApplication(ICanChannel& channel, uint32_t canId, const UDSTiming& timing)
     {
         LOG_MODULE(TRACE) << "checkValidApplication enter";
-        UDSRequest checkValidApplicationRequest{ canId, { 0x31, 0x01, 0x03, 0x04 } };
+        UDSRequest checkValidApplicationRequest{ canId, { 0x31, 0x01, 0x03, 0x04 }, timing };
         try {
             checkValidApplicationRequest.process(channel);
         }
@@ -23,33 +23,45 @@ uint8_t getRequestId(const std::vector<uint8_t>& data)
 
 }
 
-UDSRequest::UDSRequest(uint32_t canId, const std::vector<uint8_t>& data)
+UDSRequest::UDSRequest(uint32_t canId, const std::vector<uint8_t>& data, const UDSTiming& timing)
     : _canId{ canId }
     , _requestId{ getRequestId(data) }
     , _data{ data }
+    , _timing{ timing }
 {
 }
 
-UDSRequest::UDSRequest(uint32_t canId, std::vector<uint8_t>&& data)
+UDSRequest::UDSRequest(uint32_t canId, std::vector<uint8_t>&& data, const UDSTiming& timing)
     : _canId{ canId }
     , _requestId{ getRequestId(data) }
     , _data{ std::move(data) }
+    , _timing{ timing }
 {
 }
 
-std::vector<uint8_t> UDSRequest::process(ICanChannel& channel, size_t timeout)
+std::vector<uint8_t> UDSRequest::process(ICanChannel& channel)
 {
     CanFrame request{ _canId, _data };
     if (!channel.send(request)) {
         throw std::runtime_error("Failed to send CAN message");
     }
+    UDSResponseTimer timer{ _timing };
     std::vector<uint8_t> result;
     while (true) {
         CanFrame response;
-        if (!channel.receive(response, static_cast<unsigned long>(timeout))) {
+        if (!timer.receive(channel, response)) {
             throw std::runtime_error("Failed to receive response");
         }
-        checkUDSError(_requestId, response.data.data(), response.data.size());
+        try {
+            checkUDSError(_requestId, response.data.data(), response.data.size());
+        }
+        catch (const UDSError& ex) {
+            if (ex.getErrorCode() == UDSError::ErrorCode::RequestReceivedResponsePending) {
+                timer.responsePending();
+                continue;
+            }
+            throw;
+        }
         if (response.data.size() < 1) {
             continue;
         }
@@ -64,21 +76,23 @@ std::vector<uint8_t> UDSRequest::process(ICanChannel& channel, size_t timeout)
 
 std::vector<uint8_t> UDSRequest::process(ICanChannel& channel,
                                          const std::vector<uint8_t>& checkData,
-                                         size_t retryCount, size_t timeout)
+                                         size_t retryCount)
 {
     channel.clearRx();
     CanFrame request{ _canId, _data };
     if (!channel.send(request)) {
         throw std::runtime_error("Failed to send CAN message");
     }
+    UDSResponseTimer timer{ _timing };
     std::vector<uint8_t> result;
     size_t remainingRetries = retryCount;
     while (remainingRetries > 0) {
         CanFrame response;
-        if (!channel.receive(response, static_cast<unsigned long>(timeout))) {
+        if (!timer.receive(channel, response)) {
             if (--remainingRetries == 0) {
                 throw std::runtime_error("Failed to receive correct answer");
             }
+            timer.restart();
             continue;
         }
         try {
@@ -86,6 +100,7 @@ std::vector<uint8_t> UDSRequest::process(ICanChannel& channel,
         }
         catch (const UDSError& ex) {
             if (ex.getErrorCode() == UDSError::ErrorCode::RequestReceivedResponsePending) {
+                timer.responsePending();
                 continue;
             }
             throw;
@@ -13,8 +13,12 @@ namespace common {
 
     std::vector<uint8_t> UDSRequestProcessor::process(std::vector<uint8_t>&& service, std::vector<uint8_t>&& params, size_t timeout) const
     {
-        UDSRequest request{ _canId, std::move(service) };
-        return request.process(_channel, timeout);
+        // Явный таймаут вызывающего ограничивает ожидание первого ответа,
+        // после 0x78 ожидание продлевается на P2*.
+        UDSTiming timing;
+        timing.p2 = std::chrono::milliseconds(timeout);
+        UDSRequest request{ _canId, std::move(service), timing };
+        return request.process(_channel);
     }
 
     void UDSRequestProcessor::disconnect()
@@ -0,0 +1,133 @@
+#include "common/protocols/UDSRoutineControl.hpp"
+
+#include "common/protocols/UDSError.hpp"
+#include "common/CanFrame.hpp"
+#include "common/ICanChannel.hpp"
+
+#define LOG_MODULE_NAME "common"
+#include "common/LogHelper.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace common {
+
+namespace {
+
+constexpr uint8_t RoutineControlId{ 0x31 };
+constexpr uint8_t StartRoutine{ 0x01 };
+constexpr uint8_t RequestRoutineResults{ 0x03 };
+
+// Пока ЭБУ ни разу не стирали, считаем по медленному флешу: 64 КБ за 2 с.
+constexpr double DefaultEraseThroughput{ 32.0 };
+
+std::mutex eraseThroughputMutex;
+std::unordered_map<uint32_t, double> eraseThroughput;
+
+} // namespace
+
+UDSRoutineControl::UDSRoutineControl(uint32_t canId, uint16_t routineId, const UDSTiming& timing)
+    : _canId{ canId }
+    , _routineId{ routineId }
+    , _timing{ timing }
+{
+}
+
+bool UDSRoutineControl::sendRequest(ICanChannel& channel, uint8_t subFunction,
+                                    const std::vector<uint8_t>& options) const
+{
+    CanFrame request{ _canId, { RoutineControlId, subFunction,
+                                static_cast<uint8_t>(_routineId >> 8), static_cast<uint8_t>(_routineId) } };
+    request.data.insert(request.data.end(), options.cbegin(), options.cend());
+    return channel.send(request);
+}
+
+std::vector<uint8_t> UDSRoutineControl::run(ICanChannel& channel, const std::vector<uint8_t>& options,
+                                            std::chrono::milliseconds expectedDuration)
+{
+    using clock = std::chrono::steady_clock;
+
+    channel.clearRx();
+    if (!sendRequest(channel, StartRoutine, options)) {
+        throw std::runtime_error("Failed to send CAN message");
+    }
+    const auto responseTime = _timing.p2 + UDSTiming::ClientMargin;
+    const auto pollInterval = std::max(expectedDuration / 10, std::chrono::milliseconds{ responseTime });
+    auto now = clock::now();
+    auto nextPoll = now + std::max(expectedDuration, std::chrono::milliseconds{ responseTime });
+    auto deadline = nextPoll + expectedDuration + _timing.p2Star + UDSTiming::ClientMargin;
+    while (true) {
+        CanFrame response;
+        const auto timeout = std::chrono::ceil<std::chrono::milliseconds>(std::min(nextPoll, deadline) - now);
+        if (timeout.count() > 0 && channel.receive(response, static_cast<unsigned long>(timeout.count()))) {
+            const auto& data = response.data;
+            if (data.size() >= 3 && data[0] == 0x7F && data[1] == RoutineControlId) {
+                switch (data[2]) {
+                case UDSError::ErrorCode::RequestReceivedResponsePending:
+                    // ЭБУ работает и сам пришлёт результат, опрашивать незачем.
+                    now = clock::now();
+                    deadline = std::max(deadline, now + _timing.p2Star + UDSTiming::ClientMargin);
+                    nextPoll = std::max(nextPoll, now + _timing.p2Star + UDSTiming::ClientMargin);
+                    break;
+                case UDSError::ErrorCode::BusyRepeatRequest:
+                case UDSError::ErrorCode::RequestSequenceError:
+                    // Ответ на 0x31 03, пока подпрограмма ещё выполняется.
+                    break;
+                default:
+                    throw UDSError(data[2]);
+                }
+            }
+            else if (data.size() >= 4 && data[0] == RoutineControlId + 0x40
+                && (data[1] == StartRoutine || data[1] == RequestRoutineResults)
+                && data[2] == static_cast<uint8_t>(_routineId >> 8) && data[3] == static_cast<uint8_t>(_routineId)) {
+                return { data.cbegin() + 4, data.cend() };
+            }
+        }
+        now = clock::now();
+        if (now >= deadline) {
+            throw std::runtime_error("Routine timeout");
+        }
+        if (now >= nextPoll) {
+            LOG_MODULE(TRACE) << "Request routine results, routine = " << std::hex << _routineId;
+            if (!sendRequest(channel, RequestRoutineResults, {})) {
+                throw std::runtime_error("Failed to send CAN message");
+            }
+            nextPoll = now + pollInterval;
+        }
+    }
+}
+
+/*static*/ std::chrono::milliseconds UDSEraseThroughput::expectedDuration(uint32_t canId, size_t size)
+{
+    double throughput = DefaultEraseThroughput;
+    {
+        std::lock_guard<std::mutex> lock{ eraseThroughputMutex };
+        const auto it = eraseThroughput.find(canId);
+        if (it != eraseThroughput.end()) {
+            throughput = it->second;
+        }
+    }
+    return std::chrono::milliseconds{ static_cast<long long>(size / throughput) };
+}
+
+/*static*/ void UDSEraseThroughput::update(uint32_t canId, size_t size, std::chrono::milliseconds elapsed)
+{
+    if (size == 0) {
+        return;
+    }
+    const double measured = static_cast<double>(size) / std::max<long long>(elapsed.count(), 1);
+    std::lock_guard<std::mutex> lock{ eraseThroughputMutex };
+    const auto it = eraseThroughput.find(canId);
+    if (it == eraseThroughput.end()) {
+        eraseThroughput.emplace(canId, measured);
+    }
+    else {
+        // Время стирания зависит от того, сколько секторов реально было
+        // записано, поэтому сглаживаем, а не берём последний замер.
+        it->second = (it->second + measured) / 2;
+    }
+}
+
+} // namespace common
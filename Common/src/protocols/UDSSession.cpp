@@ -0,0 +1,179 @@
+#include "common/protocols/UDSSession.hpp"
+
+#include "common/protocols/UDSPinCache.hpp"
+#include "common/protocols/UDSProtocolCommonSteps.hpp"
+#include "common/CanIdProvider.hpp"
+#include "common/ICanChannel.hpp"
+#include "common/J2534ChannelProvider.hpp"
+
+#define LOG_MODULE_NAME "common"
+#include "common/LogHelper.hpp"
+
+namespace common {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Период тестер презента в UDSProtocolCommonSteps::keepAlive. Когда каналы
+// закрываются, последний тестер презент мог уйти на период раньше.
+constexpr std::chrono::milliseconds TesterPresentInterval{ 1900 };
+
+} // namespace
+
+UDSSession::UDSSession(ChannelsOpener openChannels, uint32_t funcCanId, uint32_t physCanId, UDSSessionConfig config)
+    : _openChannels{ std::move(openChannels) }
+    , _funcCanId{ funcCanId }
+    , _physCanId{ physCanId }
+    , _config{ config }
+{
+}
+
+// Провайдер открывает мост между шинами, поэтому создаётся только когда
+// сессию действительно нужно держать.
+UDSSession::UDSSession(j2534::J2534& j2534, CarPlatform carPlatform, uint32_t ecuId, UDSSessionConfig config)
+    : _openChannels{ [this, &j2534, carPlatform, ecuId]() {
+        if (!_channelProvider) {
+            _channelProvider = std::make_unique<J2534ChannelProvider>(j2534, carPlatform);
+        }
+        return _channelProvider->getAllChannels(ecuId);
+    } }
+    , _funcCanId{ createCanIdProviderForEcu(carPlatform, ecuId)->getFuncCanId() }
+    , _physCanId{ createCanIdProviderForEcu(carPlatform, ecuId)->getPhysCanId() }
+    , _config{ config }
+{
+}
+
+UDSSession::~UDSSession()
+{
+    // Будить сеть отсюда нельзя - каналы закрываются вместе с потоком. Без
+    // тестер презента ЭБУ сами выйдут из сессии через S3.
+    suspend();
+}
+
+bool UDSSession::isOpen() const
+{
+    std::unique_lock<std::mutex> lock{ _mutex };
+    const auto now = Clock::now();
+    return _open && now < _expiry && (_keepingWarm || now < _lastTesterPresent + _config.s3);
+}
+
+const UDSTiming& UDSSession::getTiming() const
+{
+    return _timing;
+}
+
+const std::string& UDSSession::getVin() const
+{
+    return _vin;
+}
+
+std::optional<uint64_t> UDSSession::resolvePin(ICanChannel& channel, std::optional<uint64_t> pin)
+{
+    if (!_vinRead) {
+        _vin = UDSProtocolCommonSteps::readVin(channel, _physCanId);
+        _vinRead = true;
+    }
+    _cachedPinUsed = false;
+    if (pin || _vin.empty()) {
+        return pin;
+    }
+    const auto cachedPin{ UDSPinCache::find(_vin, _physCanId) };
+    if (cachedPin) {
+        LOG_MODULE(INFO) << "Cached PIN is used, VIN = " << _vin;
+        _cachedPinUsed = true;
+    }
+    return cachedPin;
+}
+
+void UDSSession::opened(const UDSTiming& timing, std::optional<uint64_t> pin)
+{
+    if (pin && !_vin.empty()) {
+        UDSPinCache::store(_vin, _physCanId, *pin);
+    }
+    std::unique_lock<std::mutex> lock{ _mutex };
+    const auto now = Clock::now();
+    _open = true;
+    _timing = timing;
+    _lastTesterPresent = now;
+    _expiry = now + _config.keepWarm;
+}
+
+void UDSSession::authorizationFailed()
+{
+    if (_cachedPinUsed) {
+        LOG_MODULE(WARNING) << "Cached PIN is rejected, VIN = " << _vin;
+        UDSPinCache::erase(_vin, _physCanId);
+        _cachedPinUsed = false;
+    }
+}
+
+void UDSSession::leave()
+{
+    std::unique_lock<std::mutex> lock{ _mutex };
+    const auto now = Clock::now();
+    _lastTesterPresent = now;
+    _expiry = now + _config.keepWarm;
+}
+
+void UDSSession::close()
+{
+    std::unique_lock<std::mutex> lock{ _mutex };
+    _open = false;
+}
+
+void UDSSession::suspend()
+{
+    {
+        std::unique_lock<std::mutex> lock{ _mutex };
+        _stopRequested = true;
+    }
+    _stopCondition.notify_all();
+    if (_keepWarmThread.joinable()) {
+        _keepWarmThread.join();
+    }
+    std::unique_lock<std::mutex> lock{ _mutex };
+    _stopRequested = false;
+}
+
+void UDSSession::resume()
+{
+    if (!isOpen() || _keepWarmThread.joinable()) {
+        return;
+    }
+    _keepWarmThread = std::thread(&UDSSession::keepWarm, this);
+}
+
+void UDSSession::keepWarm()
+{
+    std::vector<std::unique_ptr<ICanChannel>> channels;
+    bool testerPresent = false;
+    try {
+        channels = _openChannels();
+        for (const auto& channel : channels) {
+            testerPresent = !UDSProtocolCommonSteps::keepAlive(*channel, _funcCanId).empty() || testerPresent;
+        }
+    }
+    catch (const std::exception& ex) {
+        LOG_MODULE(ERROR) << "Failed to keep UDS session, ex = " << ex.what();
+    }
+    if (!testerPresent) {
+        LOG_MODULE(ERROR) << "Tester present isn't started, session expires in S3";
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock{ _mutex };
+    _keepingWarm = true;
+    const bool stopped = _stopCondition.wait_until(lock, _expiry, [this]() { return _stopRequested; });
+    _keepingWarm = false;
+    if (stopped) {
+        _lastTesterPresent = Clock::now() - TesterPresentInterval;
+        return;
+    }
+    LOG_MODULE(INFO) << "UDS session expired";
+    _open = false;
+    lock.unlock();
+    UDSProtocolCommonSteps::wakeUp(channels, _funcCanId);
+}
+
+} // namespace common
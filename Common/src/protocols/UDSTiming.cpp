@@ -0,0 +1,49 @@
+#include "common/protocols/UDSTiming.hpp"
+
+#include "common/CanFrame.hpp"
+#include "common/ICanChannel.hpp"
+
+namespace common {
+
+/*static*/ UDSTiming UDSTiming::fromSessionResponse(const std::vector<uint8_t>& response)
+{
+    UDSTiming timing;
+    if (response.size() < 6 || response[0] != 0x50) {
+        return timing;
+    }
+    timing.p2 = std::chrono::milliseconds((response[2] << 8) | response[3]);
+    timing.p2Star = std::chrono::milliseconds(((response[4] << 8) | response[5]) * 10);
+    return timing;
+}
+
+UDSResponseTimer::UDSResponseTimer(const UDSTiming& timing)
+    : _timing{ timing }
+{
+    restart();
+}
+
+void UDSResponseTimer::restart()
+{
+    _deadline = std::chrono::steady_clock::now() + _timing.p2 + UDSTiming::ClientMargin;
+}
+
+void UDSResponseTimer::responsePending()
+{
+    _deadline = std::chrono::steady_clock::now() + _timing.p2Star + UDSTiming::ClientMargin;
+}
+
+bool UDSResponseTimer::receive(ICanChannel& channel, CanFrame& frame) const
+{
+    const auto timeout = remaining();
+    if (timeout.count() <= 0) {
+        return false;
+    }
+    return channel.receive(frame, static_cast<unsigned long>(timeout.count()));
+}
+
+std::chrono::milliseconds UDSResponseTimer::remaining() const
+{
+    return std::chrono::ceil<std::chrono::milliseconds>(_deadline - std::chrono::steady_clock::now());
+}
+
+} // namespace common
@@ -0,0 +1,82 @@
+#include "common/protocols/UDSTransferData.hpp"
+
+#include "common/protocols/UDSError.hpp"
+#include "common/ICanChannel.hpp"
+#include "common/Util.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace common {
+
+namespace {
+
+constexpr uint8_t TransferDataId = 0x36;
+
+} // namespace
+
+UDSTransferData::UDSTransferData(uint32_t canId, size_t maxBlockSize,
+                                 const UDSTiming& timing, size_t retryCount)
+    : _canId{ canId }
+    , _maxBlockSize{ maxBlockSize }
+    , _timing{ timing }
+    , _retryCount{ retryCount }
+{
+    if (_maxBlockSize == 0) {
+        throw std::invalid_argument("TransferData block size must not be zero");
+    }
+}
+
+uint16_t UDSTransferData::transfer(ICanChannel& channel, std::span<const uint8_t> data,
+                                   const std::function<void(size_t)>& progressCallback)
+{
+    uint16_t crc = 0xFFFF;
+    _header[1] = 0x01;
+    for (size_t offset = 0; offset < data.size();) {
+        const auto block = data.subspan(offset, std::min(_maxBlockSize, data.size() - offset));
+        const uint8_t blockIndex = _header[1];
+        channel.clearRx();
+        if (!channel.send(_canId, _header, block)) {
+            throw std::runtime_error("Failed to send CAN message");
+        }
+        // Блок в пути - считаем CRC и готовим следующий заголовок.
+        crc = crc16(block.data(), block.size(), crc);
+        ++_header[1];
+        offset += block.size();
+
+        waitResponse(channel, blockIndex);
+        progressCallback(block.size());
+    }
+    return crc;
+}
+
+void UDSTransferData::waitResponse(ICanChannel& channel, uint8_t blockIndex)
+{
+    UDSResponseTimer timer{ _timing };
+    size_t remainingRetries = _retryCount;
+    while (remainingRetries > 0) {
+        if (!timer.receive(channel, _response)) {
+            --remainingRetries;
+            timer.restart();
+            continue;
+        }
+        const auto& data = _response.data;
+        if (data.size() >= 3 && data[0] == 0x7F && data[1] == TransferDataId) {
+            if (data[2] == UDSError::ErrorCode::RequestReceivedResponsePending) {
+                timer.responsePending();
+                continue;
+            }
+            throw UDSError(data[2]);
+        }
+        if (data.size() < 2 || data[0] != TransferDataId + 0x40) {
+            continue;
+        }
+        if (data[1] == blockIndex) {
+            return;
+        }
+        --remainingRetries;
+    }
+    throw std::runtime_error("Failed to receive correct answer");
+}
+
+} // namespace common
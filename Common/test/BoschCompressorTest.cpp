@@ -0,0 +1,155 @@
+#include <boost/test/unit_test.hpp>
+
+#include "common/compression/BoschCompressor.hpp"
+#include "common/SBL.hpp"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace common;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+namespace {
+
+// Прошивка: участки кода вперемешку с заливкой и короткими повторами.
+std::vector<uint8_t> makeImage(size_t size)
+{
+    std::mt19937 random{ 42 };
+    std::vector<uint8_t> image;
+    image.reserve(size);
+    while (image.size() < size) {
+        const size_t length = 1 + random() % 0x6000;
+        const uint8_t fill = random() % 2 ? 0xFF : 0x00;
+        const bool repeated = random() % 3 == 0;
+        for (size_t i = 0; i < length && image.size() < size; ++i) {
+            image.push_back(repeated ? fill : static_cast<uint8_t>(random() % 4 == 0 ? fill : random()));
+        }
+    }
+    return image;
+}
+
+// Прежнее сжатие с подсчётом повторений на каждой позиции - эталон.
+std::vector<uint8_t> compressBytewise(const std::vector<uint8_t>& input)
+{
+    std::vector<uint8_t> output = { 0x1A, 0x01 };
+    size_t rawBytes = 0;
+    const auto writeRaw = [&](size_t pos) {
+        if (rawBytes == 0) {
+            return;
+        }
+        output.push_back(static_cast<uint8_t>(rawBytes >> 8));
+        output.push_back(static_cast<uint8_t>(rawBytes));
+        output.insert(output.end(), input.begin() + pos - rawBytes, input.begin() + pos);
+        rawBytes = 0;
+    };
+
+    uint32_t checksum = 0;
+    for (size_t i = 0; i < input.size();) {
+        if (rawBytes >= 0x3FF0) {
+            writeRaw(i);
+        }
+        size_t repeats = 1;
+        while (i + repeats < input.size() && input[i + repeats] == input[i] && repeats < 0x3FFF) {
+            repeats++;
+        }
+        if (repeats >= 5) {
+            writeRaw(i);
+            output.push_back(static_cast<uint8_t>(0x40 | (repeats >> 8)));
+            output.push_back(static_cast<uint8_t>(repeats));
+            output.push_back(input[i]);
+            for (size_t n = 0; n < repeats; ++n) {
+                checksum += input[i + n];
+            }
+            i += repeats;
+        } else {
+            checksum += input[i];
+            rawBytes++;
+            i++;
+        }
+    }
+    writeRaw(input.size());
+    output.insert(output.end(), { 0xC0, 0x00, static_cast<uint8_t>(checksum >> 16),
+                                  static_cast<uint8_t>(checksum >> 8), static_cast<uint8_t>(checksum) });
+    return output;
+}
+
+} // namespace
+
+// ===========================================================================
+// BoschCompressor
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(BoschCompressesRunsAndRawBlocks)
+{
+    const std::vector<uint8_t> input = { 1, 2, 3, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 4, 4, 4, 4, 9 };
+    const std::vector<uint8_t> expected = {
+        0x1A, 0x01,
+        0x00, 0x03, 0x01, 0x02, 0x03,
+        0x40, 0x07, 0xFF,
+        0x00, 0x05, 0x04, 0x04, 0x04, 0x04, 0x09,
+        0xC0, 0x00, 0x00, 0x07, 0x18
+    };
+    BoschCompressor compressor;
+    const auto compressed = compressor.compress(input);
+    BOOST_CHECK_EQUAL_COLLECTIONS(compressed.begin(), compressed.end(), expected.begin(), expected.end());
+    BOOST_CHECK(compressor.decompress(compressed) == input);
+}
+
+BOOST_AUTO_TEST_CASE(BoschRoundTripsIntoReusedBuffers)
+{
+    BoschCompressor compressor;
+    std::vector<uint8_t> compressed;
+    std::vector<uint8_t> decompressed;
+    for (const size_t size : { 0x40000, 0x10, 0x3FF0, 0x3FFF * 2 + 3 }) {
+        const auto image = makeImage(size);
+        compressor.compressTo(image, compressed);
+        compressor.decompressTo(compressed, decompressed);
+        BOOST_CHECK(decompressed == image);
+    }
+
+    // Длинная заливка делится на блоки по 0x3FFF, короткий хвост идёт как есть.
+    const std::vector<uint8_t> fill(0x3FFF * 2 + 3, 0xFF);
+    compressor.compressTo(fill, compressed);
+    BOOST_CHECK_EQUAL(compressed.size(), 2u + 2 * 3 + 2 + 3 + 5);
+    compressor.decompressTo(compressed, decompressed);
+    BOOST_CHECK(decompressed == fill);
+}
+
+BOOST_AUTO_TEST_CASE(BoschMatchesBytewiseOutput)
+{
+    std::vector<std::vector<uint8_t>> inputs = {
+        {},
+        { 7 },
+        { 7, 7, 7, 7 },
+        { 7, 7, 7, 7, 7 },
+        SBLData::P1_ME9_SBL,
+        SBLData::P2_ME7_DATA,
+        SBLData::P3_ME9_SBL,
+        makeImage(0x80000),
+        std::vector<uint8_t>(0x3FF0 * 3, 0x5A),
+    };
+    // Повторы на границах блоков SSE и перед самым концом данных.
+    for (size_t start = 10; start < 40; ++start) {
+        std::vector<uint8_t> data(48);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = static_cast<uint8_t>(i);
+        }
+        std::fill(data.begin() + start, data.begin() + std::min<size_t>(start + 5, data.size()), 0xEE);
+        inputs.push_back(data);
+        data.resize(start + 5);
+        inputs.push_back(data);
+    }
+
+    BoschCompressor compressor;
+    BoschCompressor scalarCompressor{ false };
+    for (const auto& input : inputs) {
+        const auto expected = compressBytewise(input);
+        const auto compressed = compressor.compress(input);
+        BOOST_CHECK_EQUAL_COLLECTIONS(compressed.begin(), compressed.end(), expected.begin(), expected.end());
+        const auto scalar = scalarCompressor.compress(input);
+        BOOST_CHECK_EQUAL_COLLECTIONS(scalar.begin(), scalar.end(), expected.begin(), expected.end());
+    }
+}
@@ -0,0 +1,96 @@
+#include <boost/test/unit_test.hpp>
+
+#include "common/compression/CompressionSelector.hpp"
+#include "common/compression/LZSSCompressor.hpp"
+#include "common/SBL.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace common;
+using namespace std::chrono_literals;
+
+namespace {
+
+VBF makeVBF(std::vector<uint8_t> data)
+{
+    std::vector<VBFChunk> chunks;
+    chunks.emplace_back(0x10000, std::move(data));
+    return VBF{ {}, std::move(chunks) };
+}
+
+} // namespace
+
+// ===========================================================================
+// CompressionSelector
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(SelectorOffersUncompressedAndAcceptedMethod)
+{
+    const auto lzss = CompressionSelector::getOptions(CompressionType::LZSS);
+    BOOST_REQUIRE_EQUAL(lzss.size(), 3u);
+    BOOST_CHECK(lzss[0].type == CompressionType::None);
+    BOOST_CHECK(lzss[1].type == CompressionType::LZSS && !lzss[1].optimalParsing);
+    BOOST_CHECK(lzss[2].type == CompressionType::LZSS && lzss[2].optimalParsing);
+    BOOST_CHECK_EQUAL(CompressionSelector::getOptions(CompressionType::Bosch).size(), 2u);
+    BOOST_CHECK_EQUAL(CompressionSelector::getOptions(CompressionType::None).size(), 1u);
+    BOOST_CHECK_EQUAL(toString(lzss[2]), "lzss-optimal");
+}
+
+BOOST_AUTO_TEST_CASE(SelectorCountsIsoTpFrames)
+{
+    // 111 бит на кадр при 500 кбит/с.
+    BOOST_CHECK(CompressionSelector::estimateTransferTime(0, 500000) == 0us);
+    BOOST_CHECK(CompressionSelector::estimateTransferTime(7, 500000) == 222us);
+    BOOST_CHECK(CompressionSelector::estimateTransferTime(8, 500000) == 444us);
+}
+
+BOOST_AUTO_TEST_CASE(SelectorEstimatesCompressedSize)
+{
+    const auto flash = makeVBF(SBLData::P3_ME9_SBL);
+    const auto estimate = CompressionSelector::estimate({ CompressionType::LZSS, false }, flash, 500000);
+    BOOST_CHECK_EQUAL(estimate.inputBytes, SBLData::P3_ME9_SBL.size());
+    BOOST_CHECK_EQUAL(estimate.outputBytes, LZSSCompressor{}.compress(SBLData::P3_ME9_SBL).size());
+    BOOST_CHECK(estimate.transferTime == CompressionSelector::estimateTransferTime(estimate.outputBytes, 500000));
+    BOOST_CHECK(estimate.getTotalTime() == estimate.compressTime + estimate.transferTime);
+
+    const auto raw = CompressionSelector::estimate({}, flash, 500000);
+    BOOST_CHECK_EQUAL(raw.outputBytes, raw.inputBytes);
+    BOOST_CHECK(raw.compressTime == 0us);
+}
+
+BOOST_AUTO_TEST_CASE(SelectorPicksFastestAcceptedOption)
+{
+    const auto fill = makeVBF(std::vector<uint8_t>(0x10000, 0xFF));
+    BOOST_CHECK(CompressionSelector::select(CompressionType::Bosch, fill, 500000).option.type == CompressionType::Bosch);
+    BOOST_CHECK(CompressionSelector::select(CompressionType::LZSS, fill, 500000).option.type == CompressionType::LZSS);
+    BOOST_CHECK(CompressionSelector::select(CompressionType::None, fill, 500000).option.type == CompressionType::None);
+
+    // Случайные данные не сжимаются: выгоднее слать как есть.
+    std::mt19937 random{ 1 };
+    std::vector<uint8_t> noise(0x4000);
+    for (auto& byte : noise) {
+        byte = static_cast<uint8_t>(random());
+    }
+    BOOST_CHECK(CompressionSelector::select(CompressionType::LZSS, makeVBF(noise), 500000).option.type
+                == CompressionType::None);
+}
+
+BOOST_AUTO_TEST_CASE(SelectorSkipsOptionsThatFail)
+{
+    // Несжимаемый чанк больше, чем LZSS описывает одним заголовком.
+    std::mt19937 random{ 1 };
+    std::vector<uint8_t> noise(0xFFFF * 8 + 0x1000);
+    for (auto& byte : noise) {
+        byte = static_cast<uint8_t>(random());
+    }
+    const auto flash = makeVBF(noise);
+    BOOST_CHECK_THROW(CompressionSelector::estimate({ CompressionType::LZSS, false }, flash, 500000), std::runtime_error);
+
+    const auto selected = CompressionSelector::select(CompressionType::LZSS, flash, 500000);
+    BOOST_CHECK(selected.option.type == CompressionType::None);
+    BOOST_CHECK_EQUAL(selected.outputBytes, noise.size());
+}
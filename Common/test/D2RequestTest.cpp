@@ -6,7 +6,10 @@
 
 #include "MockICanChannel.hpp"
 
+#include <array>
+#include <chrono>
 #include <cstdint>
+#include <span>
 #include <vector>
 
 using namespace common;
@@ -593,3 +596,143 @@ BOOST_AUTO_TEST_CASE(SendMessagesDelay)
     D2Request req{0x50, {0xB9, 0xFB}};
     BOOST_CHECK_NO_THROW(req.process(mock, 1000, 50));
 }
+
+// ---------------------------------------------------------------------------
+// 13. Output into caller-supplied span
+// ---------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(SpanOutputSingleFrame)
+{
+    MockICanChannel mock;
+    mock.receiveQueue.push(makeResponse(0xCF, 0x50, {0xB9, 0xFB}, {0x01, 0x02}));
+
+    std::array<uint8_t, 16> buffer{};
+    D2Request req{0x50, {0xB9, 0xFB}};
+    const auto result = req.process(mock, buffer);
+
+    BOOST_CHECK_EQUAL(result.size(), 2);
+    BOOST_CHECK(result.data() == buffer.data());
+    BOOST_CHECK_EQUAL(buffer[0], 0x01);
+    BOOST_CHECK_EQUAL(buffer[1], 0x02);
+}
+
+BOOST_AUTO_TEST_CASE(SpanOutputMatchesVectorOutput)
+{
+    const std::vector<uint8_t> requestId = {0xB9, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07};
+    std::vector<uint8_t> data(200);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    MockICanChannel mock;
+    for (auto& frame : makeFramedResponse(0x50, requestId, data)) {
+        mock.receiveQueue.push(frame);
+    }
+    D2Request req{0x50, requestId};
+    const auto vectorResult = req.process(mock, 1000);
+
+    for (auto& frame : makeFramedResponse(0x50, requestId, data)) {
+        mock.receiveQueue.push(std::move(frame));
+    }
+    std::vector<uint8_t> buffer(data.size());
+    const auto spanResult = req.process(mock, buffer, 1000);
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(vectorResult.begin(), vectorResult.end(), data.begin(), data.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(spanResult.begin(), spanResult.end(), data.begin(), data.end());
+}
+
+BOOST_AUTO_TEST_CASE(SpanOutputTruncatesExtraData)
+{
+    MockICanChannel mock;
+    for (auto& frame : makeFramedResponse(0x50, {0xB9, 0xFB}, {1, 2, 3, 4, 5, 6, 7, 8, 9, 10})) {
+        mock.receiveQueue.push(std::move(frame));
+    }
+
+    std::array<uint8_t, 4> buffer{};
+    D2Request req{0x50, {0xB9, 0xFB}};
+    const auto result = req.process(mock, buffer);
+
+    BOOST_CHECK_EQUAL(result.size(), 4);
+    BOOST_CHECK_EQUAL(buffer[3], 4);
+    // Весь ответ вычитан, хотя в буфер попала только его часть.
+    BOOST_CHECK(mock.receiveQueue.empty());
+}
+
+BOOST_AUTO_TEST_CASE(SpanOutputEchoMismatchRestarts)
+{
+    MockICanChannel mock;
+    // Первый ответ - чужой (эхо не совпало), второй - наш.
+    for (auto& frame : makeFramedResponse(0x50, {0xB9, 0xFC}, {9, 9, 9})) {
+        mock.receiveQueue.push(std::move(frame));
+    }
+    mock.receiveQueue.push(makeResponse(0xCF, 0x50, {0xB9, 0xFB}, {0x01, 0x02}));
+
+    std::array<uint8_t, 8> buffer{};
+    D2Request req{0x50, {0xB9, 0xFB}};
+    const auto result = req.process(mock, buffer);
+
+    BOOST_REQUIRE_EQUAL(result.size(), 2);
+    BOOST_CHECK_EQUAL(result[0], 0x01);
+    BOOST_CHECK_EQUAL(result[1], 0x02);
+}
+
+BOOST_AUTO_TEST_CASE(SpanOutputErrorResponse)
+{
+    MockICanChannel mock;
+    mock.receiveQueue.push(makeErrorResponse(0x50, {0xB9, 0xFB}, 0x12));
+
+    std::array<uint8_t, 8> buffer{};
+    D2Request req{0x50, {0xB9, 0xFB}};
+    try {
+        req.process(mock, buffer);
+        BOOST_FAIL("Expected D2Error");
+    } catch (const D2Error& e) {
+        BOOST_CHECK_EQUAL(e.getErrorCode(), 0x12);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 14. Microbenchmark: большой многофреймовый ответ
+// ---------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_CASE(LargeResponseMicrobenchmark)
+{
+    constexpr size_t dataSize = 60 * 1024;
+    constexpr size_t iterations = 20;
+    const std::vector<uint8_t> requestId = {0xB9, 0xFB};
+    std::vector<uint8_t> data(dataSize);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i);
+    }
+    const auto frames = makeFramedResponse(0x50, requestId, data);
+    D2Request req{0x50, requestId};
+
+    const auto measure = [&](const auto& processOnce) {
+        std::chrono::nanoseconds total{ 0 };
+        for (size_t i = 0; i < iterations; ++i) {
+            MockICanChannel mock;
+            for (const auto& frame : frames) {
+                mock.receiveQueue.push(frame);
+            }
+            const auto start = std::chrono::steady_clock::now();
+            processOnce(mock);
+            total += std::chrono::steady_clock::now() - start;
+        }
+        return std::chrono::duration_cast<std::chrono::microseconds>(total).count() / iterations;
+    };
+
+    std::vector<uint8_t> vectorResult;
+    const auto vectorTime = measure([&](MockICanChannel& mock) {
+        vectorResult = req.process(mock, 1000);
+    });
+    std::vector<uint8_t> buffer(dataSize);
+    std::span<const uint8_t> spanResult;
+    const auto spanTime = measure([&](MockICanChannel& mock) {
+        spanResult = req.process(mock, buffer, 1000);
+    });
+
+    BOOST_TEST_MESSAGE("D2Request " << dataSize << " bytes, " << frames.size() << " frames: vector "
+                       << vectorTime << " us, span " << spanTime << " us");
+    BOOST_CHECK_EQUAL_COLLECTIONS(vectorResult.begin(), vectorResult.end(), data.begin(), data.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(spanResult.begin(), spanResult.end(), data.begin(), data.end());
+}
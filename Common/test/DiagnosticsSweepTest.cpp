@@ -0,0 +1,242 @@
+#include <boost/test/unit_test.hpp>
+
+#include "common/DiagnosticsSweep.hpp"
+#include "common/CanFrame.hpp"
+#include "common/ICanChannel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+using namespace common;
+
+// ---------------------------------------------------------------------------
+// Simulated bus with virtual time: every ECU answers its request after its
+// own processing time. receive() jumps to the next answer, so the shared
+// clock shows how long the sweep would take on a car.
+// ---------------------------------------------------------------------------
+namespace {
+
+struct SimulatedEcu {
+    uint32_t id;             // UDS: физический CAN id, D2: ecuId
+    uint32_t responseCanId;
+    double processTimeMs;
+    bool silent{ false };
+    double busyUntil{ 0 };
+};
+
+class SimulatedBus final : public ICanChannel {
+public:
+    SimulatedBus(ProtocolType protocol, double& now, std::vector<SimulatedEcu> ecus)
+        : _protocol{ protocol }
+        , _now{ now }
+        , _ecus{ std::move(ecus) }
+    {
+    }
+
+    bool send(const CanFrame& frame, unsigned long = 1000) override
+    {
+        _now += 0.25;
+        if (_protocol == ProtocolType::ISO15765) {
+            if (auto* ecu = findEcu(frame.id)) {
+                answer(*ecu, { { ecu->responseCanId, udsResponse(frame.data) } });
+            }
+        }
+        else if (frame.data.size() >= 3) {
+            if (auto* ecu = findEcu(frame.data[1])) {
+                answer(*ecu, d2Response(*ecu, { frame.data.begin() + 2, frame.data.begin() + 2 + ((frame.data[0] & 0x07) - 1) }));
+            }
+        }
+        return true;
+    }
+
+    bool send(const std::vector<CanFrame>& frames, unsigned long timeout = 1000) override
+    {
+        for (const auto& frame : frames) {
+            send(frame, timeout);
+        }
+        return true;
+    }
+
+    bool receive(CanFrame& frame, unsigned long timeout) override
+    {
+        auto it = std::min_element(_pending.begin(), _pending.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+        if (it == _pending.end() || it->first > _now + timeout) {
+            _now += timeout;
+            return false;
+        }
+        _now = std::max(_now, it->first);
+        frame = it->second;
+        _pending.erase(it);
+        return true;
+    }
+
+    bool receive(std::vector<CanFrame>&, size_t, unsigned long) override { return false; }
+    void clearRx() override {}
+    void clearTx() override {}
+    bool startPeriodicMsg(const CanFrame&, unsigned long, unsigned long&) override { return true; }
+    bool stopPeriodicMsg(unsigned long) override { return true; }
+    unsigned long getBaudrate() const override { return 500000; }
+    bool startMsgFilter(unsigned long, const CanFrame&, const CanFrame& pattern, const CanFrame*,
+                        unsigned long&) override
+    {
+        filters.push_back(pattern.id);
+        return true;
+    }
+    bool stopMsgFilter(unsigned long) override { return true; }
+    bool setConfig(unsigned long, unsigned long) override { return true; }
+    bool ioctl(unsigned long, const void*, void*) override { return true; }
+
+    std::vector<uint32_t> filters;
+
+private:
+    SimulatedEcu* findEcu(uint32_t id)
+    {
+        auto it = std::find_if(_ecus.begin(), _ecus.end(), [id](const SimulatedEcu& ecu) { return ecu.id == id; });
+        return it == _ecus.end() || it->silent ? nullptr : &*it;
+    }
+
+    void answer(SimulatedEcu& ecu, std::vector<CanFrame> frames)
+    {
+        ecu.busyUntil = std::max(_now, ecu.busyUntil) + ecu.processTimeMs;
+        double time = ecu.busyUntil;
+        for (auto& frame : frames) {
+            _pending.push_back({ time, std::move(frame) });
+            time += 0.25;
+        }
+    }
+
+    static std::vector<uint8_t> udsResponse(const std::vector<uint8_t>& request)
+    {
+        if (request[0] == 0x22) {
+            return { 0x62, request[1], request[2], 'P', 'N', static_cast<uint8_t>(request[2]) };
+        }
+        if (request[0] == 0x19) {
+            return { 0x59, 0x02, 0xFF, 0x12, 0x34, 0x56, 0x08 };
+        }
+        return { 0x7F, request[0], 0x11 };
+    }
+
+    // Ответ D2 серией кадров: [ecuId, requestId+0x40, эхо, данные].
+    static std::vector<CanFrame> d2Response(const SimulatedEcu& ecu, const std::vector<uint8_t>& request)
+    {
+        std::vector<uint8_t> stream{ static_cast<uint8_t>(ecu.id), static_cast<uint8_t>(request[0] + 0x40) };
+        stream.insert(stream.end(), request.begin() + 1, request.end());
+        for (uint8_t i = 0; i < 12; ++i) {
+            stream.push_back(static_cast<uint8_t>(ecu.id + i));
+        }
+        std::vector<CanFrame> frames;
+        uint8_t seriesId = 0x08;
+        for (size_t pos = 0; pos < stream.size(); pos += 7) {
+            const size_t size = std::min<size_t>(7, stream.size() - pos);
+            const bool first = pos == 0;
+            const bool last = pos + size >= stream.size();
+            uint8_t header = first ? 0x88 : (last ? static_cast<uint8_t>(0x48 + size) : seriesId);
+            if (first && last) {
+                header |= 0x40;
+            }
+            std::vector<uint8_t> data{ header };
+            data.insert(data.end(), stream.begin() + pos, stream.begin() + pos + size);
+            frames.push_back({ ecu.responseCanId, std::move(data), true });
+            seriesId = 0x08 + ((seriesId - 0x08 + 1) & 0x07);
+        }
+        return frames;
+    }
+
+    const ProtocolType _protocol;
+    double& _now;
+    std::vector<SimulatedEcu> _ecus;
+    std::vector<std::pair<double, CanFrame>> _pending;
+};
+
+ConfigurationInfo makeConfiguration()
+{
+    return { "Test", {
+        { "CAN HS", ProtocolType::ISO15765, 500000, 11, {
+            { 0x10, 0x7E0, "ECM", CompressionType::None, EncryptionType::None },
+            { 0x18, 0x7E1, "TCM", CompressionType::None, EncryptionType::None },
+            { 0x28, 0x730, "BCM", CompressionType::None, EncryptionType::None },
+        } },
+        { "CAN MS", ProtocolType::CAN, 125000, 29, {
+            { 0x50, 0, "CEM", CompressionType::None, EncryptionType::None },
+            { 0x58, 0, "DIM", CompressionType::None, EncryptionType::None },
+        } },
+    } };
+}
+
+std::vector<std::unique_ptr<ICanChannel>> makeChannels(double& now, bool bcmSilent = false)
+{
+    std::vector<std::unique_ptr<ICanChannel>> channels;
+    channels.push_back(std::make_unique<SimulatedBus>(ProtocolType::ISO15765, now, std::vector<SimulatedEcu>{
+        { 0x7E0, 0x7E8, 40 }, { 0x7E1, 0x7E9, 25 }, { 0x730, 0x738, 30, bcmSilent } }));
+    channels.push_back(std::make_unique<SimulatedBus>(ProtocolType::CAN, now, std::vector<SimulatedEcu>{
+        { 0x50, 0x800021, 60 }, { 0x58, 0x800121, 50 } }));
+    return channels;
+}
+
+} // namespace
+
+// ===========================================================================
+// DiagnosticsSweep
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(SweepCollectsAllEcus)
+{
+    double now = 0;
+    const auto channels = makeChannels(now);
+    DiagnosticsSweep sweep{ makeConfiguration() };
+    const auto report = sweep.run(channels);
+
+    BOOST_REQUIRE_EQUAL(report.size(), 5u);
+    for (const auto& ecu : report) {
+        BOOST_TEST_MESSAGE(ecu.ecu.name);
+        const auto expected = ecu.protocol == ProtocolType::ISO15765 ? 4u : 2u;
+        BOOST_REQUIRE_EQUAL(ecu.results.size(), expected);
+        for (const auto& result : ecu.results) {
+            BOOST_CHECK_MESSAGE(result.error.empty(), ecu.ecu.name << " " << result.name << ": " << result.error);
+        }
+    }
+    BOOST_CHECK(report[0].results[0].response == std::vector<uint8_t>({ 0xF1, 0x87, 'P', 'N', 0x87 }));
+    BOOST_CHECK(report[0].results[3].response == std::vector<uint8_t>({ 0x02, 0xFF, 0x12, 0x34, 0x56, 0x08 }));
+    // D2: эхо requestId отброшено, остаются 12 байт данных ЭБУ.
+    BOOST_REQUIRE_EQUAL(report[4].results[0].response.size(), 12u);
+    BOOST_CHECK_EQUAL(report[4].results[0].response[0], 0x58);
+    BOOST_CHECK_EQUAL(report[3].results[1].response[0], 0x50);
+
+    const auto& udsBus = static_cast<const SimulatedBus&>(*channels[0]);
+    BOOST_CHECK(udsBus.filters == std::vector<uint32_t>({ 0x7E8, 0x7E9, 0x738 }));
+}
+
+BOOST_AUTO_TEST_CASE(SweepTakesAsLongAsSlowestEcu)
+{
+    double now = 0;
+    const auto channels = makeChannels(now);
+    DiagnosticsSweep sweep{ makeConfiguration() };
+    sweep.run(channels);
+
+    // Последовательно: 4 * (40 + 25 + 30) + 2 * (60 + 50) = 600 мс,
+    // самый медленный ЭБУ - CEM, 2 * 60 мс, ECM - 4 * 40 мс.
+    BOOST_TEST_MESSAGE("sweep took " << now << " ms");
+    BOOST_CHECK_LT(now, 200.0);
+}
+
+BOOST_AUTO_TEST_CASE(SweepSilentEcuDoesNotBlockOthers)
+{
+    double now = 0;
+    const auto channels = makeChannels(now, true);
+    DiagnosticsSweepConfig config;
+    config.udsTiming.p2 = std::chrono::milliseconds{ 1 };
+    DiagnosticsSweep sweep{ makeConfiguration(), config };
+    const auto report = sweep.run(channels);
+
+    BOOST_REQUIRE_EQUAL(report.size(), 5u);
+    BOOST_CHECK_EQUAL(report[2].ecu.name, "BCM");
+    BOOST_REQUIRE_EQUAL(report[2].results.size(), 4u);
+    BOOST_CHECK_EQUAL(report[2].results[0].error, "No response");
+    BOOST_CHECK(report[0].results[0].error.empty());
+    BOOST_CHECK(report[3].results[0].error.empty());
+}
@@ -0,0 +1,50 @@
+#include <boost/test/unit_test.hpp>
+
+#include "common/FramePacer.hpp"
+
+#include <chrono>
+#include <vector>
+
+using namespace common;
+using namespace std::chrono_literals;
+
+// ===========================================================================
+// FramePacer
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(PacerKeepsMinimumInterval)
+{
+    // Часы идут только при опросе, на Tick за вызов: результат не зависит от
+    // загрузки машины, а опоздание wait() видно с точностью до Tick.
+    constexpr auto Tick = 100us;
+    FramePacer::Clock::time_point clock{ 1s };
+    FramePacer pacer{ 1ms, {}, [&]() {
+        clock += Tick;
+        return clock;
+    } };
+    constexpr int FrameCount = 10;
+    std::vector<FramePacer::Clock::time_point> sentAt;
+    const auto start = clock;
+    for (int i = 0; i < FrameCount; ++i) {
+        BOOST_CHECK_EQUAL(pacer.wait(), 1u);
+        if (!sentAt.empty()) {
+            BOOST_CHECK(clock >= sentAt.back() + 1ms);
+        }
+        pacer.sent();
+        sentAt.push_back(clock);
+        BOOST_CHECK(pacer.getDeadline() == clock + 1ms);
+    }
+    // Дедлайн считается от отправки, опоздание не копится от кадра к кадру.
+    BOOST_CHECK(clock - start <= (1ms + 2 * Tick) * FrameCount);
+}
+
+BOOST_AUTO_TEST_CASE(PacerBatchesFramesWhenBusSpacesThem)
+{
+    FramePacer pacer{ 100us, FramePacer::frameTimeForBaudrate(500000) };
+    BOOST_CHECK_EQUAL(FramePacer::frameTimeForBaudrate(500000).count(), 222);
+    BOOST_CHECK_EQUAL(pacer.wait(7), 7u);
+    pacer.sent();
+
+    pacer.setInterval(1ms);
+    BOOST_CHECK_EQUAL(pacer.wait(7), 1u);
+}
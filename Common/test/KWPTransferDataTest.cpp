@@ -0,0 +1,164 @@
+#include <boost/test/unit_test.hpp>
+
+#include "common/compression/BoschCompressor.hpp"
+#include "common/protocols/KWPProtocolCommonSteps.hpp"
+#include "common/protocols/RequestProcessorBase.hpp"
+#include "common/Util.hpp"
+#include "common/VBFChunk.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace common;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+namespace {
+
+std::vector<uint8_t> makeData(size_t size)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(i * 31 + (i >> 8));
+    }
+    return data;
+}
+
+uint32_t crc32Bitwise(const uint8_t* data, size_t length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    while (length--) {
+        crc ^= *data++;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+// ECU with a KWP2000 bootloader: accepts TransferData blocks and answers
+// the checksum routine (0x31/0x33 C5) with `ecuCrc`.
+class FakeKWPEcu final : public RequestProcessorBase {
+public:
+    std::vector<uint8_t> process(std::vector<uint8_t>&& service, std::vector<uint8_t>&& params, size_t) const override
+    {
+        requests.push_back(service);
+        requests.back().insert(requests.back().end(), params.cbegin(), params.cend());
+        const uint8_t response = service[0] + 0x40;
+        if (service[0] == 0x36) {
+            received.insert(received.end(), params.cbegin(), params.cend());
+            return { response };
+        }
+        if (service[0] == 0x31 || service[0] == 0x33) {
+            if (!checksumSupported) {
+                throw std::runtime_error("service not supported");
+            }
+            if (service[0] == 0x33) {
+                return { response, 0xC5, static_cast<uint8_t>(ecuCrc >> 24), static_cast<uint8_t>(ecuCrc >> 16),
+                         static_cast<uint8_t>(ecuCrc >> 8), static_cast<uint8_t>(ecuCrc) };
+            }
+        }
+        return { response, service.size() > 1 ? service[1] : uint8_t{ 0 } };
+    }
+
+    void disconnect() override {}
+    bool connect() override { return true; }
+
+    mutable std::vector<std::vector<uint8_t>> requests;
+    mutable std::vector<uint8_t> received;
+    uint32_t ecuCrc{ 0 };
+    bool checksumSupported{ true };
+};
+
+} // namespace
+
+// ===========================================================================
+// crc32
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(Crc32KnownValue)
+{
+    const std::string check{ "123456789" };
+    BOOST_CHECK_EQUAL(crc32(reinterpret_cast<const uint8_t*>(check.data()), check.size()), 0xCBF43926u);
+    BOOST_CHECK_EQUAL(crc32(nullptr, 0), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Crc32MatchesBitwise)
+{
+    const auto data = makeData(1000);
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (size_t size : { 0, 1, 7, 8, 9, 63, 64, 65, 500, 992 }) {
+            BOOST_CHECK_EQUAL(crc32(data.data() + offset, size), crc32Bitwise(data.data() + offset, size));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(Crc32Incremental)
+{
+    const auto data = makeData(1000);
+    const auto head = crc32(data.data(), 37);
+    BOOST_CHECK_EQUAL(crc32(data.data() + 37, data.size() - 37, head), crc32(data.data(), data.size()));
+}
+
+// ===========================================================================
+// KWPProtocolCommonSteps::transferData
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(KWPTransferDataVerifiesChunkCrc)
+{
+    const VBFChunk chunk{ 0x010000, makeData(300), 0 };
+    FakeKWPEcu ecu;
+    ecu.ecuCrc = crc32(chunk.data.data(), chunk.data.size());
+    size_t progress = 0;
+
+    BOOST_CHECK(KWPProtocolCommonSteps::transferData(ecu, chunk, 133, [&](size_t size) { progress += size; }));
+    BOOST_CHECK(ecu.received == chunk.data);
+    BOOST_CHECK_EQUAL(progress, chunk.data.size());
+    BOOST_REQUIRE_GE(ecu.requests.size(), 2u);
+    const auto& checksumRequest = ecu.requests[ecu.requests.size() - 2];
+    BOOST_CHECK(checksumRequest == std::vector<uint8_t>({ 0x31, 0xC5, 0x01, 0x00, 0x00, 0x01, 0x01, 0x2B }));
+    BOOST_CHECK(ecu.requests.back() == std::vector<uint8_t>({ 0x33, 0xC5 }));
+}
+
+BOOST_AUTO_TEST_CASE(KWPTransferDataFailsOnCrcMismatch)
+{
+    const VBFChunk chunk{ 0x010000, makeData(300), 0 };
+    FakeKWPEcu ecu;
+    ecu.ecuCrc = crc32(chunk.data.data(), chunk.data.size()) ^ 1;
+
+    BOOST_CHECK(!KWPProtocolCommonSteps::transferData(ecu, chunk, 133, [](size_t) {}));
+}
+
+BOOST_AUTO_TEST_CASE(KWPTransferDataVerifiesCompressedChunk)
+{
+    const VBFChunk chunk{ 0x010000, std::vector<uint8_t>(300, 0xFF), 0 };
+    const auto compressed = BoschCompressor{}.compress(chunk.data);
+    FakeKWPEcu ecu;
+    ecu.ecuCrc = crc32(chunk.data.data(), chunk.data.size());
+    size_t progress = 0;
+
+    BOOST_CHECK(KWPProtocolCommonSteps::requestDownload(ecu, chunk) > 0);
+    BOOST_REQUIRE_EQUAL(ecu.requests.size(), 1u);
+    BOOST_CHECK_EQUAL(ecu.requests[0][4], KWPProtocolCommonSteps::DownloadDataFormat);
+    BOOST_CHECK(KWPProtocolCommonSteps::transferData(ecu, chunk, compressed, 133,
+                                                     [&](size_t size) { progress += size; }));
+    BOOST_CHECK(ecu.received == compressed);
+    BOOST_CHECK_EQUAL(progress, chunk.data.size());
+    BOOST_CHECK(ecu.requests.back() == std::vector<uint8_t>({ 0x33, 0xC5 }));
+
+    ecu.ecuCrc ^= 1;
+    BOOST_CHECK(!KWPProtocolCommonSteps::transferData(ecu, chunk, compressed, 133, [](size_t) {}));
+}
+
+BOOST_AUTO_TEST_CASE(KWPTransferDataWithoutChecksumRoutine)
+{
+    const VBFChunk chunk{ 0x010000, makeData(300), 0 };
+    FakeKWPEcu ecu;
+    ecu.checksumSupported = false;
+
+    BOOST_CHECK(KWPProtocolCommonSteps::transferData(ecu, chunk, 133, [](size_t) {}));
+    BOOST_CHECK(ecu.received == chunk.data);
+}
@@ -0,0 +1,202 @@
+#include <boost/test/unit_test.hpp>
+
+#include "common/compression/LZSSCompressor.hpp"
+#include "common/SBL.hpp"
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace common;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+namespace {
+
+// Прежний компрессор с полным перебором окна - эталон формата.
+std::vector<uint8_t> compressBruteForce(const std::vector<uint8_t>& input)
+{
+    std::vector<uint8_t> output;
+    std::vector<uint8_t> flags;
+    uint8_t currentFlag = 0;
+    size_t flagBit = 0;
+
+    for (size_t pos = 0; pos < input.size();) {
+        size_t bestOffset = 0;
+        size_t bestLength = 0;
+        for (size_t i = pos > 4096 ? pos - 4096 : 0; i < pos; ++i) {
+            size_t len = 0;
+            while (len < 18 && pos + len < input.size() && input[i + len] == input[pos + len]) {
+                len++;
+            }
+            if (len > bestLength) {
+                bestOffset = pos - i;
+                bestLength = len;
+            }
+        }
+
+        if (bestLength >= 3) {
+            currentFlag |= 1 << (7 - flagBit);
+            const uint16_t token = static_cast<uint16_t>(((bestOffset - 1) << 4) | (bestLength - 3));
+            output.push_back(static_cast<uint8_t>(token >> 8));
+            output.push_back(static_cast<uint8_t>(token & 0xFF));
+            pos += bestLength;
+        } else {
+            output.push_back(input[pos]);
+            pos++;
+        }
+
+        flagBit = (flagBit + 1) % 8;
+        if (flagBit == 0) {
+            flags.push_back(currentFlag);
+            currentFlag = 0;
+        }
+    }
+    if (flagBit != 0) {
+        flags.push_back(currentFlag);
+    }
+
+    output.insert(output.begin(), flags.begin(), flags.end());
+    output.insert(output.begin(), { static_cast<uint8_t>(flags.size() >> 8), static_cast<uint8_t>(flags.size()) });
+    return output;
+}
+
+// Похоже на прошивку: код из небольшого набора инструкций, таблицы
+// калибровок и заливка 0xFF между ними.
+std::vector<uint8_t> makeImage(size_t size)
+{
+    std::mt19937 random{ 42 };
+    std::vector<uint8_t> image;
+    image.reserve(size);
+    while (image.size() < size) {
+        const auto kind = random() % 4;
+        const size_t length = 256 + random() % 4096;
+        for (size_t i = 0; i < length && image.size() < size; ++i) {
+            switch (kind) {
+            case 0:
+                image.push_back(0xFF);
+                break;
+            case 1:
+                image.push_back(static_cast<uint8_t>(i * 3 + length));
+                break;
+            default:
+                image.push_back(static_cast<uint8_t>((random() % 24) * 7));
+                break;
+            }
+        }
+    }
+    return image;
+}
+
+std::vector<uint8_t> makeRandom(size_t size)
+{
+    std::mt19937 random{ 7 };
+    std::vector<uint8_t> data(size);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(random());
+    }
+    return data;
+}
+
+} // namespace
+
+// ===========================================================================
+// LZSSCompressor
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(LZSSMatchesBruteForceOutput)
+{
+    const std::vector<std::vector<uint8_t>> inputs = {
+        {},
+        { 0x01 },
+        { 0x01, 0x01, 0x01, 0x01 },
+        std::vector<uint8_t>(10000, 0xFF),
+        makeRandom(5000),
+        makeImage(20000),
+        SBLData::P1_ME9_SBL,
+        SBLData::P3_ME9_SBL,
+    };
+    LZSSCompressor compressor;
+    for (const auto& input : inputs) {
+        const auto compressed = compressor.compress(input);
+        const auto expected = compressBruteForce(input);
+        BOOST_CHECK_EQUAL_COLLECTIONS(compressed.begin(), compressed.end(), expected.begin(), expected.end());
+        const auto decompressed = compressor.decompress(compressed);
+        BOOST_CHECK_EQUAL_COLLECTIONS(decompressed.begin(), decompressed.end(), input.begin(), input.end());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(LZSSReusesOutputBuffers)
+{
+    const auto image = makeImage(100000);
+    const auto small = makeRandom(1000);
+    LZSSCompressor compressor;
+    std::vector<uint8_t> compressed;
+    std::vector<uint8_t> decompressed;
+
+    compressor.compressTo(image, compressed);
+    BOOST_CHECK(compressed == compressBruteForce(image));
+    compressor.decompressTo(compressed, decompressed);
+    BOOST_CHECK(decompressed == image);
+    BOOST_CHECK_EQUAL(decompressed.capacity(), image.size());
+
+    const auto* buffer = decompressed.data();
+    compressor.compressTo(small, compressed);
+    BOOST_CHECK(compressed == compressBruteForce(small));
+    compressor.decompressTo(compressed, decompressed);
+    BOOST_CHECK(decompressed == small);
+    BOOST_CHECK(decompressed.data() == buffer);
+}
+
+BOOST_AUTO_TEST_CASE(LZSSRejectsTooManyFlagBytes)
+{
+    // Случайные данные идут почти одними литералами: байт флагов на 8 байт
+    // входа. Размер флагов в заголовке - два байта.
+    LZSSCompressor compressor;
+    const auto largest = makeRandom(0xFFFF * 8 - 0x1000);
+    BOOST_CHECK(compressor.decompress(compressor.compress(largest)) == largest);
+
+    BOOST_CHECK_THROW(compressor.compress(makeRandom(0xFFFF * 8 + 0x1000)), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(LZSSStopsAtReferenceBeforeStart)
+{
+    // Литерал 'a', затем ссылка на 2 байта назад.
+    const std::vector<uint8_t> input = { 0x00, 0x01, 0x40, 'a', 0x01, 0x00 };
+    BOOST_CHECK(LZSSCompressor{}.decompress(input) == std::vector<uint8_t>{ 'a' });
+}
+
+BOOST_AUTO_TEST_CASE(LZSSLimitedChainDepthRoundTrips)
+{
+    const auto image = makeImage(50000);
+    LZSSCompressor full;
+    LZSSCompressor shallow{ LZSSCompressor::Parsing::Greedy, 4 };
+    const auto compressed = shallow.compress(image);
+    BOOST_CHECK_GE(compressed.size(), full.compress(image).size());
+    const auto decompressed = full.decompress(compressed);
+    BOOST_CHECK_EQUAL_COLLECTIONS(decompressed.begin(), decompressed.end(), image.begin(), image.end());
+}
+
+BOOST_AUTO_TEST_CASE(LZSSOptimalParseIsNeverLargerThanGreedy)
+{
+    LZSSCompressor greedy;
+    LZSSCompressor optimal{ LZSSCompressor::Parsing::Optimal };
+
+    const std::vector<std::vector<uint8_t>> inputs = {
+        {},
+        std::vector<uint8_t>(10000, 0xFF),
+        makeRandom(5000),
+        makeImage(50000),
+        SBLData::P3_ME9_SBL,
+    };
+    for (const auto& data : inputs) {
+        const auto compressed = optimal.compress(data);
+        BOOST_CHECK_LE(compressed.size(), greedy.compress(data).size());
+        const auto decompressed = greedy.decompress(compressed);
+        BOOST_CHECK_EQUAL_COLLECTIONS(decompressed.begin(), decompressed.end(), data.begin(), data.end());
+    }
+    BOOST_CHECK_EQUAL(optimal.getStats().greedyBytes, greedy.getStats().outputBytes);
+    BOOST_CHECK_LT(optimal.getStats().outputBytes, optimal.getStats().greedyBytes);
+}
@@ -0,0 +1,432 @@
+#include <boost/test/unit_test.hpp>
+
+#include "common/protocols/TP20Engine.hpp"
+#include "common/protocols/TP20Session.hpp"
+#include "common/CanFrame.hpp"
+#include "common/ICanChannel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+using namespace common;
+using namespace std::chrono_literals;
+
+// ---------------------------------------------------------------------------
+// Simulated TP20 ECUs on one CAN bus, virtual time. Every ECU checks the
+// sequence counters and opcodes, acknowledges every block and answers each
+// request with `response` after `responseDelayMs`, sent in blocks and waiting
+// for the tester's ACK. receive() jumps straight to the next frame, so the
+// virtual clock shows how long the exchange takes on the bus. Like a J2534
+// channel, the bus only delivers frames matching a started pass filter.
+// ---------------------------------------------------------------------------
+namespace {
+
+constexpr double FrameTimeMs = 0.25;        // 8-byte CAN frame at 500 kbit/s
+constexpr double AckTurnaroundMs = 1.0;     // ECU answers a block with ACK
+
+struct SimulatedEcu {
+    SimulatedEcu(uint8_t ecuId, uint8_t blockSize)
+        : ecuId{ ecuId }
+        , blockSize{ blockSize }
+    {
+    }
+
+    uint32_t txId() const { return 0x740 + ecuId; }
+
+    const uint8_t ecuId;
+    const uint8_t blockSize;
+    std::vector<uint8_t> response;
+    double responseDelayMs{ 0 };
+    uint32_t testerId{ 0 };
+    std::vector<std::vector<uint8_t>> requests;
+    std::vector<CanFrame> frames;
+    int acks{ 0 };
+    bool protocolError{ false };
+
+    std::vector<uint8_t> request;
+    uint8_t rxCounter{ 0 };
+    uint8_t blockFrames{ 0 };
+    size_t txOffset{ 0 };
+    uint8_t txCounter{ 0 };
+};
+
+class SimulatedTP20Bus final : public ICanChannel {
+public:
+    explicit SimulatedTP20Bus(std::vector<SimulatedEcu> ecus)
+        : ecus{ std::move(ecus) }
+    {
+    }
+
+    bool send(const CanFrame& frame, unsigned long = 1000) override
+    {
+        ++sendCalls;
+        handle(frame);
+        return true;
+    }
+
+    bool send(const std::vector<CanFrame>& frames, unsigned long = 1000) override
+    {
+        ++sendCalls;
+        for (const auto& frame : frames) {
+            handle(frame);
+        }
+        return true;
+    }
+
+    bool receive(CanFrame& frame, unsigned long timeout) override
+    {
+        while (true) {
+            auto it = std::min_element(_pending.begin(), _pending.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.first < rhs.first;
+            });
+            if (it == _pending.end() || it->first > now + timeout) {
+                now += timeout;
+                return false;
+            }
+            const bool passed = passes(it->second);
+            if (passed) {
+                now = std::max(now, it->first);
+                frame = it->second;
+            }
+            else {
+                ++filteredFrames;
+            }
+            _pending.erase(it);
+            if (passed) {
+                return true;
+            }
+        }
+    }
+
+    bool receive(std::vector<CanFrame>& frames, size_t messagesCount, unsigned long timeout) override
+    {
+        CanFrame frame;
+        while (frames.size() < messagesCount && receive(frame, timeout)) {
+            frames.push_back(frame);
+        }
+        return !frames.empty();
+    }
+
+    void clearRx() override {}
+    void clearTx() override {}
+    bool startPeriodicMsg(const CanFrame& frame, unsigned long, unsigned long& msgId) override
+    {
+        keepAlives.push_back(frame);
+        msgId = keepAlives.size();
+        return true;
+    }
+    bool stopPeriodicMsg(unsigned long) override
+    {
+        ++stoppedKeepAlives;
+        return true;
+    }
+    unsigned long getBaudrate() const override { return 500000; }
+    bool startMsgFilter(unsigned long, const CanFrame& mask, const CanFrame& pattern, const CanFrame*,
+                        unsigned long& filterId) override
+    {
+        filterId = ++_nextFilterId;
+        filters.push_back({ filterId, mask.id, pattern.id });
+        return true;
+    }
+    bool stopMsgFilter(unsigned long filterId) override
+    {
+        std::erase_if(filters, [filterId](const auto& filter) { return filter.id == filterId; });
+        return true;
+    }
+    bool setConfig(unsigned long, unsigned long) override { return true; }
+    bool ioctl(unsigned long, const void*, void*) override { return true; }
+
+    struct Filter {
+        unsigned long id;
+        uint32_t mask;
+        uint32_t pattern;
+    };
+
+    std::vector<SimulatedEcu> ecus;
+    std::vector<Filter> filters;
+    int filteredFrames{ 0 };
+    std::vector<CanFrame> keepAlives;
+    int stoppedKeepAlives{ 0 };
+    int sendCalls{ 0 };
+    double now{ 0 };
+
+private:
+    bool passes(const CanFrame& frame) const
+    {
+        return std::any_of(filters.begin(), filters.end(), [&frame](const auto& filter) {
+            return (frame.id & filter.mask) == (filter.pattern & filter.mask);
+        });
+    }
+
+    void reply(double time, uint32_t id, std::vector<uint8_t> data)
+    {
+        _pending.push_back({ time, { id, std::move(data) } });
+    }
+
+    void handle(const CanFrame& frame)
+    {
+        now += FrameTimeMs;
+        if (frame.data.empty()) {
+            return;
+        }
+        if (frame.id == 0x200) {
+            for (auto& ecu : ecus) {
+                if (ecu.ecuId == frame.data[0]) {
+                    ecu.testerId = frame.data[4] | (frame.data[5] << 8);
+                    reply(now + FrameTimeMs, 0x200 + ecu.ecuId,
+                        { 0x00, 0xD0, frame.data[4], frame.data[5], static_cast<uint8_t>(ecu.txId()),
+                          static_cast<uint8_t>(ecu.txId() >> 8) });
+                }
+            }
+            return;
+        }
+        for (auto& ecu : ecus) {
+            if (ecu.txId() == frame.id) {
+                handle(ecu, frame);
+            }
+        }
+    }
+
+    void handle(SimulatedEcu& ecu, const CanFrame& frame)
+    {
+        const uint8_t op = frame.data[0] & 0xF0;
+        if (frame.data[0] == 0xA0) {
+            reply(now + FrameTimeMs, ecu.testerId, { 0xA1, ecu.blockSize, 0x8A, 0xFF, 0x00, 0xFF });
+        }
+        else if (op == 0xB0) {
+            sendBlock(ecu, now);
+        }
+        else if (op <= 0x30) {
+            receiveFrame(ecu, frame);
+        }
+    }
+
+    void receiveFrame(SimulatedEcu& ecu, const CanFrame& frame)
+    {
+        ecu.frames.push_back(frame);
+        const uint8_t op = frame.data[0] & 0xF0;
+        const bool waitAck = op == 0x00 || op == 0x10;
+        const bool last = op == 0x10 || op == 0x30;
+        ++ecu.blockFrames;
+        ecu.protocolError = ecu.protocolError || (frame.data[0] & 0x0F) != ecu.rxCounter
+            || (last ? !waitAck : (ecu.blockFrames == ecu.blockSize) != waitAck);
+        ecu.rxCounter = (ecu.rxCounter + 1) & 0x0F;
+        const size_t offset = ecu.request.empty() ? 3 : 1;
+        ecu.request.insert(ecu.request.end(), frame.data.begin() + offset, frame.data.end());
+        if (waitAck) {
+            ++ecu.acks;
+            ecu.blockFrames = 0;
+            reply(now + AckTurnaroundMs, ecu.testerId, { static_cast<uint8_t>(0xB0 | ecu.rxCounter) });
+        }
+        if (last) {
+            ecu.requests.push_back(std::move(ecu.request));
+            ecu.request.clear();
+            ecu.txOffset = 0;
+            sendBlock(ecu, now + AckTurnaroundMs + ecu.responseDelayMs);
+        }
+    }
+
+    void sendBlock(SimulatedEcu& ecu, double time)
+    {
+        const auto& response = ecu.response;
+        for (uint8_t i = 0; i < ecu.blockSize && ecu.txOffset < response.size(); ++i) {
+            std::vector<uint8_t> data{ 0 };
+            if (ecu.txOffset == 0) {
+                data.push_back(static_cast<uint8_t>(response.size() >> 8));
+                data.push_back(static_cast<uint8_t>(response.size()));
+            }
+            const size_t size = std::min(8 - data.size(), response.size() - ecu.txOffset);
+            data.insert(data.end(), response.begin() + ecu.txOffset, response.begin() + ecu.txOffset + size);
+            ecu.txOffset += size;
+            const bool last = ecu.txOffset == response.size();
+            data[0] = (last ? 0x10 : i + 1 == ecu.blockSize ? 0x00 : 0x20) | ecu.txCounter;
+            ecu.txCounter = (ecu.txCounter + 1) & 0x0F;
+            time += FrameTimeMs;
+            reply(time, ecu.testerId, std::move(data));
+        }
+    }
+
+    std::vector<std::pair<double, CanFrame>> _pending;
+    unsigned long _nextFilterId{ 0 };
+};
+
+std::vector<uint8_t> makeData(size_t size)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    return data;
+}
+
+SimulatedTP20Bus makeBus(uint8_t blockSize, std::vector<uint8_t> response)
+{
+    SimulatedTP20Bus bus{ { SimulatedEcu{ 0x01, blockSize } } };
+    bus.ecus[0].response = std::move(response);
+    return bus;
+}
+
+double transferTime(uint8_t blockSize, const std::vector<uint8_t>& request)
+{
+    auto bus{ makeBus(blockSize, { 0x76 }) };
+    auto& ecu{ bus.ecus[0] };
+    TP20Session session{ bus, CarPlatform::VAG_MED91, 0x01 };
+    BOOST_REQUIRE(session.start());
+    const double start = bus.now;
+    BOOST_REQUIRE(session.writeMessage(request));
+    BOOST_CHECK(session.readMessage() == ecu.response);
+    BOOST_CHECK(!ecu.protocolError);
+    BOOST_REQUIRE_EQUAL(ecu.requests.size(), 1u);
+    BOOST_CHECK(ecu.requests[0] == request);
+    return bus.now - start;
+}
+
+} // namespace
+
+// ===========================================================================
+// TP20Session
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(TP20DecodesTimingParameter)
+{
+    BOOST_CHECK(TP20Session::decodeTimingParameter(0x05) == 500us);
+    BOOST_CHECK(TP20Session::decodeTimingParameter(0x4A) == 10ms);
+    BOOST_CHECK(TP20Session::decodeTimingParameter(0x83) == 30ms);
+    BOOST_CHECK(TP20Session::decodeTimingParameter(0xC1) == 100ms);
+}
+
+BOOST_AUTO_TEST_CASE(TP20WriteMessageSendsAllFrames)
+{
+    // Блок - один кадр, ЭБУ подтверждает каждый.
+    auto bus{ makeBus(1, { 0x71, 0xB8 }) };
+    TP20Session session{ bus, CarPlatform::VAG_MED91, 0x01 };
+    BOOST_REQUIRE(session.start());
+
+    BOOST_REQUIRE(session.writeMessage({ 0x31, 0xB8, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07 }));
+    const auto& frames{ bus.ecus[0].frames };
+    BOOST_REQUIRE_EQUAL(frames.size(), 2u);
+    BOOST_CHECK(frames[0].data == std::vector<uint8_t>({ 0x00, 0x00, 0x0A, 0x31, 0xB8, 0x00, 0x01, 0x02 }));
+    BOOST_CHECK(frames[1].data == std::vector<uint8_t>({ 0x11, 0x03, 0x04, 0x05, 0x06, 0x07 }));
+    BOOST_CHECK(session.readMessage() == bus.ecus[0].response);
+}
+
+BOOST_AUTO_TEST_CASE(TP20SendsBlocksInOneBatch)
+{
+    auto bus{ makeBus(0x0F, { 0x76, 0x01 }) };
+    auto& ecu{ bus.ecus[0] };
+    TP20Session session{ bus, CarPlatform::VAG_MED91, 0x01 };
+    BOOST_REQUIRE(session.start());
+    const int setupCalls = bus.sendCalls;
+
+    // 5 + 36 * 7 = 257 байт: 37 кадров, два полных блока и хвост из 7.
+    const auto request{ makeData(257) };
+    BOOST_REQUIRE(session.writeMessage(request));
+    BOOST_CHECK_EQUAL(bus.sendCalls - setupCalls, 3);
+    BOOST_CHECK_EQUAL(ecu.acks, 3);
+    BOOST_CHECK(session.readMessage() == ecu.response);
+    BOOST_CHECK(!ecu.protocolError);
+    BOOST_REQUIRE_EQUAL(ecu.requests.size(), 1u);
+    BOOST_CHECK(ecu.requests[0] == request);
+
+    // Следующее сообщение начинает блок заново.
+    BOOST_CHECK(session.process({ 0x31, 0xB8 }) == ecu.response);
+    BOOST_CHECK(!ecu.protocolError);
+}
+
+BOOST_AUTO_TEST_CASE(TP20ReassemblesLongResponse)
+{
+    auto response{ makeData(1000) };
+    response[0] = 0x63;
+    auto bus{ makeBus(0x0F, response) };
+    TP20Session session{ bus, CarPlatform::VAG_MED91, 0x01 };
+    BOOST_REQUIRE(session.start());
+
+    BOOST_REQUIRE(session.writeMessage({ 0x23, 0x00, 0x00, 0x00, 0x03, 0xE8 }));
+    const auto received{ session.readMessage() };
+    BOOST_CHECK(received == response);
+    BOOST_CHECK_EQUAL(received.capacity(), response.size());
+    BOOST_CHECK(!bus.ecus[0].protocolError);
+}
+
+BOOST_AUTO_TEST_CASE(TP20BlockWindowThroughput)
+{
+    const auto request{ makeData(4000) };
+    const double perFrameAck = transferTime(1, request);
+    const double blockAck = transferTime(0x0F, request);
+    BOOST_TEST_MESSAGE("TP20 4000 bytes: ack per frame " << perFrameAck << " ms, block of 15 " << blockAck << " ms");
+    BOOST_CHECK_LT(blockAck * 3, perFrameAck);
+}
+
+// ===========================================================================
+// TP20Engine
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(TP20EngineMultiplexesChannels)
+{
+    constexpr double ResponseDelayMs = 50;
+    SimulatedTP20Bus bus{ { SimulatedEcu{ 0x01, 0x0F }, SimulatedEcu{ 0x02, 0x0F } } };
+    for (auto& ecu : bus.ecus) {
+        ecu.response = makeData(100);
+        ecu.response[0] = 0x5A;
+        ecu.response[1] = ecu.ecuId;
+        ecu.responseDelayMs = ResponseDelayMs;
+    }
+    TP20Engine engine{ bus };
+    const size_t ecm = engine.open(CarPlatform::VAG_MED91, 0x01);
+    const size_t tcm = engine.open(CarPlatform::VAG_MED91, 0x02);
+    while (engine.isConnecting(ecm) || engine.isConnecting(tcm)) {
+        engine.poll(100ms);
+    }
+    BOOST_REQUIRE(engine.isConnected(ecm));
+    BOOST_REQUIRE(engine.isConnected(tcm));
+    BOOST_CHECK_NE(bus.ecus[0].testerId, bus.ecus[1].testerId);
+    BOOST_REQUIRE_EQUAL(bus.keepAlives.size(), 2u);
+    BOOST_CHECK_EQUAL(bus.keepAlives[0].id, 0x741u);
+    BOOST_CHECK_EQUAL(bus.keepAlives[1].id, 0x742u);
+
+    const double start = bus.now;
+    const std::vector<uint8_t> request{ 0x1A, 0x9B };
+    BOOST_REQUIRE(engine.write(ecm, request));
+    BOOST_REQUIRE(engine.write(tcm, request));
+    for (int i = 0; i < 1000 && !(engine.hasMessage(ecm) && engine.hasMessage(tcm)); ++i) {
+        engine.poll(100ms);
+    }
+    BOOST_CHECK(engine.takeMessage(ecm) == bus.ecus[0].response);
+    BOOST_CHECK(engine.takeMessage(tcm) == bus.ecus[1].response);
+    BOOST_CHECK(!bus.ecus[0].protocolError);
+    BOOST_CHECK(!bus.ecus[1].protocolError);
+    // ЭБУ готовят ответы одновременно.
+    BOOST_TEST_MESSAGE("TP20 two ECUs: " << bus.now - start << " ms");
+    BOOST_CHECK_LT(bus.now - start, 2 * ResponseDelayMs);
+
+    // Каждому каналу - фильтры id ЭБУ и id приёма, ответ второго ЭБУ не отброшен.
+    BOOST_CHECK_EQUAL(bus.filters.size(), 4u);
+    BOOST_CHECK_EQUAL(bus.filteredFrames, 0);
+    engine.close(ecm);
+    engine.close(tcm);
+    BOOST_CHECK_EQUAL(bus.stoppedKeepAlives, 2);
+    BOOST_CHECK(bus.filters.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TP20SessionsShareEngine)
+{
+    SimulatedTP20Bus bus{ { SimulatedEcu{ 0x01, 0x0F }, SimulatedEcu{ 0x02, 0x0F } } };
+    bus.ecus[0].response = { 0x5A, 0x01 };
+    bus.ecus[1].response = { 0x5A, 0x02 };
+    TP20Engine engine{ bus };
+    TP20Session ecm{ engine, CarPlatform::VAG_MED91, 0x01 };
+    TP20Session tcm{ engine, CarPlatform::VAG_MED91, 0x02 };
+    BOOST_REQUIRE(ecm.start());
+    BOOST_REQUIRE(tcm.start());
+
+    // Ответ ЭБУ двигателя принимается, пока ждёт сессия коробки.
+    BOOST_REQUIRE(ecm.writeMessage({ 0x1A, 0x9B }));
+    BOOST_REQUIRE(tcm.writeMessage({ 0x1A, 0x9B }));
+    BOOST_CHECK(tcm.readMessage() == bus.ecus[1].response);
+    BOOST_CHECK(ecm.readMessage() == bus.ecus[0].response);
+    BOOST_CHECK(!bus.ecus[0].protocolError);
+    BOOST_CHECK(!bus.ecus[1].protocolError);
+}
@@ -0,0 +1,147 @@
+#include <boost/test/unit_test.hpp>
+
+#include "common/protocols/UDSDownloadEncoder.hpp"
+#include "common/compression/LZSSCompressor.hpp"
+#include "common/encryption/XOREncryptor.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace common;
+
+namespace {
+
+VBF makeVBF()
+{
+    std::vector<uint8_t> first(0x2000);
+    for (size_t i = 0; i < first.size(); ++i) {
+        first[i] = static_cast<uint8_t>(i / 64);
+    }
+    std::vector<uint8_t> second(0x800, 0xFF);
+    std::vector<VBFChunk> chunks;
+    chunks.emplace_back(0x10000, std::move(first), 0);
+    chunks.emplace_back(0x20000, std::move(second), 0);
+    return VBF{ {}, std::move(chunks) };
+}
+
+VBF makeManyChunksVBF(size_t count, size_t size)
+{
+    std::vector<VBFChunk> chunks;
+    for (size_t c = 0; c < count; ++c) {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<uint8_t>((i * (c + 1)) / 48 + c);
+        }
+        chunks.emplace_back(static_cast<uint32_t>(0x10000 * (c + 1)), std::move(data), 0);
+    }
+    return VBF{ {}, std::move(chunks) };
+}
+
+} // namespace
+
+// ===========================================================================
+// UDSDownloadEncoder
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(DownloadEncoderDataFormatIdentifier)
+{
+    BOOST_CHECK_EQUAL(UDSDownloadEncoder(CompressionType::None, EncryptionType::None).getDataFormatIdentifier(), 0x00);
+    BOOST_CHECK_EQUAL(UDSDownloadEncoder(CompressionType::LZSS, EncryptionType::None).getDataFormatIdentifier(), 0x10);
+    BOOST_CHECK_EQUAL(UDSDownloadEncoder(CompressionType::LZSS, EncryptionType::XOR, {{"key", "k"}})
+        .getDataFormatIdentifier(), 0x11);
+}
+
+BOOST_AUTO_TEST_CASE(DownloadEncoderCompressesChunks)
+{
+    const auto vbf = makeVBF();
+    UDSDownloadEncoder encoder{ CompressionType::LZSS, EncryptionType::None };
+    encoder.start(vbf);
+
+    LZSSCompressor compressor;
+    for (const auto& chunk : vbf.chunks) {
+        const auto& encoded = encoder.get(chunk);
+        BOOST_CHECK_LT(encoded.size(), chunk.data.size());
+        BOOST_CHECK(compressor.decompress(encoded) == chunk.data);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DownloadEncoderOptimalCompressionKeepsFormat)
+{
+    const auto vbf = makeVBF();
+    UDSDownloadEncoder greedy{ CompressionType::LZSS, EncryptionType::None };
+    UDSDownloadEncoder optimal{ CompressionType::LZSS, EncryptionType::None, {}, true };
+    greedy.start(vbf);
+    optimal.start(vbf);
+    BOOST_CHECK_EQUAL(optimal.getDataFormatIdentifier(), greedy.getDataFormatIdentifier());
+
+    LZSSCompressor compressor;
+    for (const auto& chunk : vbf.chunks) {
+        const auto& encoded = optimal.get(chunk);
+        BOOST_CHECK_LE(encoded.size(), greedy.get(chunk).size());
+        BOOST_CHECK(compressor.decompress(encoded) == chunk.data);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DownloadEncoderEncryptsAfterCompression)
+{
+    const auto vbf = makeVBF();
+    UDSDownloadEncoder encoder{ CompressionType::LZSS, EncryptionType::XOR, {{"key", "secret"}} };
+    encoder.start(vbf);
+
+    LZSSCompressor compressor;
+    XOREncryptor encryptor{ {{"key", "secret"}} };
+    const auto& encoded = encoder.get(vbf.chunks[1]);
+    BOOST_CHECK(compressor.decompress(encryptor.decrypt(encoded)) == vbf.chunks[1].data);
+}
+
+BOOST_AUTO_TEST_CASE(DownloadEncoderRejectsForeignChunk)
+{
+    const auto vbf = makeVBF();
+    const auto other = makeVBF();
+    UDSDownloadEncoder encoder{ CompressionType::LZSS, EncryptionType::None };
+    encoder.start(vbf);
+    BOOST_CHECK_THROW(encoder.get(other.chunks[0]), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(DownloadEncoderWorkersKeepChunksInPlace)
+{
+    const auto vbf = makeManyChunksVBF(12, 0x1000);
+    UDSDownloadEncoder encoder{ CompressionType::LZSS, EncryptionType::XOR, {{"key", "secret"}}, false, 4 };
+    encoder.start(vbf);
+
+    LZSSCompressor compressor;
+    XOREncryptor encryptor{ {{"key", "secret"}} };
+    // Последний чанк раньше остальных: потоки не должны ждать его очереди.
+    BOOST_CHECK(compressor.decompress(encryptor.decrypt(encoder.get(vbf.chunks.back()))) == vbf.chunks.back().data);
+    for (const auto& chunk : vbf.chunks) {
+        BOOST_CHECK(compressor.decompress(encryptor.decrypt(encoder.get(chunk))) == chunk.data);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(DownloadEncoderRestartsWhileWorkersWait)
+{
+    const auto first = makeManyChunksVBF(20, 0x400);
+    const auto second = makeVBF();
+    UDSDownloadEncoder encoder{ CompressionType::LZSS, EncryptionType::None, {}, false, 2 };
+    encoder.start(first);
+    encoder.get(first.chunks[0]);
+    encoder.start(second);
+
+    LZSSCompressor compressor;
+    BOOST_CHECK(compressor.decompress(encoder.get(second.chunks[1])) == second.chunks[1].data);
+}
+
+BOOST_AUTO_TEST_CASE(DownloadEncoderWorkersMatchSingleWorker)
+{
+    const auto vbf = makeManyChunksVBF(8, 0x1000);
+    const auto encode = [&vbf](size_t workers) {
+        UDSDownloadEncoder encoder{ CompressionType::LZSS, EncryptionType::XOR, {{"key", "secret"}}, true, workers };
+        encoder.start(vbf);
+        std::vector<std::vector<uint8_t>> encoded;
+        for (const auto& chunk : vbf.chunks) {
+            encoded.push_back(encoder.get(chunk));
+        }
+        return encoded;
+    };
+    BOOST_CHECK(encode(4) == encode(1));
+}
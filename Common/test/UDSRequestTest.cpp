@@ -0,0 +1,95 @@
+#include <boost/test/unit_test.hpp>
+
+#include "common/protocols/UDSRequest.hpp"
+#include "common/protocols/UDSTiming.hpp"
+#include "common/protocols/UDSError.hpp"
+#include "common/CanFrame.hpp"
+
+#include "MockICanChannel.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using namespace common;
+using namespace std::chrono_literals;
+
+// ===========================================================================
+// UDSTiming
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(SessionTimingParsed)
+{
+    const auto timing = UDSTiming::fromSessionResponse({0x50, 0x02, 0x00, 0x19, 0x01, 0xF4});
+    BOOST_CHECK_EQUAL(timing.p2.count(), 25);
+    BOOST_CHECK_EQUAL(timing.p2Star.count(), 5000);
+}
+
+BOOST_AUTO_TEST_CASE(SessionTimingDefaultsForShortResponse)
+{
+    const auto timing = UDSTiming::fromSessionResponse({0x50, 0x02});
+    BOOST_CHECK_EQUAL(timing.p2.count(), UDSTiming{}.p2.count());
+    BOOST_CHECK_EQUAL(timing.p2Star.count(), UDSTiming{}.p2Star.count());
+}
+
+BOOST_AUTO_TEST_CASE(DefaultTimingKeepsFirstResponseTimeout)
+{
+    UDSResponseTimer timer{ UDSTiming{} };
+    BOOST_CHECK(timer.remaining() > UDSTiming::DefaultResponseTimeout - 50ms);
+    BOOST_CHECK(timer.remaining() <= UDSTiming::DefaultResponseTimeout);
+}
+
+BOOST_AUTO_TEST_CASE(ResponsePendingExtendsDeadline)
+{
+    UDSTiming timing;
+    timing.p2 = 10ms;
+    timing.p2Star = 2000ms;
+    UDSResponseTimer timer{ timing };
+    BOOST_CHECK(timer.remaining() <= timing.p2 + UDSTiming::ClientMargin);
+    timer.responsePending();
+    BOOST_CHECK(timer.remaining() > timing.p2 + UDSTiming::ClientMargin);
+    BOOST_CHECK(timer.remaining() <= timing.p2Star + UDSTiming::ClientMargin);
+}
+
+// ===========================================================================
+// UDSRequest
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(RequestSkipsPendingResponses)
+{
+    MockICanChannel mock;
+    mock.receiveQueue.push({0x7E8, {0x7F, 0x31, 0x78}});
+    mock.receiveQueue.push({0x7E8, {0x7F, 0x31, 0x78}});
+    mock.receiveQueue.push({0x7E8, {0x71, 0x01, 0xFF, 0x00}});
+
+    UDSRequest request{0x7E0, {0x31, 0x01, 0xFF, 0x00}};
+    const auto response = request.process(mock);
+    BOOST_CHECK(response == std::vector<uint8_t>({0x71, 0x01, 0xFF, 0x00}));
+    BOOST_CHECK_EQUAL(mock.sentFrames.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(RequestNegativeResponseThrows)
+{
+    MockICanChannel mock;
+    mock.receiveQueue.push({0x7E8, {0x7F, 0x22, 0x31}});
+
+    UDSRequest request{0x7E0, {0x22, 0xF1, 0x90}};
+    BOOST_CHECK_THROW(request.process(mock), UDSError);
+}
+
+BOOST_AUTO_TEST_CASE(RequestNoResponseThrows)
+{
+    MockICanChannel mock;
+    UDSRequest request{0x7E0, {0x22, 0xF1, 0x90}};
+    BOOST_CHECK_THROW(request.process(mock), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(RequestCheckDataSkipsPendingResponses)
+{
+    MockICanChannel mock;
+    mock.receiveQueue.push({0x7E8, {0x7F, 0x37, 0x78}});
+    mock.receiveQueue.push({0x7E8, {0x77, 0x12, 0x34}});
+
+    UDSRequest request{0x7E0, {0x37}};
+    BOOST_CHECK_NO_THROW(request.process(mock, {0x12, 0x34}, 1));
+}
@@ -0,0 +1,146 @@
+#include <boost/test/unit_test.hpp>
+
+#include "common/protocols/UDSProtocolCommonSteps.hpp"
+#include "common/protocols/UDSRoutineControl.hpp"
+#include "common/protocols/UDSError.hpp"
+#include "common/CanFrame.hpp"
+
+#include "MockICanChannel.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+using namespace common;
+using namespace std::chrono_literals;
+
+namespace {
+
+// ЭБУ молчит, пока у него не спросят результат подпрограммы.
+class AnswersOnPollChannel : public MockChannelWrapper {
+public:
+    AnswersOnPollChannel(MockICanChannel& mock, std::vector<CanFrame> pollResponses)
+        : MockChannelWrapper{ mock }
+        , _mock{ mock }
+        , _pollResponses{ std::move(pollResponses) }
+    {
+    }
+
+    bool send(const CanFrame& frame, unsigned long timeout = 1000) override
+    {
+        if (frame.data.size() >= 2 && frame.data[0] == 0x31 && frame.data[1] == 0x03
+            && _nextResponse < _pollResponses.size()) {
+            _mock.receiveQueue.push(_pollResponses[_nextResponse++]);
+        }
+        return MockChannelWrapper::send(frame, timeout);
+    }
+
+private:
+    MockICanChannel& _mock;
+    std::vector<CanFrame> _pollResponses;
+    size_t _nextResponse{ 0 };
+};
+
+UDSTiming fastTiming()
+{
+    UDSTiming timing;
+    timing.p2 = 1ms;
+    timing.p2Star = 10ms;
+    return timing;
+}
+
+} // namespace
+
+// ===========================================================================
+// UDSRoutineControl
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(RoutineWaitsForPendingResult)
+{
+    MockICanChannel mock;
+    mock.receiveQueue.push({0x7E8, {0x7F, 0x31, 0x78}});
+    mock.receiveQueue.push({0x7E8, {0x7F, 0x31, 0x78}});
+    mock.receiveQueue.push({0x7E8, {0x71, 0x01, 0xFF, 0x00, 0x00}});
+
+    UDSRoutineControl routine{0x7E0, 0xFF00, fastTiming()};
+    const auto status = routine.run(mock, {0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00}, 100ms);
+    BOOST_CHECK(status == std::vector<uint8_t>({0x00}));
+    BOOST_REQUIRE_EQUAL(mock.sentFrames.size(), 1u);
+    BOOST_CHECK(mock.sentFrames[0].data == std::vector<uint8_t>(
+        {0x31, 0x01, 0xFF, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00}));
+}
+
+BOOST_AUTO_TEST_CASE(RoutinePollsResultsWhenEcuIsSilent)
+{
+    MockICanChannel mock;
+    AnswersOnPollChannel channel{mock, {
+        {0x7E8, {0x7F, 0x31, 0x21}},
+        {0x7E8, {0x71, 0x03, 0xFF, 0x00, 0x00}},
+    }};
+
+    UDSRoutineControl routine{0x7E0, 0xFF00, fastTiming()};
+    const auto status = routine.run(channel, {}, 20ms);
+    BOOST_CHECK(status == std::vector<uint8_t>({0x00}));
+    BOOST_REQUIRE_EQUAL(mock.sentFrames.size(), 3u);
+    BOOST_CHECK(mock.sentFrames[1].data == std::vector<uint8_t>({0x31, 0x03, 0xFF, 0x00}));
+    BOOST_CHECK(mock.sentFrames[2].data == std::vector<uint8_t>({0x31, 0x03, 0xFF, 0x00}));
+}
+
+BOOST_AUTO_TEST_CASE(RoutineNegativeResponseThrows)
+{
+    MockICanChannel mock;
+    mock.receiveQueue.push({0x7E8, {0x7F, 0x31, 0x72}});
+
+    UDSRoutineControl routine{0x7E0, 0xFF00, fastTiming()};
+    BOOST_CHECK_THROW(routine.run(mock, {}), UDSError);
+}
+
+BOOST_AUTO_TEST_CASE(RoutineTimeoutThrows)
+{
+    MockICanChannel mock;
+    UDSRoutineControl routine{0x7E0, 0xFF00, fastTiming()};
+    BOOST_CHECK_THROW(routine.run(mock, {}, 5ms), std::runtime_error);
+}
+
+// ===========================================================================
+// Переход в SBL
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(StartRoutineWaitsForPlainResponse)
+{
+    MockICanChannel mock;
+    mock.receiveQueue.push({0x7E8, {0x7F, 0x31, 0x78}});
+    mock.receiveQueue.push({0x7E8, {0x71, 0x01, 0x03, 0x01}});
+    BOOST_CHECK(UDSProtocolCommonSteps::startRoutine(mock, 0x7E0, 0x31C000, fastTiming()));
+    BOOST_REQUIRE_EQUAL(mock.sentFrames.size(), 1u);
+    BOOST_CHECK(mock.sentFrames[0].data == std::vector<uint8_t>({0x31, 0x01, 0x03, 0x01, 0x00, 0x31, 0xC0, 0x00}));
+}
+
+BOOST_AUTO_TEST_CASE(StartRoutineDoesNotPollResults)
+{
+    MockICanChannel mock;
+    AnswersOnPollChannel channel{mock, {{0x7E8, {0x71, 0x03, 0x03, 0x01}}}};
+    BOOST_CHECK(!UDSProtocolCommonSteps::startRoutine(channel, 0x7E0, 0x31C000, fastTiming()));
+    BOOST_REQUIRE_EQUAL(mock.sentFrames.size(), 1u);
+    BOOST_CHECK_EQUAL(mock.sentFrames[0].data[1], 0x01);
+}
+
+// ===========================================================================
+// UDSEraseThroughput
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(EraseThroughputIsLearnedPerEcu)
+{
+    const auto defaultDuration = UDSEraseThroughput::expectedDuration(0x7A0, 0x10000);
+    BOOST_CHECK_GT(defaultDuration.count(), 0);
+
+    UDSEraseThroughput::update(0x7A0, 0x10000, 256ms);
+    BOOST_CHECK_EQUAL(UDSEraseThroughput::expectedDuration(0x7A0, 0x10000).count(), 256);
+    BOOST_CHECK_EQUAL(UDSEraseThroughput::expectedDuration(0x7A0, 0x20000).count(), 512);
+    BOOST_CHECK_EQUAL(UDSEraseThroughput::expectedDuration(0x7A1, 0x10000).count(), defaultDuration.count());
+
+    UDSEraseThroughput::update(0x7A0, 0x10000, 1024ms);
+    const auto smoothed = UDSEraseThroughput::expectedDuration(0x7A0, 0x10000).count();
+    BOOST_CHECK_GT(smoothed, 256);
+    BOOST_CHECK_LT(smoothed, 1024);
+}
@@ -0,0 +1,185 @@
+#include <boost/test/unit_test.hpp>
+
+#include "common/protocols/UDSPinCache.hpp"
+#include "common/protocols/UDSProtocolCommonSteps.hpp"
+#include "common/protocols/UDSSession.hpp"
+#include "common/CanFrame.hpp"
+
+#include "MockICanChannel.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace common;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr uint32_t FuncCanId = 0x7DF;
+constexpr uint32_t PhysCanId = 0x7E0;
+
+UDSSession::ChannelsOpener mockOpener(MockICanChannel& mock)
+{
+    return [&mock]() {
+        std::vector<std::unique_ptr<ICanChannel>> channels;
+        channels.push_back(std::make_unique<MockChannelWrapper>(mock));
+        return channels;
+    };
+}
+
+} // namespace
+
+// ===========================================================================
+// UDSPinCache
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(PinCacheSavesAndLoadsPins)
+{
+    UDSPinCache::clear();
+    UDSPinCache::store("YV1MW000000000001", 0x7E0, 0x0012345678);
+    UDSPinCache::store("", 0x7E1, 0xAB);
+    BOOST_CHECK(!UDSPinCache::find("", 0x7E1));
+
+    std::stringstream stream;
+    UDSPinCache::save(stream);
+    UDSPinCache::clear();
+    BOOST_CHECK(!UDSPinCache::find("YV1MW000000000001", 0x7E0));
+
+    UDSPinCache::load(stream);
+    BOOST_CHECK_EQUAL(UDSPinCache::find("YV1MW000000000001", 0x7E0).value_or(0), 0x0012345678u);
+    BOOST_CHECK(!UDSPinCache::find("", 0x7E1));
+    BOOST_CHECK(!UDSPinCache::find("YV1MW000000000002", 0x7E0));
+    UDSPinCache::clear();
+}
+
+// ===========================================================================
+// UDSProtocolCommonSteps::authorize
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(AuthorizeSkipsKeyWhenAlreadyUnlocked)
+{
+    MockICanChannel mock;
+    mock.receiveQueue.push({ 0x7E8, { 0x67, 0x01, 0x00, 0x00, 0x00 } });
+
+    BOOST_CHECK(UDSProtocolCommonSteps::authorize(mock, PhysCanId, { 0, 0, 0x12, 0x34, 0x56 }));
+    BOOST_REQUIRE_EQUAL(mock.sentFrames.size(), 1u);
+    BOOST_CHECK(mock.sentFrames[0].data == std::vector<uint8_t>({ 0x27, 0x01 }));
+}
+
+// ===========================================================================
+// UDSSession
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(SessionResolvesCachedPinByVin)
+{
+    UDSPinCache::clear();
+    MockICanChannel mock;
+    mock.receiveQueue.push({ 0x7E8, { 0x62, 0xF1, 0x90, 'Y', 'V', '1' } });
+    {
+        UDSSession session{ mockOpener(mock), FuncCanId, PhysCanId };
+        BOOST_CHECK_EQUAL(session.resolvePin(mock, 0x1234).value_or(0), 0x1234u);
+        BOOST_CHECK_EQUAL(session.getVin(), "YV1");
+        session.opened({}, 0x1234);
+    }
+
+    mock.receiveQueue.push({ 0x7E8, { 0x62, 0xF1, 0x90, 'Y', 'V', '1' } });
+    UDSSession session{ mockOpener(mock), FuncCanId, PhysCanId };
+    BOOST_CHECK_EQUAL(session.resolvePin(mock, std::nullopt).value_or(0), 0x1234u);
+    UDSPinCache::clear();
+}
+
+BOOST_AUTO_TEST_CASE(SessionSkipsPinCacheWithoutVin)
+{
+    UDSPinCache::clear();
+    MockICanChannel mock;
+    mock.receiveQueue.push({ 0x7E8, { 0x7F, 0x22, 0x31 } });
+    {
+        UDSSession session{ mockOpener(mock), FuncCanId, PhysCanId };
+        BOOST_CHECK_EQUAL(session.resolvePin(mock, 0x1234).value_or(0), 0x1234u);
+        BOOST_CHECK(session.getVin().empty());
+        session.opened({}, 0x1234);
+    }
+    BOOST_CHECK(!UDSPinCache::find("", PhysCanId));
+
+    mock.receiveQueue.push({ 0x7E8, { 0x7F, 0x22, 0x31 } });
+    UDSSession session{ mockOpener(mock), FuncCanId, PhysCanId };
+    BOOST_CHECK(!session.resolvePin(mock, std::nullopt));
+    UDSPinCache::clear();
+}
+
+BOOST_AUTO_TEST_CASE(SessionForgetsRejectedCachedPin)
+{
+    UDSPinCache::clear();
+    UDSPinCache::store("YV1", PhysCanId, 0x1234);
+    MockICanChannel mock;
+    mock.receiveQueue.push({ 0x7E8, { 0x62, 0xF1, 0x90, 'Y', 'V', '1' } });
+    UDSSession session{ mockOpener(mock), FuncCanId, PhysCanId };
+    BOOST_CHECK_EQUAL(session.resolvePin(mock, std::nullopt).value_or(0), 0x1234u);
+    session.authorizationFailed();
+    BOOST_CHECK(!UDSPinCache::find("YV1", PhysCanId));
+    BOOST_CHECK(!session.resolvePin(mock, std::nullopt));
+    UDSPinCache::clear();
+}
+
+BOOST_AUTO_TEST_CASE(SessionKeepsCacheWhenGivenPinIsRejected)
+{
+    UDSPinCache::clear();
+    UDSPinCache::store("YV1", PhysCanId, 0x1234);
+    MockICanChannel mock;
+    mock.receiveQueue.push({ 0x7E8, { 0x62, 0xF1, 0x90, 'Y', 'V', '1' } });
+    UDSSession session{ mockOpener(mock), FuncCanId, PhysCanId };
+    BOOST_CHECK_EQUAL(session.resolvePin(mock, 0x5678).value_or(0), 0x5678u);
+    session.authorizationFailed();
+    BOOST_CHECK_EQUAL(UDSPinCache::find("YV1", PhysCanId).value_or(0), 0x1234u);
+    UDSPinCache::clear();
+}
+
+BOOST_AUTO_TEST_CASE(SessionExpiresWithoutTesterPresent)
+{
+    MockICanChannel mock;
+    UDSSession session{ mockOpener(mock), FuncCanId, PhysCanId, { 30ms, 10s } };
+    BOOST_CHECK(!session.isOpen());
+    session.opened({}, std::nullopt);
+    session.leave();
+    BOOST_CHECK(session.isOpen());
+    std::this_thread::sleep_for(60ms);
+    BOOST_CHECK(!session.isOpen());
+}
+
+BOOST_AUTO_TEST_CASE(SessionIsKeptWarmBetweenOperations)
+{
+    MockICanChannel mock;
+    UDSSession session{ mockOpener(mock), FuncCanId, PhysCanId, { 30ms, 10s } };
+    session.opened({}, std::nullopt);
+    session.leave();
+    session.resume();
+    std::this_thread::sleep_for(60ms);
+    BOOST_CHECK(session.isOpen());
+    BOOST_CHECK_GT(mock.nextMsgId, 0);
+
+    // Следующая операция закрывает каналы поддержания сессии.
+    session.suspend();
+    session.close();
+    BOOST_CHECK(!session.isOpen());
+}
+
+BOOST_AUTO_TEST_CASE(SessionWakesNetworkWhenKeepWarmExpires)
+{
+    MockICanChannel mock;
+    UDSSession session{ mockOpener(mock), FuncCanId, PhysCanId, { 5s, 20ms } };
+    session.opened({}, std::nullopt);
+    session.leave();
+    session.resume();
+    // Тестер презент и два периодических сообщения пробуждения.
+    for (int i = 0; i < 100 && mock.nextMsgId < 3; ++i) {
+        std::this_thread::sleep_for(10ms);
+    }
+    session.suspend();
+    BOOST_CHECK_EQUAL(mock.nextMsgId, 3);
+    BOOST_CHECK(!session.isOpen());
+}
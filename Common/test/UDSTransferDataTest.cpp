@@ -0,0 +1,146 @@
+#include <boost/test/unit_test.hpp>
+
+#include "common/protocols/UDSProtocolCommonSteps.hpp"
+#include "common/protocols/UDSTransferData.hpp"
+#include "common/protocols/UDSError.hpp"
+#include "common/CanFrame.hpp"
+#include "common/VBFChunk.hpp"
+#include "common/Util.hpp"
+
+#include "MockICanChannel.hpp"
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+using namespace common;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+static CanFrame makeTransferResponse(uint8_t blockIndex)
+{
+    return {0x7E8, {0x76, blockIndex}};
+}
+
+static std::vector<uint8_t> makeData(size_t size)
+{
+    std::vector<uint8_t> data(size);
+    std::iota(data.begin(), data.end(), static_cast<uint8_t>(0));
+    return data;
+}
+
+// ===========================================================================
+// UDSTransferData
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(TransferDataSplitsIntoBlocks)
+{
+    MockICanChannel mock;
+    const auto data = makeData(10);
+    for (uint8_t i = 1; i <= 3; ++i) {
+        mock.receiveQueue.push(makeTransferResponse(i));
+    }
+
+    size_t progress = 0;
+    UDSTransferData transfer{0x7E0, 4};
+    const auto crc = transfer.transfer(mock, data, [&](size_t size) { progress += size; });
+
+    BOOST_REQUIRE_EQUAL(mock.sentFrames.size(), 3u);
+    const std::vector<uint8_t> lastBlock{0x36, 0x03, 0x08, 0x09};
+    BOOST_CHECK(mock.sentFrames[0].data == std::vector<uint8_t>({0x36, 0x01, 0x00, 0x01, 0x02, 0x03}));
+    BOOST_CHECK(mock.sentFrames[1].data == std::vector<uint8_t>({0x36, 0x02, 0x04, 0x05, 0x06, 0x07}));
+    BOOST_CHECK(mock.sentFrames[2].data == lastBlock);
+    BOOST_CHECK_EQUAL(mock.sentFrames[0].id, 0x7E0u);
+    BOOST_CHECK_EQUAL(progress, data.size());
+    BOOST_CHECK_EQUAL(crc, crc16(data.data(), data.size()));
+}
+
+BOOST_AUTO_TEST_CASE(TransferDataCounterWraps)
+{
+    MockICanChannel mock;
+    const auto data = makeData(257);
+    for (size_t i = 1; i <= data.size(); ++i) {
+        mock.receiveQueue.push(makeTransferResponse(static_cast<uint8_t>(i)));
+    }
+
+    UDSTransferData transfer{0x7E0, 1};
+    transfer.transfer(mock, data, [](size_t) {});
+
+    BOOST_REQUIRE_EQUAL(mock.sentFrames.size(), data.size());
+    BOOST_CHECK_EQUAL(mock.sentFrames[255].data[1], 0x00);
+    BOOST_CHECK_EQUAL(mock.sentFrames[256].data[1], 0x01);
+}
+
+BOOST_AUTO_TEST_CASE(TransferDataSkipsPendingResponse)
+{
+    MockICanChannel mock;
+    const auto data = makeData(4);
+    mock.receiveQueue.push({0x7E8, {0x7F, 0x36, 0x78}});
+    mock.receiveQueue.push(makeTransferResponse(1));
+
+    UDSTransferData transfer{0x7E0, 8};
+    BOOST_CHECK_NO_THROW(transfer.transfer(mock, data, [](size_t) {}));
+    BOOST_CHECK_EQUAL(mock.sentFrames.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(TransferDataNegativeResponseThrows)
+{
+    MockICanChannel mock;
+    const auto data = makeData(4);
+    mock.receiveQueue.push({0x7E8, {0x7F, 0x36, 0x73}});
+
+    UDSTransferData transfer{0x7E0, 8};
+    BOOST_CHECK_THROW(transfer.transfer(mock, data, [](size_t) {}), UDSError);
+}
+
+BOOST_AUTO_TEST_CASE(TransferDataNoResponseThrows)
+{
+    MockICanChannel mock;
+    const auto data = makeData(4);
+
+    UDSTransferData transfer{0x7E0, 8, UDSTiming{}, 2};
+    BOOST_CHECK_THROW(transfer.transfer(mock, data, [](size_t) {}), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Crc16Incremental)
+{
+    const auto data = makeData(100);
+    const auto head = crc16(data.data(), 37);
+    BOOST_CHECK_EQUAL(crc16(data.data() + 37, data.size() - 37, head),
+                      crc16(data.data(), data.size()));
+}
+
+// ===========================================================================
+// UDSProtocolCommonSteps::transferChunk
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(TransferChunkSendsTransferExit)
+{
+    MockICanChannel mock;
+    const auto data = makeData(10);
+    mock.receiveQueue.push({0x7E8, {0x74, 0x20, 0x00, 0x82}});
+    mock.receiveQueue.push(makeTransferResponse(1));
+    const auto crc = crc16(data.data(), data.size());
+    mock.receiveQueue.push({0x7E8, {0x77, static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc)}});
+
+    const VBFChunk chunk{0x8000, data, crc};
+    BOOST_CHECK(UDSProtocolCommonSteps::transferChunk(mock, 0x7E0, chunk, [](size_t) {}));
+    BOOST_REQUIRE_EQUAL(mock.sentFrames.size(), 3u);
+    BOOST_CHECK(mock.sentFrames[2].data == std::vector<uint8_t>({0x37}));
+}
+
+BOOST_AUTO_TEST_CASE(TransferChunkFailsOnCrcMismatch)
+{
+    MockICanChannel mock;
+    const auto data = makeData(10);
+    mock.receiveQueue.push({0x7E8, {0x74, 0x20, 0x00, 0x82}});
+    mock.receiveQueue.push(makeTransferResponse(1));
+
+    // CRC из VBF не совпадает с данными - 0x37 не отправляется.
+    const VBFChunk chunk{0x8000, data, static_cast<uint32_t>(crc16(data.data(), data.size()) ^ 0x1)};
+    BOOST_CHECK(!UDSProtocolCommonSteps::transferChunk(mock, 0x7E0, chunk, [](size_t) {}));
+    BOOST_REQUIRE_EQUAL(mock.sentFrames.size(), 2u);
+    BOOST_CHECK_EQUAL(mock.sentFrames[1].data[0], 0x36);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "FlasherBase.hpp"
+#include "FlasherConfigs.hpp"
+
+#include <common/protocols/D2ProtocolCommonSteps.hpp>
+
+#include <vector>
+
+namespace common {
+class ICanChannel;
+} // namespace common
+
+namespace flasher {
+
+// Прошивка нескольких ЭБУ на D2 за один сон шины. Пока пишется один ЭБУ,
+// кадры и контрольные суммы следующего готовятся в фоне.
+class D2MultiFlasher: public FlasherBase {
+public:
+    D2MultiFlasher(j2534::J2534 &j2534, common::CarPlatform carPlatform,
+                   D2MultiFlasherConfig&& config);
+    ~D2MultiFlasher();
+
+protected:
+    void startImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels) override;
+
+private:
+    D2MultiFlasherConfig _config;
+    std::vector<common::D2TransferPlan> _flashPlans;
+};
+
+} // namespace flasher
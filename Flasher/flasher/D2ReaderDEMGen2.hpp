@@ -15,7 +15,7 @@ protected:
     void startImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels) override;
 
 private:
-    void readStep(common::ICanChannel &channel, uint8_t ecuId);
+    void readStep(common::ICanChannel &channel);
 
 private:
     common::VBF _bootloader;
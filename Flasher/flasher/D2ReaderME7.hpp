@@ -11,14 +11,19 @@ public:
     D2ReaderME7(j2534::J2534& j2534, common::CarPlatform carPlatform, uint32_t ecuId,
                 ReadRanges ranges, common::VBF bootloader);
 
+    // Upper bound for the number of read requests kept in flight. The actual
+    // window starts small and adapts to how many requests the ECU can queue.
+    void setMaxReadWindow(size_t maxReadWindow);
+
 protected:
     void startImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels) override;
 
 private:
-    void readStep(common::ICanChannel &channel, uint8_t ecuId);
+    void readStep(common::ICanChannel &channel);
 
 private:
     common::VBF _bootloader;
+    size_t _maxReadWindow;
 };
 
 } // namespace flasher
@@ -39,6 +39,9 @@ public:
 
 protected:
     virtual void startImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels) = 0;
+    // Вызываются в потоке операции до открытия и после закрытия её каналов.
+    virtual void beforeOpenChannels() {}
+    virtual void afterCloseChannels() {}
 
     void setCurrentState(FlasherState state);
     void setCurrentProgress(size_t currentProgress);
@@ -7,7 +7,14 @@
 
 #include <array>
 #include <cstdint>
+#include <map>
 #include <memory>
+#include <string>
+#include <vector>
+
+namespace common {
+class UDSSession;
+} // namespace common
 
 namespace flasher {
 
@@ -16,10 +23,49 @@ struct D2FlasherConfig {
     const common::VBF flash;
 };
 
+struct D2MultiFlasherTarget {
+    uint8_t ecuId;
+    common::VBF bootloader;
+    common::VBF flash;
+};
+
+// ЭБУ прошиваются по очереди за один цикл fallAsleep/wakeUp.
+struct D2MultiFlasherConfig {
+    std::vector<D2MultiFlasherTarget> targets;
+};
+
 struct UDSFlasherConfig {
     std::array<uint8_t, 5> pin;
     common::VBF bootloader;
     const common::VBF flash;
+    // Прошивка загружается в формате, который ЭБУ принимает (ECUInfo), загрузчик - всегда как есть.
+    common::CompressionType compressionType{ common::CompressionType::None };
+    common::EncryptionType encryptionType{ common::EncryptionType::None };
+    std::map<std::string, std::string> encryptionParams;
+    // Сжимать оптимальным разбором LZSS: меньше байт по шине за счёт CPU.
+    bool optimalCompression{ false };
+    // Сессия, открытая предыдущей операцией (например, чтением): засыпание сети
+    // и авторизация пропускаются, если она ещё жива. После прошивки закрывается.
+    std::shared_ptr<common::UDSSession> session;
+};
+
+struct UDSMultiFlasherTarget {
+    uint32_t ecuId;
+    // Нулевой PIN - берётся из UDSPinCache по VIN машины.
+    std::array<uint8_t, 5> pin;
+    // Пустой загрузчик не грузится и не запускается.
+    common::VBF bootloader;
+    common::VBF flash;
+    // Как в UDSFlasherConfig: прошивка в формате, который ЭБУ принимает.
+    common::CompressionType compressionType{ common::CompressionType::None };
+    common::EncryptionType encryptionType{ common::EncryptionType::None };
+    std::map<std::string, std::string> encryptionParams;
+    bool optimalCompression{ false };
+};
+
+// ЭБУ одной шины прошиваются одновременно, запросы к ним чередуются.
+struct UDSMultiFlasherConfig {
+    std::vector<UDSMultiFlasherTarget> targets;
 };
 
 struct KWPFlasherConfig {
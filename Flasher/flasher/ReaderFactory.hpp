@@ -6,15 +6,22 @@
 
 #include <memory>
 
+namespace common {
+class UDSSession;
+} // namespace common
+
 namespace flasher {
 
 class ReaderBase;
 
 class ReaderFactory {
 public:
+    // session используется UDS чтением: открытая сессия переиспользуется,
+    // а без PIN в params он берётся из UDSPinCache.
     static std::unique_ptr<ReaderBase> create(
         j2534::J2534& j2534,
-        const ReaderParametersProviderBase& params);
+        const ReaderParametersProviderBase& params,
+        std::shared_ptr<common::UDSSession> session = {});
 };
 
 } // namespace flasher
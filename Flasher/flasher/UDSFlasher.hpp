@@ -17,6 +17,7 @@ namespace flasher {
 
     private:
         void startImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels) override;
+        void beforeOpenChannels() override;
 
         const UDSFlasherConfig _config;
     };
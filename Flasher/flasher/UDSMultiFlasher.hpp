@@ -0,0 +1,30 @@
+#pragma once
+
+#include "FlasherBase.hpp"
+#include "FlasherConfigs.hpp"
+
+#include <vector>
+
+namespace common {
+class ICanChannel;
+} // namespace common
+
+namespace flasher {
+
+// Прошивка нескольких UDS ЭБУ за один сон шины. Сессия программирования и
+// TesterPresent общие (функциональный адрес), у каждого ЭБУ свой flow control
+// фильтр в канале шины, а загрузка в разные ЭБУ чередуется блоками.
+class UDSMultiFlasher: public FlasherBase {
+public:
+    UDSMultiFlasher(j2534::J2534& j2534, common::CarPlatform carPlatform,
+                    UDSMultiFlasherConfig&& config);
+    ~UDSMultiFlasher();
+
+protected:
+    void startImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels) override;
+
+private:
+    const UDSMultiFlasherConfig _config;
+};
+
+} // namespace flasher
@@ -4,19 +4,30 @@
 
 #include <common/CanIdProvider.hpp>
 
+#include <memory>
+
+namespace common {
+class UDSSession;
+} // namespace common
+
 namespace flasher {
 
 class UDSReader : public ReaderBase {
 public:
+    // С session сессия после чтения остаётся открытой для следующей операции,
+    // а открытая ранее используется без засыпания сети и авторизации.
     UDSReader(j2534::J2534& j2534, common::CarPlatform carPlatform, uint32_t ecuId,
-              ReadRanges ranges, uint64_t pin);
+              ReadRanges ranges, uint64_t pin, std::shared_ptr<common::UDSSession> session = {});
 
 protected:
     void startImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels) override;
+    void beforeOpenChannels() override;
+    void afterCloseChannels() override;
 
 private:
     uint64_t _pin;
     std::unique_ptr<common::CanIdProvider> _canIdProvider;
+    std::shared_ptr<common::UDSSession> _session;
 };
 
 } // namespace flasher
@@ -0,0 +1,192 @@
+#include "D2BulkReader.hpp"
+
+#include <common/ICanChannel.hpp>
+
+#define LOG_MODULE_NAME "flasher"
+#include <common/LogHelper.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t InitialWindow{ 2 };
+
+struct PendingRead {
+    uint32_t offset;
+    uint32_t end;
+};
+
+} // namespace anonymous
+
+namespace flasher {
+
+/*static*/ D2BulkReader::FrameDecoder D2BulkReader::rawPayloadDecoder(size_t headerSize)
+{
+    return [headerSize](const common::CanFrame& frame, uint8_t* out, size_t maxSize) -> size_t {
+        if (frame.data.size() <= headerSize) {
+            return 0;
+        }
+        const size_t bytes = std::min(frame.data.size() - headerSize, maxSize);
+        std::copy_n(frame.data.cbegin() + headerSize, bytes, out);
+        return bytes;
+    };
+}
+
+D2BulkReader::D2BulkReader(Config config, ProgressCallback progressCallback)
+    : _config{ std::move(config) }
+    , _progressCallback{ std::move(progressCallback) }
+{
+}
+
+void D2BulkReader::read(common::ICanChannel& channel, const ReadRange& range, std::vector<uint8_t>& buffer)
+{
+    buffer.assign(range.size, 0);
+    read(channel, range, buffer.data());
+}
+
+void D2BulkReader::read(common::ICanChannel& channel, const ReadRange& range, uint8_t* out)
+{
+    if (_config.chunkReader) {
+        readChunks(channel, range, out);
+    }
+    else {
+        readFrames(channel, range, out);
+    }
+}
+
+// Запросы отправляются пачками по window штук, кадры ответов сопоставляются с
+// запросами по порядку прихода: адреса в ответе нет, а ЭБУ отвечает строго
+// последовательно. Пачка считается принятой только целиком - если хотя бы
+// один кадр потерян, сопоставление остальных недостоверно и вся пачка
+// перезапрашивается, а окно уменьшается вдвое. После window успешных пачек
+// подряд окно растёт на единицу, но не больше maxWindow.
+void D2BulkReader::readFrames(common::ICanChannel& channel, const ReadRange& range, uint8_t* out)
+{
+    const auto rangeSize = static_cast<uint32_t>(range.size);
+    const size_t maxWindow = std::max<size_t>(_config.maxWindow, 1);
+    const auto framesForRead = [this](const PendingRead& read) {
+        const size_t size = read.end - read.offset;
+        return (size + _config.framePayloadSize - 1) / _config.framePayloadSize;
+    };
+
+    std::deque<PendingRead> retries;
+    std::vector<PendingRead> batch;
+    std::vector<PendingRead> shortReplies;
+    std::vector<common::CanFrame> requests;
+    std::vector<common::CanFrame> answers;
+    batch.reserve(maxWindow);
+    requests.reserve(maxWindow);
+
+    size_t window{ std::min(InitialWindow, maxWindow) };
+    size_t successStreak{ 0 };
+    size_t errorCount{ 0 };
+    uint32_t nextOffset{ 0 };
+    while (nextOffset < rangeSize || !retries.empty()) {
+        batch.clear();
+        requests.clear();
+        shortReplies.clear();
+        size_t expectedFrames{ 0 };
+        while (batch.size() < window && (!retries.empty() || nextOffset < rangeSize)) {
+            PendingRead read;
+            if (!retries.empty()) {
+                read = retries.front();
+                retries.pop_front();
+            }
+            else {
+                read = { nextOffset, static_cast<uint32_t>(std::min<size_t>(nextOffset + _config.chunkSize, rangeSize)) };
+                nextOffset = read.end;
+            }
+            batch.push_back(read);
+            requests.push_back(_config.requestBuilder(range.startAddr + read.offset, read.end - read.offset));
+            expectedFrames += framesForRead(read);
+        }
+
+        size_t completed{ 0 };
+        size_t receivedBytes{ 0 };
+        bool failed{ !channel.send(requests) };
+        if (failed) {
+            LOG_MODULE(ERROR) << "write msgs error";
+        }
+        size_t readBytes{ 0 };
+        size_t frameCount{ 0 };
+        while (!failed && completed < batch.size()) {
+            answers.clear();
+            if (!channel.receive(answers, expectedFrames, _config.timeout) || answers.empty()) {
+                failed = true;
+                break;
+            }
+            for (const auto& answer : answers) {
+                const auto& read = batch[completed];
+                const size_t remaining = read.end - read.offset - readBytes;
+                const size_t bytes = _config.frameDecoder(answer, out + read.offset + readBytes, remaining);
+                if (bytes == 0 && remaining > 0) {
+                    failed = true;
+                    break;
+                }
+                readBytes += bytes;
+                --expectedFrames;
+                if (++frameCount == framesForRead(read)) {
+                    if (read.offset + readBytes < read.end) {
+                        shortReplies.push_back({ static_cast<uint32_t>(read.offset + readBytes), read.end });
+                    }
+                    receivedBytes += readBytes;
+                    readBytes = 0;
+                    frameCount = 0;
+                    if (++completed == batch.size()) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (!failed) {
+            _progressCallback(receivedBytes);
+            retries.insert(retries.end(), shortReplies.cbegin(), shortReplies.cend());
+            errorCount = 0;
+            if (++successStreak >= window && window < maxWindow) {
+                ++window;
+                successStreak = 0;
+            }
+            continue;
+        }
+
+        LOG_MODULE(ERROR) << "Failed to receive message, " << completed << " of " << batch.size()
+                          << " replies at offset " << batch.front().offset << ", window " << window;
+        if (errorCount++ >= _config.maxErrorCount) {
+            throw std::runtime_error("Failed to receive message");
+        }
+        retries.insert(retries.begin(), batch.cbegin(), batch.cend());
+        window = std::max<size_t>(window / 2, 1);
+        successStreak = 0;
+        channel.clearRx();
+    }
+}
+
+void D2BulkReader::readChunks(common::ICanChannel& channel, const ReadRange& range, uint8_t* out)
+{
+    size_t errorCount{ 0 };
+    size_t offset{ 0 };
+    while (offset < range.size) {
+        const size_t requestSize = std::min(_config.chunkSize, range.size - offset);
+        try {
+            const size_t bytes = _config.chunkReader(channel, static_cast<uint32_t>(range.startAddr + offset),
+                                                     out + offset, requestSize);
+            if (bytes == 0) {
+                throw std::runtime_error("Empty read response");
+            }
+            offset += bytes;
+            _progressCallback(bytes);
+            errorCount = 0;
+        }
+        catch (const std::exception& ex) {
+            LOG_MODULE(ERROR) << ex.what();
+            if (errorCount++ >= _config.maxErrorCount) {
+                throw;
+            }
+        }
+    }
+}
+
+} // namespace flasher
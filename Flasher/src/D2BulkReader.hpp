@@ -0,0 +1,62 @@
+#pragma once
+
+#include "flasher/ParamsTypes.hpp"
+
+#include <common/CanFrame.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace common {
+class ICanChannel;
+} // namespace common
+
+namespace flasher {
+
+// Общий движок чтения памяти ЭБУ по D2. Конкретный читатель задаёт только
+// формат запроса, разбор ответа и размер порции, а повторы, окно запросов и
+// прогресс движок берёт на себя. Данные пишутся сразу в буфер диапазона.
+//
+// Поддерживаются два вида ответов:
+//  - "сырые" кадры (0xBC/0xB6 загрузчика): на запрос приходит фиксированное
+//    число кадров, каждый из которых раскладывает frameDecoder. Запросы
+//    отправляются пачками до maxWindow штук;
+//  - ответы в формате D2Request: всю порцию целиком читает chunkReader.
+class D2BulkReader {
+public:
+    using RequestBuilder = std::function<common::CanFrame(uint32_t addr, size_t size)>;
+    // Копирует полезные данные кадра в out (не более maxSize байт) и возвращает их число.
+    using FrameDecoder = std::function<size_t(const common::CanFrame& frame, uint8_t* out, size_t maxSize)>;
+    // Читает size байт по адресу addr в out и возвращает число прочитанных байт.
+    using ChunkReader = std::function<size_t(common::ICanChannel& channel, uint32_t addr, uint8_t* out, size_t size)>;
+    using ProgressCallback = std::function<void(size_t)>;
+
+    struct Config {
+        size_t chunkSize{ 0 };
+        size_t framePayloadSize{ 0 };
+        size_t maxWindow{ 1 };
+        unsigned long timeout{ 1000 };
+        size_t maxErrorCount{ 10 };
+        RequestBuilder requestBuilder;
+        FrameDecoder frameDecoder;
+        ChunkReader chunkReader;
+    };
+
+    // Декодер кадров загрузчика: данные идут после заголовка из headerSize байт.
+    static FrameDecoder rawPayloadDecoder(size_t headerSize);
+
+    D2BulkReader(Config config, ProgressCallback progressCallback);
+
+    void read(common::ICanChannel& channel, const ReadRange& range, std::vector<uint8_t>& buffer);
+    void read(common::ICanChannel& channel, const ReadRange& range, uint8_t* out);
+
+private:
+    void readFrames(common::ICanChannel& channel, const ReadRange& range, uint8_t* out);
+    void readChunks(common::ICanChannel& channel, const ReadRange& range, uint8_t* out);
+
+    const Config _config;
+    const ProgressCallback _progressCallback;
+};
+
+} // namespace flasher
@@ -5,6 +5,8 @@
 #include <common/Util.hpp>
 #include <common/protocols/D2ProtocolCommonSteps.hpp>
 
+#include <stdexcept>
+
 #define HFSM2_ENABLE_ALL
 #include <common/hfsm2/machine.hpp>
 
@@ -13,6 +15,24 @@
 
 namespace flasher {
 
+D2FlasherImpl::D2FlasherImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels,
+                               common::CarPlatform carPlatform,
+                               std::vector<Target> targets,
+                               const std::function<void(FlasherState)>& stateUpdater,
+                               const std::function<void(size_t)>& progressUpdater)
+    : _channels{ channels }
+    , _carPlatform{ carPlatform }
+    , _targets{ std::move(targets) }
+    , _sblPlans( _targets.size() )
+    , _stateUpdater{ stateUpdater }
+    , _progressUpdater{ progressUpdater }
+    , _preparations( _targets.size() )
+{
+    if (_targets.empty()) {
+        throw std::invalid_argument("D2FlasherImpl: no targets");
+    }
+}
+
 D2FlasherImpl::D2FlasherImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels,
                                common::CarPlatform carPlatform,
                                uint8_t ecuId,
@@ -21,21 +41,21 @@ D2FlasherImpl::D2FlasherImpl(const std::vector<std::unique_ptr<common::ICanChann
                                const std::function<void(size_t)>& progressUpdater,
                                const std::function<void(common::ICanChannel&, uint8_t)>& eraseCallback,
                                const std::function<void(common::ICanChannel&, uint8_t)>& writeCallback)
-    : _channels{ channels }
-    , _carPlatform{ carPlatform }
-    , _ecuId{ ecuId }
-    , _bootloader{ bootloader }
-    , _stateUpdater{ stateUpdater }
-    , _progressUpdater{ progressUpdater }
-    , _eraseCallback{ eraseCallback }
-    , _writeCallback{ writeCallback }
+    : D2FlasherImpl{ channels, carPlatform,
+                     { Target{ ecuId, bootloader, eraseCallback, writeCallback, {} } },
+                     stateUpdater, progressUpdater }
 {
 }
 
 size_t D2FlasherImpl::getMaximumProgress() const
 {
     const size_t stepCost = 100;
-    return stepCost * 4 + FlasherBase::getProgressFromVBF(_bootloader) + getMaximumFlashProgressValue();
+    size_t bootloadersProgress = 0;
+    for (const auto& target : _targets) {
+        bootloadersProgress += FlasherBase::getProgressFromVBF(target.bootloader);
+    }
+    // Служебные шаги проходит каждый ЭБУ.
+    return stepCost * 4 * _targets.size() + bootloadersProgress + getMaximumFlashProgressValue();
 }
 
 void D2FlasherImpl::setMaximumFlashProgressValue(size_t value)
@@ -48,9 +68,47 @@ size_t D2FlasherImpl::getMaximumFlashProgressValue() const
     return _maximumFlashProgress;
 }
 
+const D2FlasherImpl::Target& D2FlasherImpl::currentTarget() const
+{
+    return _targets[_currentTarget];
+}
+
+void D2FlasherImpl::startPreparation(size_t targetIndex)
+{
+    if (targetIndex >= _targets.size() || _preparations[targetIndex].valid()) {
+        return;
+    }
+    _preparations[targetIndex] = std::async(std::launch::async, [this, targetIndex]() {
+        const auto& target = _targets[targetIndex];
+        _sblPlans[targetIndex] = common::D2ProtocolCommonSteps::planTransfer(target.ecuId, target.bootloader);
+        if (target.prepareCallback) {
+            target.prepareCallback();
+        }
+    });
+}
+
+bool D2FlasherImpl::waitPreparation(size_t targetIndex)
+{
+    if (!_preparations[targetIndex].valid()) {
+        return true;
+    }
+    try {
+        _preparations[targetIndex].get();
+        return true;
+    }
+    catch(const std::exception& ex) {
+        setFailed(ex.what());
+    }
+    catch(...) {
+        setFailed("Target preparation failed");
+    }
+    return false;
+}
+
 void D2FlasherImpl::fallAsleep()
 {
     _stateUpdater(FlasherState::FallAsleep);
+    startPreparation(_currentTarget);
     try {
         if (!common::D2ProtocolCommonSteps::fallAsleep(_channels)) {
             setFailed("Fall asleep failed");
@@ -64,12 +122,23 @@ void D2FlasherImpl::fallAsleep()
     }
 }
 
+bool D2FlasherImpl::selectNextTarget()
+{
+    if (_currentTarget + 1 >= _targets.size()) {
+        return false;
+    }
+    ++_currentTarget;
+    return true;
+}
+
 void D2FlasherImpl::startPBL()
 {
     _stateUpdater(FlasherState::OpenChannels);
     try {
-        auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, _channels) };
-        if (!common::D2ProtocolCommonSteps::startPBL(channel, _ecuId)) {
+        startPreparation(_currentTarget + 1);
+        const uint8_t ecuId = currentTarget().ecuId;
+        auto& channel{ common::getChannelByEcuId(_carPlatform, ecuId, _channels) };
+        if (!common::D2ProtocolCommonSteps::startPBL(channel, ecuId)) {
             setFailed("Start PBL failed");
         }
     }
@@ -87,10 +156,14 @@ void D2FlasherImpl::loadSBL()
         return;
     }
     _stateUpdater(FlasherState::LoadBootloader);
+    if (!waitPreparation(_currentTarget)) {
+        return;
+    }
     try {
-        auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, _channels) };
-        if (!common::D2ProtocolCommonSteps::transferData(channel, _ecuId,
-                                                          _bootloader, _progressUpdater)) {
+        const uint8_t ecuId = currentTarget().ecuId;
+        auto& channel{ common::getChannelByEcuId(_carPlatform, ecuId, _channels) };
+        if (!common::D2ProtocolCommonSteps::transferData(channel, ecuId,
+                                                          _sblPlans[_currentTarget], _progressUpdater)) {
             setFailed("SBL loading failed");
         }
     }
@@ -109,9 +182,10 @@ void D2FlasherImpl::startSBL()
     }
     _stateUpdater(FlasherState::StartBootloader);
     try {
-        auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, _channels) };
-        if (!common::D2ProtocolCommonSteps::startRoutine(channel, _ecuId,
-                                                          _bootloader.header.call)) {
+        const auto& target = currentTarget();
+        auto& channel{ common::getChannelByEcuId(_carPlatform, target.ecuId, _channels) };
+        if (!common::D2ProtocolCommonSteps::startRoutine(channel, target.ecuId,
+                                                          target.bootloader.header.call)) {
             setFailed("SBL start failed");
         }
     }
@@ -126,9 +200,13 @@ void D2FlasherImpl::startSBL()
 void D2FlasherImpl::eraseFlash()
 {
     _stateUpdater(FlasherState::EraseFlash);
-    auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, _channels) };
+    if (!waitPreparation(_currentTarget)) {
+        return;
+    }
+    const auto& target = currentTarget();
+    auto& channel{ common::getChannelByEcuId(_carPlatform, target.ecuId, _channels) };
     try {
-        _eraseCallback(channel, _ecuId);
+        target.eraseCallback(channel, target.ecuId);
     }
     catch (...) {
         setFailed("Erase flash failed");
@@ -138,9 +216,10 @@ void D2FlasherImpl::eraseFlash()
 void D2FlasherImpl::writeFlash()
 {
     _stateUpdater(FlasherState::WriteFlash);
-    auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, _channels) };
+    const auto& target = currentTarget();
+    auto& channel{ common::getChannelByEcuId(_carPlatform, target.ecuId, _channels) };
     try {
-        _writeCallback(channel, _ecuId);
+        target.writeCallback(channel, target.ecuId);
     }
     catch (...) {
         setFailed("Write flash failed");
@@ -188,7 +267,7 @@ bool D2FlasherImpl::isFailed() const
 
 bool D2FlasherImpl::isSBLRequired() const
 {
-    return !_bootloader.chunks.empty();
+    return !currentTarget().bootloader.chunks.empty();
 }
 
 void D2FlasherImpl::setFailed(const std::string& message)
@@ -209,7 +288,8 @@ using FSM = M::PeerRoot<
         struct LoadSBL,
         struct StartSBL,
         struct EraseFlash,
-        struct WriteFlash>,
+        struct WriteFlash,
+        struct NextTarget>,
     M::Composite<
         struct Finish,
         struct WakeUpFinish,
@@ -246,6 +326,7 @@ struct StartWork : public FSM::State {
         plan.change<LoadSBL, StartSBL>();
         plan.change<StartSBL, EraseFlash>();
         plan.change<EraseFlash, WriteFlash>();
+        plan.change<WriteFlash, NextTarget>();
     }
 
     void planSucceeded(FullControl& control) {
@@ -300,6 +381,24 @@ struct WriteFlash : public BaseState {
     }
 };
 
+// Следующий ЭБУ шьётся без повторного fallAsleep: шина уже усыплена.
+// Если целей больше нет, план пуст и StartWork переходит к Finish.
+struct NextTarget : public BaseState {
+    void enter(PlanControl& control)
+    {
+        if (!control.context().selectNextTarget()) {
+            return;
+        }
+        auto plan = control.plan();
+        plan.change<NextTarget, StartPBL>();
+        plan.change<StartPBL, LoadSBL>();
+        plan.change<LoadSBL, StartSBL>();
+        plan.change<StartSBL, EraseFlash>();
+        plan.change<EraseFlash, WriteFlash>();
+        plan.change<WriteFlash, NextTarget>();
+    }
+};
+
 struct Finish : public FSM::State {
     void enter(PlanControl& control)
     {
@@ -347,6 +446,7 @@ void D2FlasherImpl::run()
 {
     _isDone = false;
     _isFailed = false;
+    _currentTarget = 0;
     FSM::Instance fsm{ *this };
     while (!_isDone) {
         fsm.update();
@@ -4,9 +4,11 @@
 
 #include <common/CarPlatform.hpp>
 #include <common/VBF.hpp>
+#include <common/protocols/D2ProtocolCommonSteps.hpp>
 
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <memory>
 #include <vector>
 
@@ -18,6 +20,23 @@ namespace flasher {
 
 class D2FlasherImpl {
 public:
+    // Один ЭБУ в задании. Все цели шьются за один цикл fallAsleep/wakeUp:
+    // PBL/SBL/стирание/запись выполняются для них по очереди.
+    struct Target {
+        uint8_t ecuId;
+        common::VBF bootloader;
+        std::function<void(common::ICanChannel&, uint8_t)> eraseCallback;
+        std::function<void(common::ICanChannel&, uint8_t)> writeCallback;
+        // Подготовка данных цели без обращения к шине. Выполняется в фоне,
+        // пока шьётся предыдущая цель (для первой - во время fallAsleep).
+        std::function<void()> prepareCallback;
+    };
+
+    D2FlasherImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels,
+                   common::CarPlatform carPlatform,
+                   std::vector<Target> targets,
+                   const std::function<void(FlasherState)>& stateUpdater,
+                   const std::function<void(size_t)>& progressUpdater);
     D2FlasherImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels,
                    common::CarPlatform carPlatform,
                    uint8_t ecuId,
@@ -36,6 +55,7 @@ public:
     bool isSBLRequired() const;
 
     void fallAsleep();
+    bool selectNextTarget();
     void startPBL();
     void loadSBL();
     void startSBL();
@@ -49,19 +69,23 @@ public:
 private:
     size_t getMaximumFlashProgressValue() const;
     void setFailed(const std::string& msg);
+    const Target& currentTarget() const;
+    void startPreparation(size_t targetIndex);
+    bool waitPreparation(size_t targetIndex);
 
     const std::vector<std::unique_ptr<common::ICanChannel>>& _channels;
     common::CarPlatform _carPlatform;
-    uint8_t _ecuId;
-    common::VBF _bootloader;
+    std::vector<Target> _targets;
+    std::vector<common::D2TransferPlan> _sblPlans;
+    size_t _currentTarget = 0;
     bool _isFailed = false;
     bool _isDone = false;
     std::string _errorMessage;
     size_t _maximumFlashProgress = 0;
     const std::function<void(FlasherState)> _stateUpdater;
     const std::function<void(size_t)> _progressUpdater;
-    const std::function<void(common::ICanChannel&, uint8_t)> _eraseCallback;
-    const std::function<void(common::ICanChannel&, uint8_t)> _writeCallback;
+    // Объявлен последним: при разрушении сначала дожидаемся фоновой подготовки.
+    std::vector<std::future<void>> _preparations;
 };
 
 } // namespace flasher
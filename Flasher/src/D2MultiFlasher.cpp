@@ -0,0 +1,73 @@
+#include "flasher/D2MultiFlasher.hpp"
+#include "D2FlasherImpl.hpp"
+
+#include <common/ICanChannel.hpp>
+#include <j2534/J2534.hpp>
+
+#define LOG_MODULE_NAME "flasher"
+#include <common/LogHelper.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace flasher {
+
+D2MultiFlasher::D2MultiFlasher(j2534::J2534 &j2534, common::CarPlatform carPlatform,
+                               D2MultiFlasherConfig&& config)
+    : FlasherBase{ j2534, carPlatform,
+                   config.targets.empty() ? 0u : config.targets.front().ecuId }
+    , _config{ std::move(config) }
+{
+    if (_config.targets.empty()) {
+        throw std::invalid_argument("No ECU to flash");
+    }
+}
+
+D2MultiFlasher::~D2MultiFlasher()
+{
+}
+
+void D2MultiFlasher::startImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels)
+{
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+
+    setCurrentProgress(0);
+    _flashPlans.assign(_config.targets.size(), {});
+
+    size_t flashProgress = 0;
+    std::vector<D2FlasherImpl::Target> targets;
+    targets.reserve(_config.targets.size());
+    for (size_t i = 0; i < _config.targets.size(); ++i) {
+        const auto& target = _config.targets[i];
+        flashProgress += getProgressFromVBF(target.flash);
+        targets.push_back({ target.ecuId, target.bootloader,
+            [&target](common::ICanChannel& ch, uint8_t id) {
+                common::D2ProtocolCommonSteps::eraseFlash(ch, id, target.flash);
+            },
+            [this, i](common::ICanChannel& ch, uint8_t id) {
+                common::D2ProtocolCommonSteps::transferData(ch, id, _flashPlans[i],
+                    [this](size_t progress) {
+                    incCurrentProgress(progress);
+                });
+            },
+            [this, &target, i]() {
+                _flashPlans[i] = common::D2ProtocolCommonSteps::planTransfer(target.ecuId, target.flash);
+            } });
+    }
+
+    D2FlasherImpl impl(channels, _carPlatform, std::move(targets),
+        [this](FlasherState state) {
+            setCurrentState(state);
+        },
+        [this](size_t progress) {
+            incCurrentProgress(progress);
+        });
+
+    impl.setMaximumFlashProgressValue(flashProgress);
+    setMaximumProgress(impl.getMaximumProgress());
+
+    impl.run();
+}
+
+} // namespace flasher
@@ -1,4 +1,5 @@
 #include "flasher/D2ReaderAW55.hpp"
+#include "D2BulkReader.hpp"
 
 #include <common/ICanChannel.hpp>
 #include <common/protocols/D2Request.hpp>
@@ -19,24 +20,20 @@ void D2ReaderAW55::startImpl(const std::vector<std::unique_ptr<common::ICanChann
     auto& channel = *channels[0];
     const uint8_t ecuId = static_cast<uint8_t>(_ecuId);
 
+    D2BulkReader::Config config;
+    // 0xA7 отдаёт до 4 байт за запрос - так же читает параметры логгер AW55.
+    config.chunkSize = 4;
+    config.chunkReader = [ecuId](common::ICanChannel& channel, uint32_t addr, uint8_t* out, size_t size) {
+        common::D2Request readRequest{
+            common::D2Messages::createReadDataByOffsetMsg(
+                ecuId, addr, static_cast<uint8_t>(size)) };
+        return readRequest.process(channel, std::span<uint8_t>{ out, size }).size();
+    };
+
     setCurrentState(FlasherState::ReadFlash);
+    D2BulkReader reader{ std::move(config), [this](size_t progress) { incCurrentProgress(progress); } };
     for(size_t i = 0; i < _ranges.size(); ++i) {
-        auto& buffer = _buffers[i];
-        buffer.clear();
-        const ReadRange& range = _ranges[i];
-        buffer.reserve(range.size);
-
-        for (uint32_t j = 0; j < range.size; ++j) {
-            const uint32_t currentAddr = range.startAddr + j;
-            common::D2Request readRequest{
-                common::D2Messages::createReadDataByOffsetMsg(
-                    ecuId, currentAddr, 1) };
-            auto response = readRequest.process(channel);
-            if (!response.empty()) {
-                buffer.push_back(response[0]);
-            }
-            incCurrentProgress(1);
-        }
+        reader.read(channel, _ranges[i], _buffers[i]);
     }
 
     setCurrentState(FlasherState::Done);
@@ -1,4 +1,5 @@
 #include "flasher/D2ReaderDEMGen2.hpp"
+#include "D2BulkReader.hpp"
 #include "D2FlasherImpl.hpp"
 
 #include <common/ICanChannel.hpp>
@@ -15,23 +16,6 @@
 
 #include <numeric>
 
-namespace {
-
-common::CanFrame writeMessagesAndReadMessage(common::ICanChannel& channel,
-                                             const common::CanFrame& msg)
-{
-    if (!channel.send(msg)) {
-        throw std::runtime_error("write msgs error");
-    }
-    common::CanFrame response;
-    if (!channel.receive(response, 100)) {
-        throw std::runtime_error("Failed to receive message");
-    }
-    return response;
-}
-
-} // namespace anonymous
-
 namespace flasher {
 
 D2ReaderDEMGen2::D2ReaderDEMGen2(j2534::J2534& j2534, common::CarPlatform carPlatform, uint32_t ecuId,
@@ -51,47 +35,34 @@ void D2ReaderDEMGen2::startImpl(const std::vector<std::unique_ptr<common::ICanCh
             incCurrentProgress(progress);
         },
         [](common::ICanChannel&, uint8_t) {},  // erase — no-op
-        [this](common::ICanChannel& channel, uint8_t ecuId) {
-            readStep(channel, ecuId);
+        [this](common::ICanChannel& channel, uint8_t) {
+            readStep(channel);
         });
 
     impl.setMaximumFlashProgressValue(getMaximumProgress());
     impl.run();
 }
 
-void D2ReaderDEMGen2::readStep(common::ICanChannel &channel, uint8_t ecuId)
+void D2ReaderDEMGen2::readStep(common::ICanChannel &channel)
 {
     channel.clearRx();
     channel.clearTx();
-    for (size_t r = 0; r < _ranges.size(); ++r) {
-        auto& buffer = _buffers[r];
-        buffer.clear();
-        const auto& range = _ranges[r];
-        buffer.reserve(range.size);
 
-        size_t chunkSize{ 0 };
-        size_t errorCount{ 0 };
-        for (uint32_t i = 0; i < range.size; i += chunkSize) {
-            chunkSize = 0;
-            const auto currentPos = range.startAddr + i;
-            const auto msg = common::D2RawMessages::createReadOffsetMsgDEM(
-                static_cast<uint8_t>(common::D2ECUType::DEM), currentPos);
-            try {
-                const auto answer = writeMessagesAndReadMessage(channel, msg);
-                for(size_t s = 2; s < answer.data.size() && i + chunkSize < range.size; ++s) {
-                    buffer.push_back(answer.data[s]);
-                    incCurrentProgress(1);
-                    ++chunkSize;
-                }
-                errorCount = 0;
-            }
-            catch(const std::exception& ex) {
-                LOG_MODULE(ERROR) << ex.what();
-                if(errorCount++ >= 10) {
-                    throw;
-                }
-            }
-        }
+    D2BulkReader::Config config;
+    config.chunkSize = 6;
+    config.framePayloadSize = 6;
+    // Пачки запросов на загрузчике DEM Gen2 не проверены - по одному, как и раньше.
+    config.maxWindow = 1;
+    config.timeout = 100;
+    config.requestBuilder = [](uint32_t addr, size_t) {
+        return common::D2RawMessages::createReadOffsetMsgDEM(
+            static_cast<uint8_t>(common::D2ECUType::DEM), addr);
+    };
+    config.frameDecoder = D2BulkReader::rawPayloadDecoder(2);
+
+    D2BulkReader reader{ std::move(config), [this](size_t progress) { incCurrentProgress(progress); } };
+    for (size_t r = 0; r < _ranges.size(); ++r) {
+        reader.read(channel, _ranges[r], _buffers[r]);
     }
 }
 
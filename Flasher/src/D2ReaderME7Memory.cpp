@@ -1,4 +1,5 @@
 #include "flasher/D2ReaderME7Memory.hpp"
+#include "D2BulkReader.hpp"
 
 #include <common/ICanChannel.hpp>
 #include <common/protocols/D2Request.hpp>
@@ -18,27 +19,20 @@ void D2ReaderME7Memory::startImpl(const std::vector<std::unique_ptr<common::ICan
 {
     auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, channels) };
     const uint8_t ecuId{ static_cast<uint8_t>(_ecuId) };
-    constexpr uint32_t memoryChunk{ 8 };
+
+    D2BulkReader::Config config;
+    config.chunkSize = 8;
+    config.chunkReader = [ecuId](common::ICanChannel& channel, uint32_t addr, uint8_t* out, size_t size) {
+        common::D2Request readRequest{
+            common::D2Messages::createReadDataByAddrMsg(
+                ecuId, addr, static_cast<uint8_t>(size)) };
+        return readRequest.process(channel, std::span<uint8_t>{ out, size }).size();
+    };
 
     setCurrentState(FlasherState::ReadFlash);
+    D2BulkReader reader{ std::move(config), [this](size_t progress) { incCurrentProgress(progress); } };
     for(size_t i = 0; i < _ranges.size(); ++i) {
-        auto& buffer = _buffers[i];
-        buffer.clear();
-        const ReadRange& range = _ranges[i];
-        buffer.reserve(range.size);
-
-        for (uint32_t j = 0; j < range.size; j += memoryChunk) {
-            const uint32_t currentAddr{ range.startAddr + j };
-            const auto currentChunkSize{ std::min(static_cast<uint32_t>(range.size) - j, memoryChunk) };
-            common::D2Request readRequest{
-                common::D2Messages::createReadDataByAddrMsg(
-                    ecuId, currentAddr, currentChunkSize) };
-            auto response = readRequest.process(channel);
-            if (!response.empty()) {
-                buffer.insert(buffer.end(), response.data(), response.data() + currentChunkSize);
-            }
-            incCurrentProgress(currentChunkSize);
-        }
+        reader.read(channel, _ranges[i], _buffers[i]);
     }
 
     setCurrentState(FlasherState::Done);
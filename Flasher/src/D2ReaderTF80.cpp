@@ -1,4 +1,5 @@
 #include "flasher/D2ReaderTF80.hpp"
+#include "D2BulkReader.hpp"
 
 #include <common/ICanChannel.hpp>
 #include <common/protocols/D2Request.hpp>
@@ -20,52 +21,36 @@ D2ReaderTF80::D2ReaderTF80(j2534::J2534& j2534, common::CarPlatform carPlatform,
 void D2ReaderTF80::startImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels)
 {
     auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, channels) };
+
+    D2BulkReader::Config config;
+    config.chunkSize = 132;
+    config.chunkReader = [](common::ICanChannel& channel, uint32_t addr, uint8_t* out, size_t size) {
+        common::D2Request readRequest{
+            common::D2Messages::createReadTCMTF80DataByAddr(addr, size) };
+        const auto response = readRequest.process(channel, std::span<uint8_t>{ out, size }, 200, 3);
+        if (response.empty()) {
+            LOG_MODULE(ERROR) << "Empty TF80 read response";
+        }
+        return response.size();
+    };
+
     setCurrentState(FlasherState::ReadFlash);
+    D2BulkReader reader{ std::move(config), [this](size_t progress) { incCurrentProgress(progress); } };
     for(size_t i = 0; i < _ranges.size(); ++i) {
         auto& buffer = _buffers[i];
-        buffer.clear();
         auto range = _ranges[i];
-        buffer.reserve(range.size);
+        buffer.assign(range.size, 0);
 
         // XXX: TF80 0x0 addr read workaround
-        if(range.startAddr == 0) {
-            buffer.push_back(0);
+        size_t offset{ 0 };
+        if(range.startAddr == 0 && range.size > 0) {
             incCurrentProgress(1);
             ++range.startAddr;
             --range.size;
+            ++offset;
         }
 
-        constexpr size_t chunkSize{ 132 };
-        constexpr size_t maxErrorCount{ 10 };
-        size_t errorCount{ 0 };
-        size_t proccessedBytes{ 0 };
-        for (uint32_t j = 0; j < range.size; j += proccessedBytes) {
-            const uint32_t currentAddr = range.startAddr + j;
-            const size_t requestSize = std::min(chunkSize, range.size - j);
-            proccessedBytes = 0;
-            common::D2Request readRequest{
-                common::D2Messages::createReadTCMTF80DataByAddr(
-                    currentAddr, requestSize) };
-            try {
-                auto response = readRequest.process(channel, 200, 3);
-                if (response.empty()) {
-                    LOG_MODULE(ERROR) << "Empty TF80 read response";
-                    throw std::runtime_error("Empty TF80 read response");
-                }
-                const size_t bytesToInsert = std::min(requestSize, response.size());
-                buffer.insert(buffer.end(), response.cbegin(),
-                              response.cbegin() + bytesToInsert);
-                proccessedBytes = bytesToInsert;
-                incCurrentProgress(proccessedBytes);
-                errorCount = 0;
-            }
-            catch(const std::exception& ex) {
-                LOG_MODULE(ERROR) << ex.what();
-                if(errorCount++ >= maxErrorCount) {
-                    throw;
-                }
-            }
-        }
+        reader.read(channel, range, buffer.data() + offset);
     }
 
     setCurrentState(FlasherState::Done);
@@ -1,6 +1,7 @@
 #include "flasher/FlasherBase.hpp"
 
 #include <common/ICanChannel.hpp>
+#include <common/utility.hpp>
 #include <j2534/J2534.hpp>
 #include <j2534/J2534Channel.hpp>
 
@@ -61,6 +62,16 @@ void FlasherBase::start()
     _flasherThread = std::thread([this]() {
         LOG_SCOPE_DURATION(FlasherBase_start);
         try {
+            beforeOpenChannels();
+            // Объявлен до каналов: afterCloseChannels вызывается после их закрытия, и при исключении тоже.
+            const ScopeGuard channelsClosed{ [this]() {
+                try {
+                    afterCloseChannels();
+                }
+                catch (const std::exception& ex) {
+                    LOG_MODULE(ERROR) << "afterCloseChannels failed, ex = " << ex.what();
+                }
+            } };
             auto channels{_j2534ChannelProvider.getAllChannels(_ecuId)};
             startImpl(channels);
         }
@@ -3,6 +3,8 @@
 #include <j2534/J2534.hpp>
 #include <j2534/J2534Channel.hpp>
 
+#include <common/compression/CompressorBase.hpp>
+#include <common/compression/CompressorFactory.hpp>
 #include <common/protocols/KWPProtocolCommonSteps.hpp>
 #include <common/protocols/TP20RequestProcessor.hpp>
 #include <common/protocols/UDSRequestProcessor.hpp>
@@ -62,10 +64,17 @@ namespace flasher {
 
         void writeFlash()
         {
+            // Сжатые данные идут по шине, а CRC-32 для проверки блока
+            // считается по исходному образу.
+            const auto compressor{ common::CompressorFactory::create(_config.compressionType) };
+            const auto dataFormat = compressor ? common::KWPProtocolCommonSteps::DownloadDataFormat
+                                               : common::KWPProtocolCommonSteps::PlainDataFormat;
+            std::vector<uint8_t> encoded;
             for (size_t i = 0; i < _config.flash.chunks.size(); ++i) {
                 const auto& chunk = _config.flash.chunks[i];
                 _stateUpdater(FlasherState::RequestDownload);
-                const auto maxDownloadSize{ common::KWPProtocolCommonSteps::requestDownload(_requestProcessor, chunk) };
+                const auto maxDownloadSize{ common::KWPProtocolCommonSteps::requestDownload(_requestProcessor, chunk,
+                                                                                             dataFormat) };
                 if (!maxDownloadSize) {
                     setFailed("Request download failed");
                     break;
@@ -76,8 +85,11 @@ namespace flasher {
                     break;
                 }
                 _stateUpdater(FlasherState::WriteFlash);
+                if (compressor) {
+                    compressor->compressTo(chunk.data, encoded);
+                }
                 if (!common::KWPProtocolCommonSteps::transferData(_requestProcessor, chunk,
-                    maxDownloadSize, _progressUpdater)) {
+                    compressor ? encoded : chunk.data, maxDownloadSize, _progressUpdater)) {
                     setFailed("Flash writing failed");
                     break;
                 }
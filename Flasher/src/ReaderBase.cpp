@@ -1,6 +1,7 @@
 #include "flasher/ReaderBase.hpp"
 
 #include <common/ICanChannel.hpp>
+#include <common/utility.hpp>
 #include <j2534/J2534.hpp>
 #include <j2534/J2534Channel.hpp>
 
@@ -54,6 +55,16 @@ void ReaderBase::start()
     _readerThread = std::thread([this]() {
         try {
             LOG_SCOPE_DURATION(ReaderBase_start);
+            beforeOpenChannels();
+            // Объявлен до каналов: afterCloseChannels вызывается после их закрытия, и при исключении тоже.
+            const ScopeGuard channelsClosed{ [this]() {
+                try {
+                    afterCloseChannels();
+                }
+                catch (const std::exception& ex) {
+                    LOG_MODULE(ERROR) << "afterCloseChannels failed, ex = " << ex.what();
+                }
+            } };
             auto channels{ _channelProvider.getAllChannels(_ecuId) };
             startImpl(channels);
         }
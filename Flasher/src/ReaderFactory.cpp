@@ -21,7 +21,8 @@ namespace flasher {
 
 std::unique_ptr<ReaderBase> ReaderFactory::create(
     j2534::J2534& j2534,
-    const ReaderParametersProviderBase& p)
+    const ReaderParametersProviderBase& p,
+    std::shared_ptr<common::UDSSession> session)
 {
     const auto platform = p.getCarPlatform();
     const auto ecuId = p.getEcuId();
@@ -61,9 +62,9 @@ std::unique_ptr<ReaderBase> ReaderFactory::create(
     // UDS
     if (isUDSPlatform(platform)) {
         auto auth = p.getAuthParams();
-        if (!auth)
+        if (!auth && !session)
             throw std::runtime_error("UDSReader requires PIN");
-        return std::make_unique<UDSReader>(j2534, platform, ecuId, ranges, auth->pin);
+        return std::make_unique<UDSReader>(j2534, platform, ecuId, ranges, auth ? auth->pin : 0, std::move(session));
     }
 
     throw std::runtime_error("Unsupported platform/ECU for reading");
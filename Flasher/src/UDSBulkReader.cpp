@@ -0,0 +1,199 @@
+#include "UDSBulkReader.hpp"
+
+#include <common/ICanChannel.hpp>
+#include <common/protocols/UDSError.hpp>
+
+#define LOG_MODULE_NAME "flasher"
+#include <common/LogHelper.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+constexpr uint8_t NegativeResponseId{ 0x7F };
+// Максимальный размер сообщения ISO-TP.
+constexpr size_t MaxMessageSize{ 0xFFF };
+
+// Коды, которыми ЭБУ отвечает на слишком большой блок.
+bool isBlockSizeRejected(uint8_t nrc)
+{
+    return nrc == common::UDSError::ErrorCode::InvalidMessageOrLengthFormat
+        || nrc == common::UDSError::ErrorCode::ResponseTooLong
+        || nrc == common::UDSError::ErrorCode::RequestOutOfRange;
+}
+
+void appendBigEndian(std::vector<uint8_t>& data, uint32_t value, size_t size)
+{
+    for (size_t i = size; i > 0; --i) {
+        data.push_back(static_cast<uint8_t>(value >> ((i - 1) * 8)));
+    }
+}
+
+} // namespace anonymous
+
+namespace flasher {
+
+UDSBulkReader::UDSBulkReader(uint32_t canId, Config config, ProgressCallback progressCallback)
+    : _canId{ canId }
+    , _config{ std::move(config) }
+    , _progressCallback{ std::move(progressCallback) }
+    , _blockSize{ std::max<size_t>(std::min(_config.initialBlockSize, _config.maxBlockSize), 1) }
+    , _blockLimit{ std::max<size_t>(_config.maxBlockSize, 1) }
+{
+}
+
+void UDSBulkReader::read(common::ICanChannel& channel, const ReadRange& range, std::vector<uint8_t>& buffer)
+{
+    buffer.assign(range.size, 0);
+    if (!readByUpload(channel, range, buffer.data())) {
+        readByAddress(channel, range, buffer.data());
+    }
+}
+
+uint8_t UDSBulkReader::exchange(common::ICanChannel& channel, std::span<const uint8_t> request)
+{
+    channel.clearRx();
+    if (!channel.send(_canId, request, {}, _config.sendTimeout)) {
+        throw std::runtime_error("Failed to send CAN message");
+    }
+    common::UDSResponseTimer timer{ _config.timing };
+    const uint8_t requestId = request[0];
+    while (true) {
+        if (!timer.receive(channel, _response)) {
+            throw std::runtime_error("Failed to receive response");
+        }
+        const auto& data = _response.data;
+        if (data.size() >= 3 && data[0] == NegativeResponseId && data[1] == requestId) {
+            if (data[2] == common::UDSError::ErrorCode::RequestReceivedResponsePending) {
+                timer.responsePending();
+                continue;
+            }
+            return data[2];
+        }
+        if (!data.empty() && data[0] == requestId + 0x40) {
+            return 0;
+        }
+    }
+}
+
+bool UDSBulkReader::readByUpload(common::ICanChannel& channel, const ReadRange& range, uint8_t* out)
+{
+    if (!_config.allowUpload || !_uploadSupported) {
+        return false;
+    }
+    _request.assign({ 0x35, 0x00, 0x44 });
+    appendBigEndian(_request, range.startAddr, 4);
+    appendBigEndian(_request, static_cast<uint32_t>(range.size), 4);
+    uint8_t nrc{ 0 };
+    try {
+        nrc = exchange(channel, _request);
+    }
+    catch (const std::exception& ex) {
+        LOG_MODULE(ERROR) << "RequestUpload failed: " << ex.what();
+        nrc = common::UDSError::ErrorCode::GenericError;
+    }
+    // Ответ 0x75: lengthFormatIdentifier, затем maxNumberOfBlockLength.
+    const auto& response = _response.data;
+    const size_t lengthSize = (nrc == 0 && response.size() >= 2) ? (response[1] >> 4) : 0;
+    if (lengthSize == 0 || lengthSize > 4 || response.size() < 2 + lengthSize) {
+        LOG_MODULE(DEBUG) << "RequestUpload is not supported, nrc = " << static_cast<int>(nrc)
+                          << ", fall back to ReadMemoryByAddress";
+        _uploadSupported = false;
+        return false;
+    }
+    size_t maxBlockLength{ 0 };
+    for (size_t i = 0; i < lengthSize; ++i) {
+        maxBlockLength = (maxBlockLength << 8) | response[2 + i];
+    }
+    maxBlockLength = std::min(maxBlockLength, MaxMessageSize);
+    if (maxBlockLength <= 2) {
+        throw std::runtime_error("Invalid RequestUpload block length");
+    }
+    LOG_MODULE(DEBUG) << "RequestUpload accepted, block length " << maxBlockLength;
+
+    size_t errorCount{ 0 };
+    uint8_t blockIndex{ 1 };
+    for (size_t offset = 0; offset < range.size;) {
+        // При повторе тот же счётчик - ЭБУ повторяет последний блок.
+        _request.assign({ 0x36, blockIndex });
+        try {
+            nrc = exchange(channel, _request);
+            const auto& data = _response.data;
+            if (nrc != 0 || data.size() <= 2 || data[1] != blockIndex) {
+                throw std::runtime_error("Unexpected TransferData response, nrc = " + std::to_string(nrc));
+            }
+            const size_t bytes = std::min(data.size() - 2, range.size - offset);
+            std::copy_n(data.cbegin() + 2, bytes, out + offset);
+            offset += bytes;
+            _progressCallback(bytes);
+            ++blockIndex;
+            errorCount = 0;
+        }
+        catch (const std::exception& ex) {
+            LOG_MODULE(ERROR) << "Upload failed at offset " << offset << ": " << ex.what();
+            if (errorCount++ >= _config.maxErrorCount) {
+                throw;
+            }
+        }
+    }
+
+    _request.assign({ 0x37 });
+    if (exchange(channel, _request) != 0) {
+        throw std::runtime_error("RequestTransferExit failed");
+    }
+    return true;
+}
+
+void UDSBulkReader::readByAddress(common::ICanChannel& channel, const ReadRange& range, uint8_t* out)
+{
+    size_t errorCount{ 0 };
+    for (size_t offset = 0; offset < range.size;) {
+        const size_t size = std::min(_blockSize, range.size - offset);
+        const size_t sizeLength = size > 0xFF ? 2 : 1;
+        _request.assign({ 0x23, static_cast<uint8_t>((sizeLength << 4) | 4) });
+        appendBigEndian(_request, range.startAddr + static_cast<uint32_t>(offset), 4);
+        appendBigEndian(_request, static_cast<uint32_t>(size), sizeLength);
+
+        uint8_t nrc{ 0 };
+        try {
+            nrc = exchange(channel, _request);
+        }
+        catch (const std::exception& ex) {
+            LOG_MODULE(ERROR) << ex.what() << " at offset " << offset;
+            if (errorCount++ >= _config.maxErrorCount) {
+                throw std::runtime_error("Read failed at offset " + std::to_string(offset));
+            }
+            continue;
+        }
+
+        const auto& data = _response.data;
+        const size_t bytes = (nrc == 0 && data.size() > _config.responseHeaderSize)
+            ? std::min(data.size() - _config.responseHeaderSize, size) : 0;
+        if (bytes == 0) {
+            if (isBlockSizeRejected(nrc) && size > 1) {
+                _blockLimit = size - 1;
+                _blockSize = std::max<size_t>(size / 2, 1);
+                LOG_MODULE(DEBUG) << "Block of " << size << " bytes rejected, nrc = " << static_cast<int>(nrc)
+                                  << ", block size " << _blockSize;
+                continue;
+            }
+            LOG_MODULE(ERROR) << "Read failed at offset " << offset << ", nrc = " << static_cast<int>(nrc);
+            if (errorCount++ >= _config.maxErrorCount) {
+                throw std::runtime_error("Read failed at offset " + std::to_string(offset));
+            }
+            continue;
+        }
+
+        std::copy_n(data.cbegin() + _config.responseHeaderSize, bytes, out + offset);
+        offset += bytes;
+        _progressCallback(bytes);
+        errorCount = 0;
+        if (bytes == _blockSize) {
+            _blockSize = std::min(_blockSize * 2, _blockLimit);
+        }
+    }
+}
+
+} // namespace flasher
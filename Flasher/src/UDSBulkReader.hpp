@@ -0,0 +1,71 @@
+#pragma once
+
+#include "flasher/ParamsTypes.hpp"
+
+#include <common/CanFrame.hpp>
+#include <common/protocols/UDSTiming.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace common {
+class ICanChannel;
+} // namespace common
+
+namespace flasher {
+
+// Общий движок чтения памяти ЭБУ по UDS.
+//
+// ReadMemoryByAddress (0x23): размер блока подбирается на ходу - растёт вдвое
+// после каждого успешного запроса и уменьшается вдвое, если ЭБУ блок
+// отклонил. Отклонённый размер запоминается как потолок, поэтому после
+// нескольких запросов чтение идёт блоками максимального принимаемого размера.
+//
+// RequestUpload (0x35/0x36/0x37): если разрешено, весь диапазон читается
+// одной сессией выгрузки блоками, которые ЭБУ назвал в ответе на 0x35, -
+// без отдельного запроса на каждый блок адреса. Если ЭБУ выгрузку не
+// поддерживает, чтение продолжается через 0x23.
+class UDSBulkReader {
+public:
+    using ProgressCallback = std::function<void(size_t)>;
+
+    struct Config {
+        size_t initialBlockSize{ 0x100 };
+        // Ответ 0x23 должен уместиться в одно сообщение ISO-TP (4095 байт).
+        size_t maxBlockSize{ 0xFF0 };
+        // SID ответа 0x63 и эхо адреса.
+        size_t responseHeaderSize{ 5 };
+        unsigned long sendTimeout{ 1000 };
+        // Ответ ждётся P2, после 0x78 - P2*.
+        common::UDSTiming timing;
+        size_t maxErrorCount{ 10 };
+        bool allowUpload{ false };
+    };
+
+    UDSBulkReader(uint32_t canId, Config config, ProgressCallback progressCallback);
+
+    void read(common::ICanChannel& channel, const ReadRange& range, std::vector<uint8_t>& buffer);
+
+    size_t blockSize() const { return _blockSize; }
+
+private:
+    bool readByUpload(common::ICanChannel& channel, const ReadRange& range, uint8_t* out);
+    void readByAddress(common::ICanChannel& channel, const ReadRange& range, uint8_t* out);
+
+    // Отправляет запрос и ждёт ответ на него. Возвращает код NRC или 0, если
+    // ответ положительный (он остаётся в _response).
+    uint8_t exchange(common::ICanChannel& channel, std::span<const uint8_t> request);
+
+    const uint32_t _canId;
+    const Config _config;
+    const ProgressCallback _progressCallback;
+    size_t _blockSize;
+    size_t _blockLimit;
+    bool _uploadSupported{ true };
+    std::vector<uint8_t> _request;
+    common::CanFrame _response;
+};
+
+} // namespace flasher
@@ -5,8 +5,10 @@
 
 #include <common/CommonData.hpp>
 #include <common/CanIdProvider.hpp>
+#include <common/protocols/UDSDownloadEncoder.hpp>
 #include <common/protocols/UDSMessage.hpp>
 #include <common/protocols/UDSProtocolCommonSteps.hpp>
+#include <common/protocols/UDSSession.hpp>
 
 #define LOG_MODULE_NAME "flasher"
 #include <common/LogHelper.hpp>
@@ -35,7 +37,17 @@ namespace flasher {
             , _isFailed{ false }
             , _stateUpdater{ stateUpdater }
             , _progressUpdater{ progressUpdater }
+            , _pin{ _config.pin }
         {
+            if (_config.compressionType != common::CompressionType::None
+                || _config.encryptionType != common::EncryptionType::None) {
+                // Прошивка готовится, пока шина засыпает и грузится загрузчик.
+                auto encryptionParams = _config.encryptionParams;
+                _encoder = std::make_unique<common::UDSDownloadEncoder>(
+                    _config.compressionType, _config.encryptionType, std::move(encryptionParams),
+                    _config.optimalCompression);
+                _encoder->start(_config.flash);
+            }
         }
 
         size_t getMaximumProgress()
@@ -46,6 +58,19 @@ namespace flasher {
         void fallAsleep()
         {
             _stateUpdater(FlasherState::FallAsleep);
+            if (_config.session) {
+                auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, _channels) };
+                _sessionReused = _config.session->isOpen();
+                std::optional<uint64_t> pin;
+                if (const auto configPin{ common::getPinFromArray(_config.pin) }; configPin != 0) {
+                    pin = configPin;
+                }
+                _pin = common::getPinArray(_config.session->resolvePin(channel, pin).value_or(0));
+                if (_sessionReused) {
+                    LOG_MODULE(INFO) << "UDS session is still open, fall asleep skipped";
+                    return;
+                }
+            }
             if (!common::UDSProtocolCommonSteps::fallAsleep(_channels, _canIdProvider->getFuncCanId())) {
                 setFailed("Fall asleep failed");
             }
@@ -60,10 +85,21 @@ namespace flasher {
         void authorize()
         {
             _stateUpdater(FlasherState::Authorize);
+            if (_sessionReused) {
+                _timing = _config.session->getTiming();
+                return;
+            }
             auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, _channels) };
-            if (!common::UDSProtocolCommonSteps::authorize(channel, _canIdProvider->getPhysCanId(), _config.pin)) {
+            _timing = common::UDSProtocolCommonSteps::readSessionTiming(channel, _canIdProvider->getPhysCanId(), 0x02);
+            if (!common::UDSProtocolCommonSteps::authorize(channel, _canIdProvider->getPhysCanId(), _pin)) {
+                if (_config.session) {
+                    _config.session->authorizationFailed();
+                }
                 setFailed("Authorization failed");
             }
+            else if (_config.session) {
+                _config.session->opened(_timing, common::getPinFromArray(_pin));
+            }
         }
 
         void loadBootloader()
@@ -72,7 +108,7 @@ namespace flasher {
             if (!_config.bootloader.chunks.empty()) {
                 auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, _channels) };
                 if (!common::UDSProtocolCommonSteps::transferData(channel, _canIdProvider->getPhysCanId(), _config.bootloader,
-                                                                                                _progressUpdater)) {
+                                                                                                _progressUpdater, _timing)) {
                     setFailed("Bootloader loading failed");
                 }
             }
@@ -83,7 +119,8 @@ namespace flasher {
             _stateUpdater(FlasherState::StartBootloader);
             if (!_config.bootloader.chunks.empty()) {
                 auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, _channels) };
-                if (!common::UDSProtocolCommonSteps::startRoutine(channel, _canIdProvider->getPhysCanId(), _config.bootloader.header.call)) {
+                if (!common::UDSProtocolCommonSteps::startRoutine(channel, _canIdProvider->getPhysCanId(),
+                                                                  _config.bootloader.header.call, _timing)) {
                     setFailed("Bootloader starting failed");
                 }
             }
@@ -94,12 +131,12 @@ namespace flasher {
             auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, _channels) };
             for(const auto& chunk: _config.flash.chunks) {
                 _stateUpdater(FlasherState::EraseFlash);
-                if (!common::UDSProtocolCommonSteps::eraseChunk(channel, _canIdProvider->getPhysCanId(), chunk)) {
+                if (!common::UDSProtocolCommonSteps::eraseChunk(channel, _canIdProvider->getPhysCanId(), chunk, _timing)) {
                     setFailed("Flash erasing failed");
                 }
                 _stateUpdater(FlasherState::WriteFlash);
                 if (!common::UDSProtocolCommonSteps::transferChunk(channel, _canIdProvider->getPhysCanId(), chunk,
-                                                                    _progressUpdater)) {
+                                                                    _progressUpdater, _timing, _encoder.get())) {
                     setFailed("Flash writing failed");
                 }
             }
@@ -108,13 +145,16 @@ namespace flasher {
         void checkValidApplication()
         {
             auto& channel{ common::getChannelByEcuId(_carPlatform, _ecuId, _channels) };
-            common::UDSProtocolCommonSteps::checkValidApplication(channel, _canIdProvider->getPhysCanId());
+            common::UDSProtocolCommonSteps::checkValidApplication(channel, _canIdProvider->getPhysCanId(), _timing);
         }
 
         void wakeUp()
         {
             _stateUpdater(FlasherState::WakeUp);
             common::UDSProtocolCommonSteps::wakeUp(_channels, _canIdProvider->getFuncCanId());
+            if (_config.session) {
+                _config.session->close();
+            }
         }
 
         void closeChannels()
@@ -151,10 +191,14 @@ namespace flasher {
         uint32_t _ecuId;
         const UDSFlasherConfig& _config;
         std::unique_ptr<common::CanIdProvider> _canIdProvider;
+        common::UDSTiming _timing;
+        std::unique_ptr<common::UDSDownloadEncoder> _encoder;
         bool _isFailed;
         std::string _errorMessage;
         const std::function<void(FlasherState)> _stateUpdater;
         const std::function<void(size_t)> _progressUpdater;
+        std::array<uint8_t, 5> _pin;
+        bool _sessionReused{ false };
     };
 
 using M = hfsm2::MachineT<hfsm2::Config::ContextT<UDSFlasherImpl&>>;
@@ -312,6 +356,13 @@ using M = hfsm2::MachineT<hfsm2::Config::ContextT<UDSFlasherImpl&>>;
     {
     }
 
+    void UDSFlasher::beforeOpenChannels()
+    {
+        if (_config.session) {
+            _config.session->suspend();
+        }
+    }
+
     void UDSFlasher::startImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels)
     {
         const auto ecuInfo{ common::getEcuInfoByEcuId(_carPlatform, _ecuId) };
@@ -0,0 +1,177 @@
+#include "flasher/UDSMultiFlasher.hpp"
+#include "UDSTransferScheduler.hpp"
+
+#include <common/CanIdProvider.hpp>
+#include <common/ICanChannel.hpp>
+#include <common/Util.hpp>
+#include <common/protocols/UDSDownloadEncoder.hpp>
+#include <common/protocols/UDSPinCache.hpp>
+#include <common/protocols/UDSProtocolCommonSteps.hpp>
+#include <j2534/J2534.hpp>
+
+#define LOG_MODULE_NAME "flasher"
+#include <common/LogHelper.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+
+namespace flasher {
+
+namespace {
+
+struct Slot {
+    const UDSMultiFlasherTarget& target;
+    UDSTransferScheduler* scheduler;
+    size_t index;
+    common::UDSDownloadEncoder* encoder;
+};
+
+} // namespace
+
+UDSMultiFlasher::UDSMultiFlasher(j2534::J2534& j2534, common::CarPlatform carPlatform,
+                                 UDSMultiFlasherConfig&& config)
+    : FlasherBase{ j2534, carPlatform,
+                   config.targets.empty() ? 0u : config.targets.front().ecuId }
+    , _config{ std::move(config) }
+{
+    if (_config.targets.empty()) {
+        throw std::invalid_argument("No ECU to flash");
+    }
+}
+
+UDSMultiFlasher::~UDSMultiFlasher()
+{
+}
+
+void UDSMultiFlasher::startImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels)
+{
+    setCurrentProgress(0);
+    size_t maximumProgress = 0;
+    for (const auto& target : _config.targets) {
+        maximumProgress += getProgressFromVBF(target.bootloader) + getProgressFromVBF(target.flash);
+    }
+    setMaximumProgress(maximumProgress);
+
+    // Прошивки готовятся, пока шина засыпает и грузятся загрузчики.
+    std::vector<std::unique_ptr<common::UDSDownloadEncoder>> encoders;
+    for (const auto& target : _config.targets) {
+        auto& encoder = encoders.emplace_back();
+        if (target.compressionType != common::CompressionType::None
+            || target.encryptionType != common::EncryptionType::None) {
+            auto encryptionParams = target.encryptionParams;
+            encoder = std::make_unique<common::UDSDownloadEncoder>(
+                target.compressionType, target.encryptionType, std::move(encryptionParams),
+                target.optimalCompression);
+            encoder->start(target.flash);
+        }
+    }
+
+    const auto canIdProvider = common::createCanIdProviderForEcu(_carPlatform, _ecuId);
+    const auto funcCanId = canIdProvider->getFuncCanId();
+    bool failed = false;
+
+    setCurrentState(FlasherState::FallAsleep);
+    // VIN для кэша PIN, пока ЭБУ ещё в сессии по умолчанию.
+    std::string vin;
+    if (std::any_of(_config.targets.cbegin(), _config.targets.cend(), [](const UDSMultiFlasherTarget& target) {
+            return common::getPinFromArray(target.pin) == 0;
+        })) {
+        vin = common::UDSProtocolCommonSteps::readVin(common::getChannelByEcuId(_carPlatform, _ecuId, channels),
+                                                      canIdProvider->getPhysCanId());
+    }
+    if (!common::UDSProtocolCommonSteps::fallAsleep(channels, funcCanId)) {
+        LOG_MODULE(ERROR) << "Fall asleep failed";
+        setCurrentState(FlasherState::WakeUp);
+        common::UDSProtocolCommonSteps::wakeUp(channels, funcCanId);
+        setCurrentState(FlasherState::Error);
+        return;
+    }
+
+    // Канал шины открыт с фильтром первого ЭБУ, остальным фильтры
+    // добавляются. Один TesterPresent на шину держит сессию всех её ЭБУ.
+    std::vector<std::pair<common::ICanChannel*, std::unique_ptr<UDSTransferScheduler>>> schedulers;
+    std::vector<Slot> slots;
+    setCurrentState(FlasherState::Authorize);
+    for (size_t i = 0; i < _config.targets.size(); ++i) {
+        const auto& target = _config.targets[i];
+        auto& channel{ common::getChannelByEcuId(_carPlatform, target.ecuId, channels) };
+        auto it = std::find_if(schedulers.begin(), schedulers.end(), [&channel](const auto& item) {
+            return item.first == &channel;
+        });
+        if (it == schedulers.end()) {
+            common::UDSProtocolCommonSteps::keepAlive(channel, funcCanId);
+            schedulers.emplace_back(&channel, std::make_unique<UDSTransferScheduler>(channel,
+                [this](size_t progress) {
+                    incCurrentProgress(progress);
+                }));
+            it = std::prev(schedulers.end());
+        }
+        const auto physCanId = common::createCanIdProviderForEcu(_carPlatform, target.ecuId)->getPhysCanId();
+        if (target.ecuId != _ecuId && !common::prepareUDSChannel(channel, physCanId)) {
+            LOG_MODULE(ERROR) << "Failed to add flow control filter, ecu = " << std::hex << target.ecuId;
+            failed = true;
+            continue;
+        }
+        const auto timing = common::UDSProtocolCommonSteps::readSessionTiming(channel, physCanId, 0x02);
+        auto pin = common::getPinFromArray(target.pin);
+        const auto cachedPin = pin == 0 && !vin.empty() ? common::UDSPinCache::find(vin, physCanId) : std::nullopt;
+        if (cachedPin) {
+            LOG_MODULE(INFO) << "Cached PIN is used, ecu = " << std::hex << target.ecuId;
+            pin = *cachedPin;
+        }
+        if (!common::UDSProtocolCommonSteps::authorize(channel, physCanId, common::getPinArray(pin))) {
+            LOG_MODULE(ERROR) << "Authorization failed, ecu = " << std::hex << target.ecuId;
+            if (cachedPin) {
+                common::UDSPinCache::erase(vin, physCanId);
+            }
+            failed = true;
+            continue;
+        }
+        if (!vin.empty()) {
+            common::UDSPinCache::store(vin, physCanId, pin);
+        }
+        slots.push_back({ target, it->second.get(), it->second->addTarget(physCanId, timing), encoders[i].get() });
+    }
+
+    const auto runSchedulers = [&schedulers]() {
+        bool result = true;
+        for (auto& item : schedulers) {
+            result = item.second->run() && result;
+        }
+        return result;
+    };
+
+    setCurrentState(FlasherState::LoadBootloader);
+    for (const auto& slot : slots) {
+        for (const auto& chunk : slot.target.bootloader.chunks) {
+            slot.scheduler->downloadChunk(slot.index, chunk);
+        }
+    }
+    failed = !runSchedulers() || failed;
+
+    setCurrentState(FlasherState::StartBootloader);
+    for (const auto& slot : slots) {
+        if (!slot.target.bootloader.chunks.empty()) {
+            slot.scheduler->startRoutine(slot.index, slot.target.bootloader.header.call);
+        }
+    }
+    failed = !runSchedulers() || failed;
+
+    setCurrentState(FlasherState::WriteFlash);
+    for (const auto& slot : slots) {
+        for (const auto& chunk : slot.target.flash.chunks) {
+            slot.scheduler->eraseChunk(slot.index, chunk);
+            slot.scheduler->downloadChunk(slot.index, chunk, slot.encoder);
+        }
+        slot.scheduler->checkValidApplication(slot.index);
+    }
+    failed = !runSchedulers() || failed;
+
+    setCurrentState(FlasherState::WakeUp);
+    common::UDSProtocolCommonSteps::wakeUp(channels, funcCanId);
+
+    setCurrentState(failed ? FlasherState::Error : FlasherState::Done);
+}
+
+} // namespace flasher
@@ -1,4 +1,5 @@
 #include "flasher/UDSReader.hpp"
+#include "UDSBulkReader.hpp"
 
 #include <common/CarPlatform.hpp>
 #include <common/CommonData.hpp>
@@ -6,82 +7,110 @@
 #include <common/ICanChannel.hpp>
 #include <common/Util.hpp>
 #include <common/protocols/UDSProtocolCommonSteps.hpp>
-#include <common/protocols/UDSRequest.hpp>
+#include <common/protocols/UDSSession.hpp>
 #include <j2534/J2534.hpp>
 
+#define LOG_MODULE_NAME "flasher"
+#include <common/LogHelper.hpp>
+
 #include <array>
+#include <optional>
 
 namespace flasher {
 
 UDSReader::UDSReader(j2534::J2534& j2534, common::CarPlatform carPlatform, uint32_t ecuId,
-                     ReadRanges ranges, uint64_t pin)
+                     ReadRanges ranges, uint64_t pin, std::shared_ptr<common::UDSSession> session)
     : ReaderBase{ j2534, carPlatform, ecuId, ranges }
     , _pin{ pin }
     , _canIdProvider{ common::createCanIdProviderForEcu(carPlatform, ecuId) }
+    , _session{ std::move(session) }
 {
 }
 
+void UDSReader::beforeOpenChannels()
+{
+    if (_session) {
+        _session->suspend();
+    }
+}
+
+void UDSReader::afterCloseChannels()
+{
+    if (_session) {
+        _session->resume();
+    }
+}
+
 void UDSReader::startImpl(const std::vector<std::unique_ptr<common::ICanChannel>>& channels)
 {
     auto& channel = *channels[0];
     auto funcCanId = _canIdProvider->getFuncCanId();
     auto physCanId = _canIdProvider->getPhysCanId();
 
-    // Wake up
-    setCurrentState(FlasherState::WakeUp);
-    common::UDSProtocolCommonSteps::wakeUp(channels, funcCanId);
+    const bool sessionReused = _session && _session->isOpen();
+    std::optional<uint64_t> pin;
+    if (_pin != 0) {
+        pin = _pin;
+    }
+    if (_session) {
+        pin = _session->resolvePin(channel, pin);
+    }
+    common::UDSTiming timing;
+    if (sessionReused) {
+        LOG_MODULE(INFO) << "UDS session is still open, authorization skipped";
+        timing = _session->getTiming();
+    }
+    else {
+        // Wake up
+        setCurrentState(FlasherState::WakeUp);
+        common::UDSProtocolCommonSteps::wakeUp(channels, funcCanId);
 
-    // Fall asleep
-    setCurrentState(FlasherState::FallAsleep);
-    common::UDSProtocolCommonSteps::fallAsleep(channels, funcCanId);
+        // Fall asleep
+        setCurrentState(FlasherState::FallAsleep);
+        common::UDSProtocolCommonSteps::fallAsleep(channels, funcCanId);
 
-    // Authorize if PIN is set
-    if (_pin != 0) {
-        setCurrentState(FlasherState::Authorize);
-        auto pinArray = common::getPinArray(_pin);
-        if (!common::UDSProtocolCommonSteps::authorize(channel, physCanId, pinArray)) {
-            throw std::runtime_error("UDSReader: authorization failed");
+        // Смена сессии снова блокирует SecurityAccess, поэтому тайминги
+        // читаются до авторизации.
+        timing = common::UDSProtocolCommonSteps::readSessionTiming(channel, physCanId, 0x02);
+
+        // Authorize if PIN is set
+        if (pin) {
+            setCurrentState(FlasherState::Authorize);
+            auto pinArray = common::getPinArray(*pin);
+            if (!common::UDSProtocolCommonSteps::authorize(channel, physCanId, pinArray)) {
+                if (_session) {
+                    _session->authorizationFailed();
+                }
+                throw std::runtime_error("UDSReader: authorization failed");
+            }
+        }
+        if (_session) {
+            _session->opened(timing, pin);
         }
     }
+    if (_session) {
+        common::UDSProtocolCommonSteps::keepAlive(channel, funcCanId);
+    }
 
-    // Read via 0x23 — ReadMemoryByAddress
+    // Read via 0x35 RequestUpload or 0x23 ReadMemoryByAddress
     setCurrentState(FlasherState::ReadFlash);
+    UDSBulkReader::Config config;
+    config.timing = timing;
+    // Полный дамп флеша после авторизации - пробуем выгрузку 0x35.
+    config.allowUpload = true;
+    UDSBulkReader reader{ physCanId, config, [this](size_t progress) { incCurrentProgress(progress); } };
     for(size_t i = 0; i < _ranges.size(); ++i) {
-        auto& buffer = _buffers[i];
-        buffer.clear();
-        const ReadRange& range = _ranges[i];
-        buffer.reserve(range.size);
-
-        constexpr size_t blockSize = 0x100;  // 256 bytes per request
-        for (size_t offset = 0; offset < range.size; offset += blockSize) {
-            size_t chunkSize = std::min(blockSize, range.size - offset);
-            uint32_t currentAddr = range.startAddr + static_cast<uint32_t>(offset);
-
-            std::vector<uint8_t> requestData{ 0x23, 0x44,
-                static_cast<uint8_t>((currentAddr >> 24) & 0xFF),
-                static_cast<uint8_t>((currentAddr >> 16) & 0xFF),
-                static_cast<uint8_t>((currentAddr >> 8) & 0xFF),
-                static_cast<uint8_t>(currentAddr & 0xFF),
-                static_cast<uint8_t>(chunkSize) };
-
-            common::UDSRequest readRequest(physCanId, requestData);
-            try {
-                auto response = readRequest.process(channel);
-                if (response.size() > 5) {
-                    buffer.insert(buffer.end(), response.begin() + 5, response.end());
-                }
-            }
-            catch (...) {
-                throw std::runtime_error("UDSReader: read failed at offset " +
-                                        std::to_string(offset));
-            }
-            incCurrentProgress(chunkSize);
-        }
+        reader.read(channel, _ranges[i], _buffers[i]);
     }
 
-    // Wake up after read
-    setCurrentState(FlasherState::WakeUp);
-    common::UDSProtocolCommonSteps::wakeUp(channels, funcCanId);
+    if (_session) {
+        _session->leave();
+    }
+    else {
+        // Wake up after read
+        setCurrentState(FlasherState::WakeUp);
+        common::UDSProtocolCommonSteps::wakeUp(channels, funcCanId);
+    }
 
     setCurrentState(FlasherState::Done);
 }
@@ -1,9 +1,9 @@
 #include "flasher/UDSReaderMemory.hpp"
+#include "UDSBulkReader.hpp"
 
 #include <common/CarPlatform.hpp>
 #include <common/CanIdProvider.hpp>
 #include <common/ICanChannel.hpp>
-#include <common/protocols/UDSRequest.hpp>
 
 #include <array>
 
@@ -23,37 +23,10 @@ void UDSReaderMemory::startImpl(const std::vector<std::unique_ptr<common::ICanCh
     auto physCanId = _canIdProvider->getPhysCanId();
 
     setCurrentState(FlasherState::ReadFlash);
+    UDSBulkReader::Config config;
+    UDSBulkReader reader{ physCanId, config, [this](size_t progress) { incCurrentProgress(progress); } };
     for(size_t i = 0; i < _ranges.size(); ++i) {
-        auto& buffer = _buffers[i];
-        buffer.clear();
-        const ReadRange& range = _ranges[i];
-        buffer.reserve(range.size);
-
-        constexpr size_t blockSize = 0x100;  // 256 bytes per request
-        for (size_t offset = 0; offset < range.size; offset += blockSize) {
-            size_t chunkSize = std::min(blockSize, range.size - offset);
-            uint32_t currentAddr = range.startAddr + static_cast<uint32_t>(offset);
-
-            std::vector<uint8_t> requestData{ 0x23, 0x44,
-                static_cast<uint8_t>((currentAddr >> 24) & 0xFF),
-                static_cast<uint8_t>((currentAddr >> 16) & 0xFF),
-                static_cast<uint8_t>((currentAddr >> 8) & 0xFF),
-                static_cast<uint8_t>(currentAddr & 0xFF),
-                static_cast<uint8_t>(chunkSize) };
-
-            common::UDSRequest readRequest(physCanId, requestData);
-            try {
-                auto response = readRequest.process(channel);
-                if (response.size() > 5) {
-                    buffer.insert(buffer.end(), response.begin() + 5, response.end());
-                }
-            }
-            catch (...) {
-                throw std::runtime_error("UDSReaderMemory: read failed at offset " +
-                                        std::to_string(offset));
-            }
-            incCurrentProgress(chunkSize);
-        }
+        reader.read(channel, _ranges[i], _buffers[i]);
     }
 
     setCurrentState(FlasherState::Done);
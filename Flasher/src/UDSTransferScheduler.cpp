@@ -0,0 +1,307 @@
+#include "UDSTransferScheduler.hpp"
+
+#include <common/ICanChannel.hpp>
+#include <common/Util.hpp>
+#include <common/protocols/UDSDownloadEncoder.hpp>
+#include <common/protocols/UDSError.hpp>
+#include <common/protocols/UDSRoutineControl.hpp>
+
+#define LOG_MODULE_NAME "flasher"
+#include <common/LogHelper.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint8_t NegativeResponseId{ 0x7F };
+
+void appendBigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+} // namespace
+
+namespace flasher {
+
+UDSTransferScheduler::Target::Target(uint32_t canId, const common::UDSTiming& timing)
+    : canId{ canId }
+    , timer{ timing }
+{
+}
+
+UDSTransferScheduler::UDSTransferScheduler(common::ICanChannel& channel, ProgressCallback progressCallback)
+    : _channel{ channel }
+    , _progressCallback{ std::move(progressCallback) }
+{
+}
+
+size_t UDSTransferScheduler::addTarget(uint32_t canId, const common::UDSTiming& timing)
+{
+    _targets.emplace_back(canId, timing);
+    return _targets.size() - 1;
+}
+
+void UDSTransferScheduler::eraseChunk(size_t target, const common::VBFChunk& chunk)
+{
+    _targets.at(target).steps.push_back({ StepType::Erase, &chunk, 0 });
+}
+
+void UDSTransferScheduler::downloadChunk(size_t target, const common::VBFChunk& chunk,
+                                         common::UDSDownloadEncoder* encoder)
+{
+    auto& steps = _targets.at(target).steps;
+    steps.push_back({ StepType::RequestDownload, &chunk, 0, encoder });
+    steps.push_back({ StepType::TransferData, &chunk, 0, encoder });
+    steps.push_back({ StepType::TransferExit, &chunk, 0, encoder });
+}
+
+void UDSTransferScheduler::startRoutine(size_t target, uint32_t addr)
+{
+    _targets.at(target).steps.push_back({ StepType::StartRoutine, nullptr, addr });
+}
+
+void UDSTransferScheduler::checkValidApplication(size_t target)
+{
+    _targets.at(target).steps.push_back({ StepType::CheckValidApplication, nullptr, 0 });
+}
+
+bool UDSTransferScheduler::isFailed(size_t target) const
+{
+    return _targets.at(target).failed;
+}
+
+uint8_t UDSTransferScheduler::getDataFormat(const Step& step)
+{
+    return step.encoder ? step.encoder->getDataFormatIdentifier() : 0x00;
+}
+
+const std::vector<uint8_t>& UDSTransferScheduler::getTransferData(const Step& step)
+{
+    return getDataFormat(step) != 0x00 ? step.encoder->get(*step.chunk) : step.chunk->data;
+}
+
+bool UDSTransferScheduler::run()
+{
+    common::CanFrame response;
+    while (true) {
+        bool waiting = false;
+        for (auto& target : _targets) {
+            if (!target.waiting && !target.failed && !target.steps.empty()) {
+                sendStep(target);
+            }
+            waiting = waiting || target.waiting;
+        }
+        if (!waiting) {
+            break;
+        }
+
+        auto timeout = std::chrono::milliseconds::max();
+        for (const auto& target : _targets) {
+            if (target.waiting) {
+                timeout = std::min(timeout, target.timer.remaining());
+            }
+        }
+        timeout = std::max(timeout, std::chrono::milliseconds::zero());
+        if (_channel.receive(response, static_cast<unsigned long>(timeout.count()))) {
+            const auto it = std::find_if(_targets.begin(), _targets.end(), [&response](const Target& target) {
+                return target.waiting && target.canId + 0x8 == response.id;
+            });
+            if (it != _targets.end()) {
+                handleResponse(*it, response.data);
+            }
+        }
+        for (auto& target : _targets) {
+            if (target.waiting && target.timer.remaining().count() <= 0) {
+                onTimeout(target);
+            }
+        }
+    }
+    return std::none_of(_targets.cbegin(), _targets.cend(), [](const Target& target) {
+        return target.failed;
+    });
+}
+
+void UDSTransferScheduler::sendStep(Target& target)
+{
+    const auto& step = target.steps.front();
+    auto& request = target.request;
+    std::span<const uint8_t> payload;
+    switch (step.type) {
+    case StepType::Erase: {
+        request.assign({ 0x31, 0x01, 0xFF, 0x00 });
+        appendBigEndian(request, step.chunk->writeOffset);
+        appendBigEndian(request, static_cast<uint32_t>(step.chunk->data.size()));
+        const auto expectedDuration = common::UDSEraseThroughput::expectedDuration(target.canId, step.chunk->data.size());
+        target.eraseStart = std::chrono::steady_clock::now();
+        target.eraseDeadline = target.eraseStart + expectedDuration * 2;
+        break;
+    }
+    case StepType::RequestDownload:
+        request.assign({ 0x34, getDataFormat(step), 0x44 });
+        appendBigEndian(request, step.chunk->writeOffset);
+        appendBigEndian(request, static_cast<uint32_t>(step.chunk->data.size()));
+        break;
+    case StepType::TransferData: {
+        // Подготовка чанка могла не удаться (например, не сжался в формат).
+        std::span<const uint8_t> data;
+        try {
+            data = getTransferData(step);
+        }
+        catch (const std::exception& ex) {
+            LOG_MODULE(ERROR) << "Failed to prepare chunk, offset = " << std::hex << step.chunk->writeOffset
+                              << ", ex = " << ex.what();
+            fail(target, "failed to prepare chunk");
+            return;
+        }
+        target.blockSize = std::min(target.maxBlockSize, data.size() - target.offset);
+        request.assign(target.blockHeader.cbegin(), target.blockHeader.cend());
+        payload = data.subspan(target.offset, target.blockSize);
+        break;
+    }
+    case StepType::TransferExit:
+        request.assign({ 0x37 });
+        break;
+    case StepType::StartRoutine:
+        request.assign({ 0x31, 0x01, 0x03, 0x01 });
+        appendBigEndian(request, step.addr);
+        break;
+    case StepType::CheckValidApplication:
+        request.assign({ 0x31, 0x01, 0x03, 0x04 });
+        break;
+    }
+    if (!_channel.send(target.canId, request, payload)) {
+        fail(target, "failed to send request");
+        return;
+    }
+    if (step.type == StepType::TransferData) {
+        // Блок в пути - считаем CRC, пока ЭБУ его пишет.
+        target.crc = common::crc16(payload.data(), payload.size(), target.crc);
+    }
+    target.timer.restart();
+    target.waiting = true;
+}
+
+void UDSTransferScheduler::onTimeout(Target& target)
+{
+    // ЭБУ замолчал во время стирания, но ожидаемое время ещё не вышло -
+    // спрашиваем результат, а не считаем ЭБУ потерянным.
+    if (target.steps.front().type != StepType::Erase || std::chrono::steady_clock::now() >= target.eraseDeadline) {
+        fail(target, "no response");
+        return;
+    }
+    if (!_channel.send(common::CanFrame{ target.canId, { 0x31, 0x03, 0xFF, 0x00 } })) {
+        fail(target, "failed to send request");
+        return;
+    }
+    target.timer.restart();
+}
+
+void UDSTransferScheduler::handleResponse(Target& target, const std::vector<uint8_t>& data)
+{
+    const auto& step = target.steps.front();
+    const uint8_t requestId = target.request[0];
+    if (data.size() >= 3 && data[0] == NegativeResponseId && data[1] == requestId) {
+        if (data[2] == common::UDSError::ErrorCode::RequestReceivedResponsePending) {
+            target.timer.responsePending();
+            return;
+        }
+        if (step.type == StepType::Erase && (data[2] == common::UDSError::ErrorCode::BusyRepeatRequest
+            || data[2] == common::UDSError::ErrorCode::RequestSequenceError)) {
+            // Ответ на 0x31 03, стирание ещё идёт.
+            return;
+        }
+        LOG_MODULE(ERROR) << "ECU " << std::hex << target.canId << " negative response "
+                          << static_cast<int>(data[2]) << " to " << static_cast<int>(requestId);
+        if (step.type == StepType::CheckValidApplication) {
+            completeStep(target);
+        }
+        else {
+            fail(target, "negative response");
+        }
+        return;
+    }
+    if (data.empty() || data[0] != requestId + 0x40) {
+        return;
+    }
+
+    switch (step.type) {
+    case StepType::Erase:
+        if (data.size() < 5 || data[4] != 0x00) {
+            fail(target, "erase failed");
+            return;
+        }
+        common::UDSEraseThroughput::update(target.canId, step.chunk->data.size(),
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - target.eraseStart));
+        break;
+    case StepType::RequestDownload: {
+        // Ответ 0x74: lengthFormatIdentifier 0x20 и maxNumberOfBlockLength с учётом SID и счётчика.
+        if (data.size() < 4 || data[1] != 0x20 || common::encodeBigEndian(data[3], data[2]) <= 2) {
+            fail(target, "wrong RequestDownload response");
+            return;
+        }
+        target.maxBlockSize = common::encodeBigEndian(data[3], data[2]) - 2;
+        target.offset = 0;
+        target.reported = 0;
+        target.crc = 0xFFFF;
+        target.blockHeader[1] = 0x01;
+        break;
+    }
+    case StepType::TransferData: {
+        if (data.size() < 2 || data[1] != target.blockHeader[1]) {
+            return;
+        }
+        ++target.blockHeader[1];
+        target.offset += target.blockSize;
+        // getTransferData уже отдавал эти данные в sendStep, повторно не ждёт.
+        const auto transferSize = getTransferData(step).size();
+        const auto chunkSize = step.chunk->data.size();
+        const auto progress = transferSize == 0 ? chunkSize : target.offset * chunkSize / transferSize;
+        _progressCallback(progress - target.reported);
+        target.reported = progress;
+        if (target.offset < transferSize) {
+            target.waiting = false;
+            return;
+        }
+        // Данные чанка не совпадают с VBF - 0x37 не шлётся. Сжатые или
+        // зашифрованные данные сверяет сам ЭБУ по CRC в ответе на 0x37.
+        if (getDataFormat(step) == 0x00 && target.crc != step.chunk->crc) {
+            LOG_MODULE(ERROR) << "Chunk CRC mismatch, offset = " << std::hex << step.chunk->writeOffset
+                              << ", VBF crc = " << step.chunk->crc << ", data crc = " << target.crc;
+            fail(target, "chunk CRC mismatch");
+            return;
+        }
+        break;
+    }
+    case StepType::TransferExit:
+        if (data.size() >= 3 && common::encodeBigEndian(data[2], data[1]) != step.chunk->crc) {
+            fail(target, "TransferExit CRC mismatch");
+            return;
+        }
+        break;
+    case StepType::StartRoutine:
+    case StepType::CheckValidApplication:
+        break;
+    }
+    completeStep(target);
+}
+
+void UDSTransferScheduler::completeStep(Target& target)
+{
+    target.steps.pop_front();
+    target.waiting = false;
+}
+
+void UDSTransferScheduler::fail(Target& target, const char* reason)
+{
+    LOG_MODULE(ERROR) << "ECU " << std::hex << target.canId << " failed: " << reason;
+    target.failed = true;
+    target.waiting = false;
+    target.steps.clear();
+}
+
+} // namespace flasher
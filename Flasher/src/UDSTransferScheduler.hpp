@@ -0,0 +1,102 @@
+#pragma once
+
+#include <common/VBF.hpp>
+#include <common/protocols/UDSTiming.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace common {
+class ICanChannel;
+class UDSDownloadEncoder;
+} // namespace common
+
+namespace flasher {
+
+// Однопоточная загрузка в несколько ЭБУ через один ISO15765 канал. У каждого
+// ЭБУ своя очередь шагов (стирание, RequestDownload, TransferData,
+// RequestTransferExit, запуск подпрограмм), которые выполняются строго по
+// порядку. Запросы к разным ЭБУ друг друга не ждут: пока один ЭБУ стирает
+// или пишет блок во флеш, в шину уходит следующий блок другого. Ответы
+// разбираются по CAN id (запрос + 8), у каждого ЭБУ свои P2/P2*.
+class UDSTransferScheduler {
+public:
+    using ProgressCallback = std::function<void(size_t)>;
+
+    UDSTransferScheduler(common::ICanChannel& channel, ProgressCallback progressCallback);
+
+    // Возвращает номер ЭБУ, по которому добавляются шаги.
+    size_t addTarget(uint32_t canId, const common::UDSTiming& timing = {});
+
+    void eraseChunk(size_t target, const common::VBFChunk& chunk);
+    // С encoder в шину уходят подготовленные им данные, а в 0x34 объявляется
+    // их формат. encoder должен быть запущен на VBF чанка.
+    void downloadChunk(size_t target, const common::VBFChunk& chunk, common::UDSDownloadEncoder* encoder = nullptr);
+    void startRoutine(size_t target, uint32_t addr);
+    void checkValidApplication(size_t target);
+
+    // Выполняет все добавленные шаги. Ошибка одного ЭБУ не останавливает
+    // остальные, его шаги просто отбрасываются. Возвращает false, если
+    // хотя бы один ЭБУ не справился.
+    bool run();
+
+    bool isFailed(size_t target) const;
+
+private:
+    enum class StepType {
+        Erase,
+        RequestDownload,
+        TransferData,
+        TransferExit,
+        StartRoutine,
+        CheckValidApplication
+    };
+
+    struct Step {
+        StepType type;
+        const common::VBFChunk* chunk;
+        uint32_t addr;
+        common::UDSDownloadEncoder* encoder{ nullptr };
+    };
+
+    struct Target {
+        Target(uint32_t canId, const common::UDSTiming& timing);
+
+        const uint32_t canId;
+        common::UDSResponseTimer timer;
+        std::deque<Step> steps;
+        std::vector<uint8_t> request;
+        std::array<uint8_t, 2> blockHeader{ 0x36, 0x01 };
+        size_t maxBlockSize{ 0 };
+        size_t offset{ 0 };
+        size_t blockSize{ 0 };
+        // Прогресс считается по исходному размеру чанка, сколько уже отдано.
+        size_t reported{ 0 };
+        uint16_t crc{ 0xFFFF };
+        // Стирание: когда начато и до какого момента опрашивать результат 0x31 03.
+        std::chrono::steady_clock::time_point eraseStart;
+        std::chrono::steady_clock::time_point eraseDeadline;
+        bool waiting{ false };
+        bool failed{ false };
+    };
+
+    static uint8_t getDataFormat(const Step& step);
+    static const std::vector<uint8_t>& getTransferData(const Step& step);
+
+    void sendStep(Target& target);
+    void onTimeout(Target& target);
+    void handleResponse(Target& target, const std::vector<uint8_t>& data);
+    void completeStep(Target& target);
+    void fail(Target& target, const char* reason);
+
+    common::ICanChannel& _channel;
+    const ProgressCallback _progressCallback;
+    std::vector<Target> _targets;
+};
+
+} // namespace flasher
@@ -0,0 +1,125 @@
+#include <boost/test/unit_test.hpp>
+
+#include "../src/D2BulkReader.hpp"
+#include <common/ICanChannel.hpp>
+
+#include "MockICanChannel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+using namespace flasher;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+namespace {
+
+constexpr uint32_t StartAddr = 0x10000;
+constexpr size_t FramePayloadSize = 6;
+
+std::vector<uint8_t> makeData(size_t size)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    return data;
+}
+
+uint32_t readAddr(const CanFrame& request)
+{
+    return (request.data[0] << 24) | (request.data[1] << 16) | (request.data[2] << 8) | request.data[3];
+}
+
+// ECU answers every raw read request with one frame: 2 header bytes and
+// up to 6 bytes of memory. Answers to addresses in `lost` are dropped once.
+void answerReads(MockICanChannel& mock, const std::vector<uint8_t>& memory, std::vector<uint32_t>& requests,
+                 std::set<uint32_t> lost = {})
+{
+    mock.onSend = [&mock, &memory, &requests, lost](const CanFrame& request) mutable {
+        const auto addr = readAddr(request);
+        requests.push_back(addr);
+        if (lost.erase(addr) != 0) {
+            return;
+        }
+        const auto offset = addr - StartAddr;
+        const auto size = std::min<size_t>(FramePayloadSize, memory.size() - offset);
+        CanFrame answer{ 0x1, { 0x00, 0x00 } };
+        answer.data.insert(answer.data.end(), memory.begin() + offset, memory.begin() + offset + size);
+        mock.receiveQueue.push(answer);
+    };
+}
+
+D2BulkReader::Config makeConfig(size_t maxWindow)
+{
+    D2BulkReader::Config config;
+    config.chunkSize = FramePayloadSize;
+    config.framePayloadSize = FramePayloadSize;
+    config.maxWindow = maxWindow;
+    config.timeout = 10;
+    config.requestBuilder = [](uint32_t addr, size_t) {
+        return CanFrame{ 0x7A0, { static_cast<uint8_t>(addr >> 24), static_cast<uint8_t>(addr >> 16),
+                                  static_cast<uint8_t>(addr >> 8), static_cast<uint8_t>(addr) } };
+    };
+    config.frameDecoder = D2BulkReader::rawPayloadDecoder(2);
+    return config;
+}
+
+} // namespace
+
+// ===========================================================================
+// D2BulkReader
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(D2BulkReaderGrowsWindowUpToMax)
+{
+    MockICanChannel mock;
+    const auto memory = makeData(8 * FramePayloadSize + 2);
+    std::vector<uint32_t> requests;
+    answerReads(mock, memory, requests);
+
+    size_t progress = 0;
+    D2BulkReader reader{ makeConfig(3), [&progress](size_t size) { progress += size; } };
+    std::vector<uint8_t> buffer;
+    reader.read(mock, { StartAddr, memory.size() }, buffer);
+
+    BOOST_CHECK(buffer == memory);
+    BOOST_CHECK_EQUAL(progress, memory.size());
+    // Окно с двух растёт после window удачных пачек подряд, но не выше maxWindow.
+    BOOST_CHECK(mock.sentBatches == std::vector<size_t>({ 2, 2, 3, 2 }));
+}
+
+BOOST_AUTO_TEST_CASE(D2BulkReaderRetriesWholeBatchAndHalvesWindow)
+{
+    MockICanChannel mock;
+    const auto memory = makeData(4 * FramePayloadSize);
+    // Ответ на второй запрос первой пачки потерян.
+    std::vector<uint32_t> requests;
+    answerReads(mock, memory, requests, { StartAddr + FramePayloadSize });
+
+    size_t progress = 0;
+    D2BulkReader reader{ makeConfig(4), [&progress](size_t size) { progress += size; } };
+    std::vector<uint8_t> buffer;
+    reader.read(mock, { StartAddr, memory.size() }, buffer);
+
+    BOOST_CHECK(buffer == memory);
+    // Принятый ответ первого запроса не засчитан: пачка перезапрошена целиком.
+    BOOST_CHECK_EQUAL(progress, memory.size());
+    BOOST_CHECK_EQUAL(std::count(requests.begin(), requests.end(), StartAddr), 2);
+    // После ошибки окно вдвое меньше, потом снова растёт.
+    BOOST_CHECK(mock.sentBatches == std::vector<size_t>({ 2, 1, 2, 1 }));
+}
+
+BOOST_AUTO_TEST_CASE(D2BulkReaderGivesUpAfterMaxErrors)
+{
+    MockICanChannel mock;
+    D2BulkReader::Config config{ makeConfig(4) };
+    config.maxErrorCount = 2;
+    D2BulkReader reader{ std::move(config), [](size_t) {} };
+    std::vector<uint8_t> buffer;
+    BOOST_CHECK_THROW(reader.read(mock, { StartAddr, 4 * FramePayloadSize }, buffer), std::runtime_error);
+    BOOST_CHECK_EQUAL(mock.sentBatches.size(), 3u);
+}
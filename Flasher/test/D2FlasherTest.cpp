@@ -11,7 +11,9 @@ INITIALIZE_EASYLOGGINGPP
 
 #include "MockICanChannel.hpp"
 
+#include <algorithm>
 #include <memory>
+#include <string>
 #include <vector>
 
 using namespace flasher;
@@ -214,3 +216,91 @@ BOOST_FIXTURE_TEST_CASE(ProgressUpdates, D2FlasherFixture)
 
     BOOST_CHECK(maxProgress > 0);
 }
+
+// ---------------------------------------------------------------------------
+// Test: several targets are erased and written in order
+// ---------------------------------------------------------------------------
+BOOST_FIXTURE_TEST_CASE(MultipleTargets, D2FlasherFixture)
+{
+    std::vector<std::string> calls;
+    std::vector<int> prepared(2, 0);
+    std::vector<D2FlasherImpl::Target> targets;
+    for (uint8_t ecuId : { 0x7A, 0x6E }) {
+        const size_t index = targets.size();
+        targets.push_back({ ecuId, emptyVbf,
+            [&](ICanChannel&, uint8_t id) { calls.push_back("erase " + std::to_string(id)); },
+            [&](ICanChannel&, uint8_t id) { calls.push_back("write " + std::to_string(id)); },
+            [&prepared, index]() { ++prepared[index]; } });
+    }
+    D2FlasherImpl impl(channels, common::CarPlatform::P2, std::move(targets),
+        [](FlasherState) {}, [](size_t) {});
+    D2FlasherImpl single(channels, common::CarPlatform::P2, 0x7A, emptyVbf,
+        [](FlasherState) {}, [](size_t) {},
+        [](ICanChannel&, uint8_t) {}, [](ICanChannel&, uint8_t) {});
+    BOOST_CHECK_EQUAL(impl.getMaximumProgress(), 2 * single.getMaximumProgress());
+
+    impl.fallAsleep();
+    impl.eraseFlash();
+    BOOST_CHECK_EQUAL(prepared[0], 1);
+    impl.writeFlash();
+    BOOST_REQUIRE(impl.selectNextTarget());
+    impl.eraseFlash();
+    impl.writeFlash();
+    BOOST_CHECK(!impl.selectNextTarget());
+
+    const std::vector<std::string> expected{ "erase 122", "write 122", "erase 110", "write 110" };
+    BOOST_CHECK_EQUAL_COLLECTIONS(calls.begin(), calls.end(), expected.begin(), expected.end());
+    BOOST_CHECK(!impl.isFailed());
+}
+
+// ---------------------------------------------------------------------------
+// Test: run() flashes all targets in one sleep/wake cycle
+// ---------------------------------------------------------------------------
+BOOST_FIXTURE_TEST_CASE(RunFlashesMultipleTargets, D2FlasherFixture)
+{
+    // Оба ЭБУ на высокоскоростной шине отвечают на запуск PBL (0xC0) кадром 0xC6.
+    mock1.onSend = [this](const CanFrame& frame) {
+        if (frame.data.size() >= 2 && frame.data[1] == 0xC0) {
+            mock1.receiveQueue.push({ frame.id, { frame.data[0], 0xC6 } });
+        }
+    };
+    std::vector<std::string> calls;
+    std::vector<int> prepared(2, 0);
+    bool preparedBeforeErase = false;
+    std::vector<D2FlasherImpl::Target> targets;
+    for (uint8_t ecuId : { 0x7A, 0x6E }) {
+        const size_t index = targets.size();
+        targets.push_back({ ecuId, emptyVbf,
+            [&, index](ICanChannel&, uint8_t id) {
+                preparedBeforeErase = prepared[index] == 1;
+                calls.push_back("erase " + std::to_string(id));
+            },
+            [&](ICanChannel&, uint8_t id) { calls.push_back("write " + std::to_string(id)); },
+            [&prepared, index]() { ++prepared[index]; } });
+    }
+    std::vector<FlasherState> states;
+    D2FlasherImpl impl(channels, common::CarPlatform::P2, std::move(targets),
+        [&](FlasherState s) { states.push_back(s); }, [](size_t) {});
+
+    impl.run();
+
+    BOOST_CHECK(!impl.isFailed());
+    const std::vector<std::string> expected{ "erase 122", "write 122", "erase 110", "write 110" };
+    BOOST_CHECK_EQUAL_COLLECTIONS(calls.begin(), calls.end(), expected.begin(), expected.end());
+    BOOST_CHECK_EQUAL(prepared[0], 1);
+    BOOST_CHECK_EQUAL(prepared[1], 1);
+    BOOST_CHECK(preparedBeforeErase);
+    BOOST_CHECK_EQUAL(std::count(states.begin(), states.end(), FlasherState::FallAsleep), 1);
+    BOOST_CHECK_EQUAL(std::count(states.begin(), states.end(), FlasherState::OpenChannels), 2);
+    BOOST_CHECK_EQUAL(std::count(states.begin(), states.end(), FlasherState::WakeUp), 1);
+    BOOST_CHECK(states.back() == FlasherState::Done);
+
+    std::vector<uint8_t> pblEcus;
+    for (const auto& frame : mock1.sentFrames) {
+        if (frame.data.size() >= 2 && frame.data[1] == 0xC0) {
+            pblEcus.push_back(frame.data[0]);
+        }
+    }
+    const std::vector<uint8_t> expectedPbl{ 0x7A, 0x6E };
+    BOOST_CHECK_EQUAL_COLLECTIONS(pblEcus.begin(), pblEcus.end(), expectedPbl.begin(), expectedPbl.end());
+}
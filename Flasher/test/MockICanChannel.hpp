@@ -3,6 +3,7 @@
 #include <common/ICanChannel.hpp>
 
 #include <cstdint>
+#include <functional>
 #include <queue>
 #include <vector>
 
@@ -10,13 +11,19 @@ using namespace common;
 
 class MockICanChannel final : public ICanChannel {
 public:
-    bool send(const CanFrame&, unsigned long = 1000) override {
+    bool send(const CanFrame& frame, unsigned long = 1000) override {
         ++sendCount;
+        sentFrames.push_back(frame);
+        if (onSend) onSend(frame);
         return !failOnSend;
     }
 
     bool send(const std::vector<CanFrame>& frames, unsigned long = 1000) override {
         sendCount += static_cast<int>(frames.size());
+        sentBatches.push_back(frames.size());
+        if (onSend) {
+            for (const auto& frame : frames) onSend(frame);
+        }
         return !failOnSend;
     }
 
@@ -53,6 +60,10 @@ public:
     unsigned long getBaudrate() const override { return 500000; }
 
     int sendCount = 0;
+    std::vector<CanFrame> sentFrames;
+    std::vector<size_t> sentBatches;
+    // Called for every sent frame, e.g. to queue the ECU's answer.
+    std::function<void(const CanFrame&)> onSend;
     bool failOnSend = false;
     bool failOnPeriodic = false;
     std::queue<CanFrame> receiveQueue;
@@ -0,0 +1,144 @@
+#include <boost/test/unit_test.hpp>
+
+#include "../src/UDSBulkReader.hpp"
+#include <common/ICanChannel.hpp>
+
+#include "MockICanChannel.hpp"
+
+#include <cstdint>
+#include <vector>
+
+using namespace flasher;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+namespace {
+
+constexpr uint32_t canId = 0x7E0;
+
+std::vector<uint8_t> makeData(size_t size, uint8_t seed)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(seed + i);
+    }
+    return data;
+}
+
+CanFrame makeReadResponse(uint32_t addr, const std::vector<uint8_t>& data)
+{
+    CanFrame frame{ canId + 8, { 0x63,
+        static_cast<uint8_t>(addr >> 24), static_cast<uint8_t>(addr >> 16),
+        static_cast<uint8_t>(addr >> 8), static_cast<uint8_t>(addr) } };
+    frame.data.insert(frame.data.end(), data.begin(), data.end());
+    return frame;
+}
+
+CanFrame makeUploadResponse(uint8_t blockIndex, const std::vector<uint8_t>& data)
+{
+    CanFrame frame{ canId + 8, { 0x76, blockIndex } };
+    frame.data.insert(frame.data.end(), data.begin(), data.end());
+    return frame;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Test: ReadMemoryByAddress block grows and shrinks on rejection
+// ---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ReadByAddressNegotiatesBlockSize)
+{
+    MockICanChannel mock;
+    const uint32_t addr = 0x10000;
+    const auto data = makeData(0x300, 0x00);
+    const auto slice = [&data](size_t offset, size_t size) {
+        return std::vector<uint8_t>(data.begin() + offset, data.begin() + offset + size);
+    };
+    mock.receiveQueue.push(makeReadResponse(addr, slice(0, 0x100)));
+    mock.receiveQueue.push({ canId + 8, { 0x7F, 0x23, 0x31 } });
+    mock.receiveQueue.push(makeReadResponse(addr + 0x100, slice(0x100, 0x100)));
+    mock.receiveQueue.push(makeReadResponse(addr + 0x200, slice(0x200, 0x100)));
+
+    size_t progress = 0;
+    UDSBulkReader::Config config;
+    UDSBulkReader reader{ canId, config, [&](size_t p) { progress += p; } };
+    std::vector<uint8_t> buffer;
+    reader.read(mock, { addr, data.size() }, buffer);
+
+    // 0x23, ALFID: 2 байта размера, 4 байта адреса
+    BOOST_REQUIRE_EQUAL(mock.sentFrames.size(), 4u);
+    BOOST_CHECK(mock.sentFrames[0].data == std::vector<uint8_t>({ 0x23, 0x24, 0x00, 0x01, 0x00, 0x00, 0x01, 0x00 }));
+    BOOST_CHECK(mock.sentFrames[1].data == std::vector<uint8_t>({ 0x23, 0x24, 0x00, 0x01, 0x01, 0x00, 0x02, 0x00 }));
+    BOOST_CHECK(mock.sentFrames[2].data == std::vector<uint8_t>({ 0x23, 0x24, 0x00, 0x01, 0x01, 0x00, 0x01, 0x00 }));
+    BOOST_CHECK(mock.sentFrames[3].data == std::vector<uint8_t>({ 0x23, 0x24, 0x00, 0x01, 0x02, 0x00, 0x01, 0x00 }));
+    BOOST_CHECK_EQUAL(progress, data.size());
+    BOOST_CHECK_EQUAL(reader.blockSize(), 0x1FFu);
+    BOOST_CHECK(buffer == data);
+}
+
+// ---------------------------------------------------------------------------
+// Test: RequestUpload reads the whole range in ECU-sized blocks
+// ---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ReadByUpload)
+{
+    MockICanChannel mock;
+    const auto first = makeData(0x100, 0x10);
+    const auto second = makeData(0x80, 0x20);
+    mock.receiveQueue.push({ canId + 8, { 0x75, 0x20, 0x01, 0x02 } });
+    mock.receiveQueue.push(makeUploadResponse(1, first));
+    mock.receiveQueue.push({ canId + 8, { 0x7F, 0x36, 0x78 } });
+    mock.receiveQueue.push(makeUploadResponse(2, second));
+    mock.receiveQueue.push({ canId + 8, { 0x77 } });
+
+    UDSBulkReader::Config config;
+    config.allowUpload = true;
+    UDSBulkReader reader{ canId, config, [](size_t) {} };
+    std::vector<uint8_t> buffer;
+    reader.read(mock, { 0x8000, 0x180 }, buffer);
+
+    BOOST_REQUIRE_EQUAL(mock.sentFrames.size(), 4u);
+    const std::vector<uint8_t> uploadRequest{ 0x35, 0x00, 0x44, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x01, 0x80 };
+    BOOST_CHECK(mock.sentFrames[0].data == uploadRequest);
+    BOOST_CHECK(mock.sentFrames[1].data == std::vector<uint8_t>({ 0x36, 0x01 }));
+    BOOST_CHECK(mock.sentFrames[2].data == std::vector<uint8_t>({ 0x36, 0x02 }));
+    BOOST_CHECK(mock.sentFrames[3].data == std::vector<uint8_t>({ 0x37 }));
+    BOOST_CHECK(std::equal(first.begin(), first.end(), buffer.begin()));
+    BOOST_CHECK(std::equal(second.begin(), second.end(), buffer.begin() + 0x100));
+}
+
+// ---------------------------------------------------------------------------
+// Test: rejected RequestUpload falls back to ReadMemoryByAddress
+// ---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(UploadRejectedFallsBack)
+{
+    MockICanChannel mock;
+    const auto data = makeData(0x10, 0x30);
+    mock.receiveQueue.push({ canId + 8, { 0x7F, 0x35, 0x11 } });
+    mock.receiveQueue.push(makeReadResponse(0x8000, data));
+
+    UDSBulkReader::Config config;
+    config.allowUpload = true;
+    UDSBulkReader reader{ canId, config, [](size_t) {} };
+    std::vector<uint8_t> buffer;
+    reader.read(mock, { 0x8000, 0x10 }, buffer);
+
+    BOOST_REQUIRE_EQUAL(mock.sentFrames.size(), 2u);
+    BOOST_CHECK_EQUAL(mock.sentFrames[1].data[0], 0x23);
+    BOOST_CHECK_EQUAL(mock.sentFrames[1].data[1], 0x14);
+    BOOST_CHECK(buffer == data);
+}
+
+// ---------------------------------------------------------------------------
+// Test: no answers ends with an error
+// ---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ReadByAddressFailure)
+{
+    MockICanChannel mock;
+    UDSBulkReader::Config config;
+    config.maxErrorCount = 2;
+    UDSBulkReader reader{ canId, config, [](size_t) {} };
+    std::vector<uint8_t> buffer;
+    BOOST_CHECK_THROW(reader.read(mock, { 0x8000, 0x10 }, buffer), std::runtime_error);
+    BOOST_CHECK_EQUAL(mock.sentFrames.size(), 3u);
+}
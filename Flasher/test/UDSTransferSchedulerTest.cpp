@@ -0,0 +1,305 @@
+#include <boost/test/unit_test.hpp>
+
+#include "../src/UDSTransferScheduler.hpp"
+#include <common/ICanChannel.hpp>
+#include <common/Util.hpp>
+#include <common/protocols/UDSDownloadEncoder.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+using namespace common;
+using namespace flasher;
+
+// ---------------------------------------------------------------------------
+// Simulated bus: several UDS ECUs behind one ISO15765 channel, virtual time.
+// The tester owns the bus while it sends; every ECU works on its own request
+// for a fixed time and then answers. receive() jumps straight to the next
+// answer, so the virtual clock shows how long the whole session takes.
+// ---------------------------------------------------------------------------
+namespace {
+
+constexpr double FrameTimeMs = 0.25;        // 8-byte CAN frame at 500 kbit/s
+constexpr double WriteBlockTimeMs = 20.0;   // ECU writes one TransferData block
+constexpr double EraseTimeMs = 200.0;
+constexpr double ServiceTimeMs = 1.0;
+constexpr uint16_t MaxBlockLength = 0x102;  // 256 data bytes per block
+
+struct SimulatedEcu {
+    explicit SimulatedEcu(uint32_t canId)
+        : canId{ canId }
+    {
+    }
+
+    uint32_t canId;
+    double busyUntil{ 0 };
+    std::map<uint32_t, std::vector<uint8_t>> memory;
+    uint32_t downloadAddr{ 0 };
+    uint8_t downloadFormat{ 0 };
+    std::vector<uint8_t> downloadData;
+    uint8_t failTransferBlock{ 0 };
+    bool pendingOnErase{ false };
+};
+
+class SimulatedBus final : public ICanChannel {
+public:
+    explicit SimulatedBus(std::vector<uint32_t> canIds)
+    {
+        for (const auto canId : canIds) {
+            ecus.emplace_back(canId);
+        }
+    }
+
+    bool send(const CanFrame& frame, unsigned long = 1000) override
+    {
+        sentIds.push_back(frame.id);
+        now += std::max<size_t>(1, (frame.data.size() + 6) / 7) * FrameTimeMs;
+        auto it = std::find_if(ecus.begin(), ecus.end(), [&frame](const SimulatedEcu& ecu) {
+            return ecu.canId == frame.id;
+        });
+        if (it != ecus.end()) {
+            process(*it, frame.data);
+        }
+        return true;
+    }
+
+    bool send(const std::vector<CanFrame>& frames, unsigned long timeout = 1000) override
+    {
+        for (const auto& frame : frames) {
+            send(frame, timeout);
+        }
+        return true;
+    }
+
+    bool receive(CanFrame& frame, unsigned long timeout) override
+    {
+        auto it = std::min_element(pending.begin(), pending.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+        if (it == pending.end() || it->first > now + timeout) {
+            now += timeout;
+            return false;
+        }
+        now = std::max(now, it->first);
+        frame = it->second;
+        pending.erase(it);
+        return true;
+    }
+
+    bool receive(std::vector<CanFrame>& frames, size_t messagesCount, unsigned long timeout) override
+    {
+        CanFrame frame;
+        while (frames.size() < messagesCount && receive(frame, timeout)) {
+            frames.push_back(frame);
+        }
+        return !frames.empty();
+    }
+
+    void clearRx() override {}
+    void clearTx() override {}
+    bool startPeriodicMsg(const CanFrame&, unsigned long, unsigned long&) override { return true; }
+    bool stopPeriodicMsg(unsigned long) override { return true; }
+    unsigned long getBaudrate() const override { return 500000; }
+    bool startMsgFilter(unsigned long, const CanFrame&, const CanFrame&, const CanFrame*,
+                        unsigned long&) override { return true; }
+    bool stopMsgFilter(unsigned long) override { return true; }
+    bool setConfig(unsigned long, unsigned long) override { return true; }
+    bool ioctl(unsigned long, const void*, void*) override { return true; }
+
+    std::vector<SimulatedEcu> ecus;
+    std::vector<uint32_t> sentIds;
+    double now{ 0 };
+
+private:
+    void answer(SimulatedEcu& ecu, double workTime, std::vector<uint8_t> data)
+    {
+        ecu.busyUntil = std::max(now, ecu.busyUntil) + workTime;
+        pending.push_back({ ecu.busyUntil, { ecu.canId + 8, std::move(data) } });
+    }
+
+    static uint32_t readAddr(const std::vector<uint8_t>& data, size_t pos)
+    {
+        return encodeBigEndian(data[pos + 3], data[pos + 2], data[pos + 1], data[pos]);
+    }
+
+    void process(SimulatedEcu& ecu, const std::vector<uint8_t>& request)
+    {
+        switch (request[0]) {
+        case 0x31:
+            if (request[2] == 0xFF) {
+                if (ecu.pendingOnErase) {
+                    pending.push_back({ now + ServiceTimeMs, { ecu.canId + 8, { 0x7F, 0x31, 0x78 } } });
+                }
+                answer(ecu, EraseTimeMs, { 0x71, 0x01, 0xFF, 0x00, 0x00 });
+            }
+            else {
+                answer(ecu, ServiceTimeMs, { 0x71, 0x01, request[2], request[3] });
+            }
+            break;
+        case 0x34:
+            ecu.downloadFormat = request[1];
+            ecu.downloadAddr = readAddr(request, 3);
+            ecu.downloadData.clear();
+            answer(ecu, ServiceTimeMs, { 0x74, 0x20, MaxBlockLength >> 8, MaxBlockLength & 0xFF });
+            break;
+        case 0x36:
+            if (request[1] == ecu.failTransferBlock) {
+                answer(ecu, ServiceTimeMs, { 0x7F, 0x36, 0x72 });
+                break;
+            }
+            ecu.downloadData.insert(ecu.downloadData.end(), request.begin() + 2, request.end());
+            answer(ecu, WriteBlockTimeMs, { 0x76, request[1] });
+            break;
+        case 0x37: {
+            const auto crc = crc16(ecu.downloadData.data(), ecu.downloadData.size());
+            ecu.memory[ecu.downloadAddr] = ecu.downloadData;
+            // Распаковка не моделируется, CRC распакованных данных не отдаётся.
+            if (ecu.downloadFormat != 0x00) {
+                answer(ecu, ServiceTimeMs, { 0x77 });
+                break;
+            }
+            answer(ecu, ServiceTimeMs, { 0x77, static_cast<uint8_t>(crc >> 8), static_cast<uint8_t>(crc) });
+            break;
+        }
+        }
+    }
+
+    std::vector<std::pair<double, CanFrame>> pending;
+};
+
+VBFChunk makeChunk(uint32_t addr, size_t size, uint8_t seed)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(seed + i * 7);
+    }
+    const auto crc = crc16(data.data(), data.size());
+    return { addr, std::move(data), crc };
+}
+
+} // namespace
+
+// ===========================================================================
+// UDSTransferScheduler
+// ===========================================================================
+
+BOOST_AUTO_TEST_CASE(SchedulerFlashesSeveralEcus)
+{
+    SimulatedBus bus{ { 0x7E0, 0x7E1 } };
+    const auto chunkA = makeChunk(0x10000, 0x1000, 1);
+    const auto chunkB = makeChunk(0x20000, 0x0C01, 2);
+    size_t progress = 0;
+    UDSTransferScheduler scheduler{ bus, [&progress](size_t size) { progress += size; } };
+    const auto a = scheduler.addTarget(0x7E0);
+    const auto b = scheduler.addTarget(0x7E1);
+    scheduler.eraseChunk(a, chunkA);
+    scheduler.downloadChunk(a, chunkA);
+    scheduler.checkValidApplication(a);
+    scheduler.eraseChunk(b, chunkB);
+    scheduler.downloadChunk(b, chunkB);
+    scheduler.checkValidApplication(b);
+
+    BOOST_CHECK(scheduler.run());
+    BOOST_CHECK(bus.ecus[0].memory[0x10000] == chunkA.data);
+    BOOST_CHECK(bus.ecus[1].memory[0x20000] == chunkB.data);
+    BOOST_CHECK_EQUAL(progress, chunkA.data.size() + chunkB.data.size());
+}
+
+BOOST_AUTO_TEST_CASE(SchedulerInterleavesTransfers)
+{
+    const auto chunkA = makeChunk(0x10000, 0x4000, 1);
+    const auto chunkB = makeChunk(0x20000, 0x4000, 2);
+
+    SimulatedBus sequentialBus{ { 0x7E0, 0x7E1 } };
+    for (const auto& [canId, chunk] : { std::pair{ 0x7E0u, &chunkA }, std::pair{ 0x7E1u, &chunkB } }) {
+        UDSTransferScheduler scheduler{ sequentialBus, [](size_t) {} };
+        const auto target = scheduler.addTarget(canId);
+        scheduler.eraseChunk(target, *chunk);
+        scheduler.downloadChunk(target, *chunk);
+        BOOST_CHECK(scheduler.run());
+    }
+
+    SimulatedBus interleavedBus{ { 0x7E0, 0x7E1 } };
+    UDSTransferScheduler scheduler{ interleavedBus, [](size_t) {} };
+    const auto a = scheduler.addTarget(0x7E0);
+    const auto b = scheduler.addTarget(0x7E1);
+    scheduler.eraseChunk(a, chunkA);
+    scheduler.downloadChunk(a, chunkA);
+    scheduler.eraseChunk(b, chunkB);
+    scheduler.downloadChunk(b, chunkB);
+    BOOST_CHECK(scheduler.run());
+
+    BOOST_TEST_MESSAGE("sequential " << sequentialBus.now << " ms, interleaved " << interleavedBus.now << " ms");
+    BOOST_CHECK(interleavedBus.ecus[1].memory[0x20000] == chunkB.data);
+    BOOST_CHECK_LT(interleavedBus.now, sequentialBus.now * 0.6);
+}
+
+BOOST_AUTO_TEST_CASE(SchedulerWaitsForPendingErase)
+{
+    SimulatedBus bus{ { 0x7E0 } };
+    bus.ecus[0].pendingOnErase = true;
+    const auto chunk = makeChunk(0x10000, 0x300, 3);
+    UDSTransferScheduler scheduler{ bus, [](size_t) {} };
+    const auto target = scheduler.addTarget(0x7E0);
+    scheduler.eraseChunk(target, chunk);
+    scheduler.downloadChunk(target, chunk);
+
+    BOOST_CHECK(scheduler.run());
+    BOOST_CHECK(bus.ecus[0].memory[0x10000] == chunk.data);
+}
+
+BOOST_AUTO_TEST_CASE(SchedulerFailedEcuDoesNotStopOthers)
+{
+    SimulatedBus bus{ { 0x7E0, 0x7E1 } };
+    bus.ecus[1].failTransferBlock = 3;
+    const auto chunkA = makeChunk(0x10000, 0x800, 1);
+    const auto chunkB = makeChunk(0x20000, 0x800, 2);
+    UDSTransferScheduler scheduler{ bus, [](size_t) {} };
+    const auto a = scheduler.addTarget(0x7E0);
+    const auto b = scheduler.addTarget(0x7E1);
+    scheduler.downloadChunk(a, chunkA);
+    scheduler.downloadChunk(b, chunkB);
+
+    BOOST_CHECK(!scheduler.run());
+    BOOST_CHECK(!scheduler.isFailed(a));
+    BOOST_CHECK(scheduler.isFailed(b));
+    BOOST_CHECK(bus.ecus[0].memory[0x10000] == chunkA.data);
+    BOOST_CHECK(bus.ecus[1].memory.empty());
+}
+
+BOOST_AUTO_TEST_CASE(SchedulerFailsOnChunkCrcMismatch)
+{
+    SimulatedBus bus{ { 0x7E0 } };
+    auto chunk = makeChunk(0x10000, 0x300, 3);
+    chunk.crc ^= 0x1;
+    UDSTransferScheduler scheduler{ bus, [](size_t) {} };
+    const auto target = scheduler.addTarget(0x7E0);
+    scheduler.downloadChunk(target, chunk);
+
+    BOOST_CHECK(!scheduler.run());
+    BOOST_CHECK(scheduler.isFailed(target));
+    // RequestTransferExit не отправлен - ЭБУ не принял чанк.
+    BOOST_CHECK(bus.ecus[0].memory.empty());
+}
+
+BOOST_AUTO_TEST_CASE(SchedulerSendsEncodedChunk)
+{
+    SimulatedBus bus{ { 0x7E0 } };
+    const VBF vbf{ {}, { makeChunk(0x10000, 0x1000, 4) } };
+    const auto& chunk = vbf.chunks.front();
+    UDSDownloadEncoder encoder{ CompressionType::LZSS, EncryptionType::None };
+    encoder.start(vbf);
+    size_t progress = 0;
+    UDSTransferScheduler scheduler{ bus, [&progress](size_t size) { progress += size; } };
+    const auto target = scheduler.addTarget(0x7E0);
+    scheduler.downloadChunk(target, chunk, &encoder);
+
+    BOOST_CHECK(scheduler.run());
+    BOOST_CHECK_EQUAL(bus.ecus[0].downloadFormat, encoder.getDataFormatIdentifier());
+    BOOST_CHECK(bus.ecus[0].memory[0x10000] == encoder.get(chunk));
+    BOOST_CHECK_LT(bus.ecus[0].memory[0x10000].size(), chunk.data.size());
+    // Прогресс в байтах исходного чанка, как и его максимум.
+    BOOST_CHECK_EQUAL(progress, chunk.data.size());
+}
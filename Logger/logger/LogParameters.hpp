@@ -12,6 +12,7 @@ public:
   LogParameters() = default;
   explicit LogParameters(const std::string &path);
   explicit LogParameters(std::istream &stream);
+  explicit LogParameters(std::vector<LogParameter> parameters);
   LogParameters(const LogParameters &rhs) = default;
 
   const LogParameters &operator=(const LogParameters &rhs);
@@ -14,16 +14,25 @@
 #include <thread>
 #include <vector>
 
+namespace common {
+	class ICanChannel;
+} // namespace common
+
 namespace logger {
 	class LoggerCallback;
 
 	enum class LoggerType { LT_D2, LT_UDS };
 
+	// Polling - the logger requests values every 50 ms.
+	// Periodic* - UDS ECU sends values itself (0x2A) with the selected rate.
+	enum class LoggingMode { Polling, PeriodicSlow, PeriodicMedium, PeriodicFast };
+
 	class LoggerImpl;
 
 	class Logger final {
 	public:
-        explicit Logger(j2534::J2534& j2534, common::CarPlatform carPlatform, uint32_t ecuId, const std::string& cmInfo);
+        explicit Logger(j2534::J2534& j2534, common::CarPlatform carPlatform, uint32_t ecuId, const std::string& cmInfo,
+                        LoggingMode mode = LoggingMode::Polling);
 		~Logger();
 
 		void registerCallback(LoggerCallback& callback);
@@ -36,6 +45,10 @@ namespace logger {
 		void registerParameters();
 
 		void logFunction();
+		void pollRecords(common::ICanChannel& channel, std::chrono::steady_clock::time_point startTimepoint);
+		void receiveRecords(common::ICanChannel& channel, common::ICanChannel& rawChannel,
+			std::chrono::steady_clock::time_point startTimepoint);
+		bool isStopped();
 
 		struct LogRecord {
 			LogRecord() = default;
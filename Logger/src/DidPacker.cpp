@@ -0,0 +1,33 @@
+#include "DidPacker.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace logger {
+
+std::vector<DidInfo> packDids(const ParameterReadPlan& plan, size_t maxDataSize, uint16_t didBase)
+{
+    const auto& blocks = plan.blocks();
+    std::vector<size_t> order(blocks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&blocks](size_t lhs, size_t rhs) {
+        return blocks[lhs].size > blocks[rhs].size;
+    });
+    std::vector<DidInfo> result;
+    for (const auto blockIndex : order) {
+        const auto& block = blocks[blockIndex];
+        auto it = std::find_if(result.begin(), result.end(), [maxDataSize, &block](const DidInfo& did) {
+            return did.size + block.size <= maxDataSize;
+        });
+        if (it == result.end()) {
+            result.push_back({ static_cast<uint16_t>(didBase + result.size()), {}, 0 });
+            it = std::prev(result.end());
+        }
+        it->blockIndexes.push_back(blockIndex);
+        it->size += block.size;
+    }
+    return result;
+}
+
+} // namespace logger
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "ParameterReadPlan.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace logger {
+
+// DDDI (0x2C), собранный из блоков плана чтения.
+struct DidInfo {
+    uint16_t didId;
+    std::vector<size_t> blockIndexes;  // индексы в plan.blocks()
+    size_t size;
+};
+
+// Раскладка блоков плана по наименьшему числу DID размером не больше
+// maxDataSize (first fit decreasing). Идентификаторы выдаются подряд,
+// начиная с didBase.
+std::vector<DidInfo> packDids(const ParameterReadPlan& plan, size_t maxDataSize, uint16_t didBase);
+
+} // namespace logger
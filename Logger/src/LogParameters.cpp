@@ -6,6 +6,7 @@
 
 #include <fstream>
 #include <numeric>
+#include <utility>
 
 namespace logger {
 
@@ -51,6 +52,10 @@ namespace logger {
 		load(reader);
 	}
 
+	LogParameters::LogParameters(std::vector<LogParameter> parameters)
+		: _parameters{ std::move(parameters) } {
+	}
+
 	const LogParameters& LogParameters::operator=(const LogParameters& rhs) {
 		if (this == &rhs)
 			return *this;
@@ -1,6 +1,9 @@
 #include "logger/Logger.hpp"
 
 #include "logger/LoggerCallback.hpp"
+#include "DidPacker.hpp"
+#include "ParameterReadPlan.hpp"
+#include "PeriodicFrame.hpp"
 
 #include <common/CommonData.hpp>
 #include <common/ICanChannel.hpp>
@@ -8,8 +11,10 @@
 #include <common/protocols/D2Request.hpp>
 #include <common/protocols/D2Message.hpp>
 #include <common/protocols/D2Messages.hpp>
+#include <common/protocols/UDSError.hpp>
 #include <common/protocols/UDSRequest.hpp>
 #include <common/protocols/UDSProtocolCommonSteps.hpp>
+#include <common/protocols/UDSTiming.hpp>
 #include <common/Util.hpp>
 #include <common/utility.hpp>
 #include <j2534/J2534.hpp>
@@ -22,34 +27,80 @@
 #include <chrono>
 #include <numeric>
 #include <ios>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <span>
 #include <sstream>
 
 namespace logger {
 
+    namespace {
+
+    // Старший байт первым; у длинных значений остаются последние 4 байта.
+    uint32_t decodeMsbFirst(std::span<const uint8_t> data)
+    {
+        uint32_t value = 0;
+        for (const auto byte : data) {
+            value = (value << 8) | byte;
+        }
+        return value;
+    }
+
+    // Младший байт первым; у длинных значений берутся первые 4 байта.
+    uint32_t decodeLsbFirst(std::span<const uint8_t> data)
+    {
+        uint32_t value = 0;
+        for (size_t i = 0; i < data.size() && i < 4; ++i) {
+            value |= static_cast<uint32_t>(data[i]) << (i * 8);
+        }
+        return value;
+    }
+
+    } // namespace
+
 	class LoggerImpl {
 	public:
         LoggerImpl() {}
+        virtual ~LoggerImpl() = default;
 
 		virtual void registerParameters(common::ICanChannel& channel,
 			const LogParameters& parameters) = 0;
 		virtual std::vector<uint32_t>
 			requestMemory(common::ICanChannel& channel,
 				const LogParameters& parameters) = 0;
+
+        // Потоковый режим: ЭБУ сам присылает значения, requestMemory не вызывается.
+        // Запросы идут через channel, а значения принимаются сырым CAN каналом rawChannel.
+        virtual bool isStreaming() const { return false; }
+        virtual void startStreaming(common::ICanChannel& /*channel*/, common::ICanChannel& /*rawChannel*/) {}
+        virtual void stopStreaming(common::ICanChannel& /*channel*/, common::ICanChannel& /*rawChannel*/) {}
+        // Разбирает пришедшие кадры; значения возвращаются, когда собран полный набор.
+        virtual std::optional<std::vector<uint32_t>>
+            receiveValues(common::ICanChannel& /*rawChannel*/,
+                const LogParameters& /*parameters*/, unsigned long /*timeout*/) {
+            return std::nullopt;
+        }
 	};
 
 	class D2LoggerImpl : public LoggerImpl {
 	public:
-        D2LoggerImpl() : LoggerImpl() {}
+        D2LoggerImpl()
+            : LoggerImpl()
+            , _maxRegisterSize{ 8 }
+        {
+        }
 
 	private:
 		virtual void registerParameters(common::ICanChannel& channel,
 			const LogParameters& parameters) override {
             common::D2Request unregisterRequest{common::D2Messages::unregisterAllMemoryRequest};
             unregisterRequest.process(channel);
-            for (const auto parameter : parameters.parameters()) {
+            _plan = ParameterReadPlan(parameters, _maxRegisterSize);
+            _data.assign(_plan.dataSize(), 0);
+            for (const auto& block : _plan.blocks()) {
                 common::D2Request registerParameterRequest{
-					common::D2Messages::makeRegisterAddrRequest(parameter.addr(),
-																parameter.size()) };
+					common::D2Messages::makeRegisterAddrRequest(block.addr, block.size) };
                 registerParameterRequest.process(channel);
 			}
 		}
@@ -59,143 +110,185 @@ namespace logger {
 			const LogParameters& parameters) override
         {
             common::D2Request requestMemory{ common::D2Messages::requestMemory };
-            auto data { requestMemory.process(channel) };
+            const auto data{ requestMemory.process(channel, _data) };
 
             std::vector<uint32_t> result(parameters.parameters().size());
-            size_t paramIndex = 0;
-            size_t paramOffset = 0;
-            uint32_t value = 0;
-            for(size_t i = 0; i < data.size(); ++i) {
-                const auto& param = parameters.parameters()[paramIndex];
-                value += data[i] << ((param.size() - paramOffset - 1) * 8);
-                ++paramOffset;
-                if (paramOffset >= param.size()) {
-                    result[paramIndex] = value;
-                    ++paramIndex;
-                    paramOffset = 0;
-                    value = 0;
-                }
-                if (paramIndex >= result.size()) {
-                    break;
-                }
+            for (size_t i = 0; i < result.size(); ++i) {
+                result[i] = decodeMsbFirst(_plan.parameterData(i, data));
             }
 			return result;
 		}
+
+        const size_t _maxRegisterSize;
+        ParameterReadPlan _plan;
+        std::vector<uint8_t> _data;
 	};
 
-    class D2BBLoggerImpl : public LoggerImpl {
+    // Логгеры, читающие память ЭБУ запросом на каждый блок плана.
+    class D2ReadLoggerImpl : public LoggerImpl {
     public:
-        D2BBLoggerImpl(uint32_t ecuId)
+        explicit D2ReadLoggerImpl(size_t maxBlockSize)
             : LoggerImpl()
-            , _ecuId(ecuId)
+            , _maxBlockSize{ maxBlockSize }
         {
         }
 
+    protected:
+        virtual void readBlock(common::ICanChannel& channel, uint32_t addr, std::span<uint8_t> out) = 0;
+        virtual uint32_t decodeValue(std::span<const uint8_t> data) const = 0;
+
     private:
-        virtual void registerParameters(common::ICanChannel&, const LogParameters&) override
+        virtual void registerParameters(common::ICanChannel&, const LogParameters& parameters) override
         {
+            _plan = ParameterReadPlan(parameters, _maxBlockSize);
+            _data.assign(_plan.dataSize(), 0);
         }
 
         virtual std::vector<uint32_t>
         requestMemory(common::ICanChannel& channel,
                       const LogParameters& parameters) override
         {
+            std::fill(_data.begin(), _data.end(), 0);
+            for (const auto& block : _plan.blocks()) {
+                readBlock(channel, block.addr, std::span<uint8_t>{ _data }.subspan(block.offset, block.size));
+            }
             std::vector<uint32_t> result(parameters.parameters().size());
-            for (size_t i = 0; i < parameters.parameters().size(); ++i) {
-                common::D2Request readMemoryRequest{
-                    common::D2Messages::createReadDataByAddrMsg(
-                    static_cast<uint8_t>(_ecuId), parameters.parameters()[i].addr(),
-                        static_cast<uint8_t>(parameters.parameters()[i].size())) };
-
-                const auto readResponse{ readMemoryRequest.process(channel) };
-                result[i] = common::encodeBigEndian(readResponse);
+            for (size_t i = 0; i < result.size(); ++i) {
+                result[i] = decodeValue(_plan.parameterData(i, _data));
             }
             return result;
         }
 
-        uint32_t _ecuId;
+        const size_t _maxBlockSize;
+        ParameterReadPlan _plan;
+        std::vector<uint8_t> _data;
     };
 
-    class AW55D2LoggerImpl : public LoggerImpl {
+    class D2BBLoggerImpl : public D2ReadLoggerImpl {
     public:
-        AW55D2LoggerImpl() : LoggerImpl() {}
+        D2BBLoggerImpl(uint32_t ecuId)
+            : D2ReadLoggerImpl(8)
+            , _ecuId(ecuId)
+        {
+        }
 
     private:
-        virtual void registerParameters(common::ICanChannel&, const LogParameters&) override
+        virtual void readBlock(common::ICanChannel& channel, uint32_t addr, std::span<uint8_t> out) override
         {
+            common::D2Request readMemoryRequest{
+                common::D2Messages::createReadDataByAddrMsg(
+                    static_cast<uint8_t>(_ecuId), addr, static_cast<uint8_t>(out.size())) };
+            readMemoryRequest.process(channel, out);
         }
 
-        virtual std::vector<uint32_t>
-        requestMemory(common::ICanChannel& channel,
-                      const LogParameters& parameters) override
+        virtual uint32_t decodeValue(std::span<const uint8_t> data) const override
         {
-            std::vector<uint32_t> result(parameters.parameters().size());
-            for (size_t i = 0; i < parameters.parameters().size(); ++i) {
-                common::D2Request readMemoryRequest{
-                                                    common::D2Messages::createReadDataByOffsetMsg(
-                                                        static_cast<uint8_t>(common::D2ECUType::TCM), parameters.parameters()[i].addr(),
-                                                        static_cast<uint8_t>(parameters.parameters()[i].size())) };
-
-                const auto readResponse{ readMemoryRequest.process(channel) };
-                result[i] = common::encodeBigEndian(readResponse);
-            }
-            return result;
+            return decodeLsbFirst(data);
         }
+
+        uint32_t _ecuId;
     };
 
-    class TF80D2LoggerImpl : public LoggerImpl {
+    class AW55D2LoggerImpl : public D2ReadLoggerImpl {
     public:
-        TF80D2LoggerImpl() : LoggerImpl() {}
+        AW55D2LoggerImpl() : D2ReadLoggerImpl(4) {}
 
     private:
-        virtual void registerParameters(common::ICanChannel&, const LogParameters&) override
+        virtual void readBlock(common::ICanChannel& channel, uint32_t addr, std::span<uint8_t> out) override
         {
+            common::D2Request readMemoryRequest{
+                common::D2Messages::createReadDataByOffsetMsg(
+                    static_cast<uint8_t>(common::D2ECUType::TCM), addr, static_cast<uint8_t>(out.size())) };
+            readMemoryRequest.process(channel, out);
         }
 
-        virtual std::vector<uint32_t>
-        requestMemory(common::ICanChannel& channel,
-                      const LogParameters& parameters) override
+        virtual uint32_t decodeValue(std::span<const uint8_t> data) const override
         {
-            std::vector<uint32_t> result(parameters.parameters().size());
-            for (size_t i = 0; i < parameters.parameters().size(); ++i) {
-                common::D2Request readMemoryRequest{
-                    common::D2Messages::createReadTCMTF80DataByAddr(
-                        parameters.parameters()[i].addr(),
-                        parameters.parameters()[i].size()) };
+            return decodeLsbFirst(data);
+        }
+    };
 
-                const auto readResponse{ readMemoryRequest.process(channel, 200, 3) };
-                result[i] = common::encodeLittleEndian(readResponse);
-            }
-            return result;
+    class TF80D2LoggerImpl : public D2ReadLoggerImpl {
+    public:
+        TF80D2LoggerImpl() : D2ReadLoggerImpl(132) {}
+
+    private:
+        virtual void readBlock(common::ICanChannel& channel, uint32_t addr, std::span<uint8_t> out) override
+        {
+            common::D2Request readMemoryRequest{
+                common::D2Messages::createReadTCMTF80DataByAddr(addr, out.size()) };
+            readMemoryRequest.process(channel, out, 200, 3);
+        }
+
+        virtual uint32_t decodeValue(std::span<const uint8_t> data) const override
+        {
+            return decodeMsbFirst(data);
         }
     };
 
     class UDSLoggerImpl : public LoggerImpl {
 	public:
-        UDSLoggerImpl(uint32_t canId)
+        UDSLoggerImpl(uint32_t canId, size_t didMaxDataSize = 0x40)
             : LoggerImpl()
             , _canId{ canId }
 			, _didBase(0xF200)
-            , _didMaxDataSize{ 7 }
+            , _didMaxDataSize{ didMaxDataSize }
 		{
 		}
 
-	private:
-        /**
-         * @brief Get DID index or create new
-         * @param logParameter
-         * @return
-         */
-        size_t getFittingDidIndex(const LogParameter& logParameter) {
-            uint16_t maxId = _didBase - 1;
-            for(size_t i = 0; i < _didRequests.size(); ++i) {
-                if(_didRequests[i].freeSize >= logParameter.size()) {
-                    return i;
+	protected:
+        bool isSameLayout(const ParameterReadPlan& plan, const std::vector<DidInfo>& dids) const {
+            const auto sameBlock = [](const ParameterReadPlan::Block& lhs, const ParameterReadPlan::Block& rhs) {
+                return lhs.addr == rhs.addr && lhs.size == rhs.size;
+            };
+            if (dids.size() != _definedDids.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < dids.size(); ++i) {
+                const auto& lhs = dids[i].blockIndexes;
+                const auto& rhs = _definedDids[i].blockIndexes;
+                if (dids[i].didId != _definedDids[i].didId || lhs.size() != rhs.size()) {
+                    return false;
+                }
+                for (size_t j = 0; j < lhs.size(); ++j) {
+                    if (!sameBlock(plan.blocks()[lhs[j]], _definedPlan.blocks()[rhs[j]])) {
+                        return false;
+                    }
                 }
-                maxId = std::max(maxId, _didRequests[i].didId);
             }
-            _didRequests.emplace_back(DidInfo(maxId + 1, _didMaxDataSize));
-            return _didRequests.size() - 1;
+            return true;
+        }
+
+        void defineDid(common::ICanChannel& channel, const DidInfo& didInfo) {
+            const auto did = didInfo.didId;
+            common::UDSRequest clearDDDIRequest{_canId, { 0x2C, 0x03, static_cast<uint8_t>(did >> 8), static_cast<uint8_t>(did) }, _timing};
+            clearDDDIRequest.process(channel);
+            constexpr uint8_t addrLength = 4;
+            constexpr uint8_t dataLength = 2;
+            constexpr uint8_t dataFormat = (dataLength << 4) + addrLength;
+            std::vector<uint8_t> formattedParams{ 0x2C, 0x02, static_cast<uint8_t>(did >> 8), static_cast<uint8_t>(did), dataFormat };
+            for (const auto blockIndex : didInfo.blockIndexes) {
+                const auto& block = _plan.blocks()[blockIndex];
+                const auto formattedAddr = common::toVector(block.addr);
+                const auto formattedSize = common::toVector(static_cast<uint16_t>(block.size));
+                formattedParams.insert(formattedParams.end(), formattedAddr.cbegin(), formattedAddr.cend());
+                formattedParams.insert(formattedParams.end(), formattedSize.cbegin(), formattedSize.cend());
+            }
+            common::UDSRequest registerRequest(_canId, formattedParams, _timing);
+            registerRequest.process(channel);
+        }
+
+        static bool isSizeRejected(const common::UDSError& error) {
+            return error.getErrorCode() == common::UDSError::ErrorCode::RequestOutOfRange
+                || error.getErrorCode() == common::UDSError::ErrorCode::InvalidMessageOrLengthFormat;
+        }
+
+        // ЭБУ не принимает столько DID в одном запросе 0x22 или ответ на
+        // него не помещается в буфер.
+        static bool isMultiDidRejected(const common::UDSError& error) {
+            return error.getErrorCode() == common::UDSError::ErrorCode::InvalidMessageOrLengthFormat
+                || error.getErrorCode() == common::UDSError::ErrorCode::ResponseTooLong
+                || error.getErrorCode() == common::UDSError::ErrorCode::RequestOutOfRange;
         }
 
 		virtual void
@@ -203,91 +296,244 @@ namespace logger {
 				const LogParameters& parameters) override {
 
             common::UDSRequest diagSessionRequest{_canId, { 0x10, 0x03 }};
-            if(diagSessionRequest.process(channel).empty()) {
+            const auto sessionResponse{ diagSessionRequest.process(channel) };
+            if(sessionResponse.empty()) {
                 return;
             }
-            _didRequests.clear();
-            for (size_t i = 0; i < parameters.parameters().size(); ++i) {
-                const auto& param = parameters.parameters()[i];
-                size_t didIndex = getFittingDidIndex(param);
-                _didRequests[didIndex].paramIndexes.push_back(i);
-                _didRequests[didIndex].freeSize -= param.size();
-            }
-            for (const auto& didRequest: _didRequests) {
-                const auto did = didRequest.didId;
-                common::UDSRequest clearDDDIRequest{_canId, { 0x2C, 0x03, static_cast<uint8_t>(did >> 8), static_cast<uint8_t>(did) }};
-                const auto clearResponse{clearDDDIRequest.process(channel)};
-                if(clearResponse.empty()) {
+            _timing = common::UDSTiming::fromSessionResponse(sessionResponse);
+            // Размер DDDI подбирается: если ЭБУ отклоняет определение,
+            // размер уменьшается вдвое и раскладка строится заново.
+            while (true) {
+                _plan = ParameterReadPlan(parameters, _didMaxDataSize);
+                _data.assign(_plan.dataSize(), 0);
+                _didRequests = packDids(_plan, _didMaxDataSize, _didBase);
+                if (isSameLayout(_plan, _didRequests)) {
+                    try {
+                        readDids(channel);
+                        LOG_MODULE(DEBUG) << "DDDI layout unchanged, skip define";
+                        return;
+                    }
+                    catch (const std::exception& ex) {
+                        LOG_MODULE(DEBUG) << "DDDI layout must be defined again: " << ex.what();
+                    }
+                }
+                _definedDids.clear();
+                try {
+                    for (const auto& didRequest: _didRequests) {
+                        defineDid(channel, didRequest);
+                    }
+                    _definedPlan = _plan;
+                    _definedDids = _didRequests;
                     return;
                 }
-                constexpr uint8_t addrLength = 4;
-                constexpr uint8_t dataLength = 2;
-                constexpr uint8_t dataFormat = (dataLength << 4) + addrLength;
-                std::vector<uint8_t> formattedParams{ 0x2C, 0x02, static_cast<uint8_t>(did >> 8), static_cast<uint8_t>(did), dataFormat };
-                for(const auto& paramIndex: didRequest.paramIndexes) {
-                    const auto& param = parameters.parameters()[paramIndex];
-                    const auto formattedAddr = common::toVector(param.addr());
-                    const auto formattedSize = common::toVector(static_cast<uint16_t>(param.size()));
-                    formattedParams.insert(formattedParams.end(), formattedAddr.cbegin(), formattedAddr.cend());
-                    formattedParams.insert(formattedParams.end(), formattedSize.cbegin(), formattedSize.cend());
+                catch (const common::UDSError& error) {
+                    if (!isSizeRejected(error) || _didMaxDataSize <= 1) {
+                        LOG_MODULE(ERROR) << "DDDI define failed: " << error.what();
+                        return;
+                    }
+                    _didMaxDataSize /= 2;
+                    LOG_MODULE(DEBUG) << "DDDI rejected, max DID size " << _didMaxDataSize;
                 }
-                common::UDSRequest registerRequest(_canId, formattedParams);
-                if(registerRequest.process(channel).empty()) {
+                catch (const std::exception& ex) {
+                    LOG_MODULE(ERROR) << "DDDI define failed: " << ex.what();
                     return;
                 }
             }
 		}
 
+        /**
+         * @brief Read DIDs, several per 0x22 request while the ECU accepts it
+         */
+        void readDids(common::ICanChannel& channel) {
+            for (size_t first = 0; first < _didRequests.size();) {
+                const size_t count = std::min(_didsPerRequest, _didRequests.size() - first);
+                try {
+                    readDidGroup(channel, first, count);
+                    first += count;
+                }
+                catch (const common::UDSError& error) {
+                    if (count == 1 || !isMultiDidRejected(error)) {
+                        throw;
+                    }
+                    _didsPerRequest = std::max<size_t>(count / 2, 1);
+                    LOG_MODULE(DEBUG) << "Multi-DID read rejected: " << error.what()
+                                      << ", DIDs per request " << _didsPerRequest;
+                }
+            }
+        }
+
+        void readDidGroup(common::ICanChannel& channel, size_t first, size_t count) {
+            _request.assign({ 0x22 });
+            for (size_t i = first; i < first + count; ++i) {
+                _request.push_back(static_cast<uint8_t>(_didRequests[i].didId >> 8));
+                _request.push_back(static_cast<uint8_t>(_didRequests[i].didId));
+            }
+            common::UDSRequest requestDid{ _canId, _request, _timing };
+            const auto data{ requestDid.process(channel) };
+            size_t pos = 1;
+            for (size_t i = first; i < first + count; ++i) {
+                const auto& didRequest = _didRequests[i];
+                if (pos + 2 + didRequest.size > data.size()
+                    || data[pos] != static_cast<uint8_t>(didRequest.didId >> 8)
+                    || data[pos + 1] != static_cast<uint8_t>(didRequest.didId)) {
+                    throw std::runtime_error("Unexpected DID response");
+                }
+                pos += 2;
+                for (const auto blockIndex : didRequest.blockIndexes) {
+                    const auto& block = _plan.blocks()[blockIndex];
+                    std::copy_n(data.cbegin() + pos, block.size, _data.begin() + block.offset);
+                    pos += block.size;
+                }
+            }
+        }
+
 		virtual std::vector<uint32_t>
 			requestMemory(common::ICanChannel& channel,
 				const LogParameters& parameters) override {
+            readDids(channel);
             std::vector<uint32_t> result(parameters.parameters().size());
-			size_t paramOffset = 0;
-			uint32_t value = 0;
-            for (const auto& didRequest: _didRequests) {
-                const auto did = didRequest.didId;
-                common::UDSRequest requestDid{_canId, { 0x22, static_cast<uint8_t>(did >> 8), static_cast<uint8_t>(did) }};
-                const auto data{requestDid.process(channel)};
-                size_t paramIndex = 0;
-                for(size_t i = 3; i < data.size(); ++i) {
-                    const size_t initialParamIndex{didRequest.paramIndexes[paramIndex]};
-                    const auto& param = parameters.parameters()[initialParamIndex];
-                    value += data[i] << ((param.size() - paramOffset - 1) * 8);
-                    ++paramOffset;
-                    if (paramOffset >= param.size()) {
-                        result[initialParamIndex] = value;
-                        ++paramIndex;
-                        paramOffset = 0;
-                        value = 0;
-                    }
-                    if (paramIndex >= didRequest.paramIndexes.size()) {
-                        break;
-                    }
-                }
+            for (size_t i = 0; i < result.size(); ++i) {
+                result[i] = decodeMsbFirst(_plan.parameterData(i, _data));
             }
 			return result;
 		}
 
-        struct DidInfo {
-            DidInfo(uint16_t didId, size_t freeSize)
-                : didId{ didId }
-                , freeSize{ freeSize }
-            {
-            }
-            DidInfo(const DidInfo&) = default;
-            DidInfo(DidInfo&&) = default;
-
-            uint16_t didId;
-            std::vector<size_t> paramIndexes;
-            size_t freeSize;
-        };
-
         const uint32_t _canId;
 		const uint16_t _didBase;
-        const size_t _didMaxDataSize;
+        size_t _didMaxDataSize;
+        // Сколько DID ЭБУ отдаёт одним запросом 0x22, уточняется при чтении.
+        size_t _didsPerRequest{ std::numeric_limits<size_t>::max() };
+        ParameterReadPlan _plan;
         std::vector<DidInfo> _didRequests;
+        ParameterReadPlan _definedPlan;
+        std::vector<DidInfo> _definedDids;
+        std::vector<uint8_t> _data;
+        std::vector<uint8_t> _request;
+        common::UDSTiming _timing;
 	};
 
+    // Периодическая передача (0x2A): DDDI определяются так же, как в
+    // UDSLoggerImpl, после чего ЭБУ сам присылает их с выбранной частотой.
+    // Каждый DID приходит отдельным кадром с CAN id ответа ЭБУ без ISO-TP
+    // (parsePeriodicFrame), поэтому кадры принимает сырой CAN канал с pass
+    // фильтром на этот id. Запись формируется, когда пришли все DID набора.
+    class UDSPeriodicLoggerImpl : public UDSLoggerImpl {
+    public:
+        enum class Rate : uint8_t { Slow = 0x01, Medium = 0x02, Fast = 0x03 };
+
+        UDSPeriodicLoggerImpl(uint32_t canId, Rate rate)
+            : UDSLoggerImpl(canId, MaxPeriodicDidSize)
+            , _rate{ rate }
+        {
+        }
+
+    private:
+        // DID должен помещаться в один кадр вместе с pDID.
+        static constexpr size_t MaxPeriodicDidSize = 7;
+        static constexpr uint8_t StopSending = 0x04;
+        static constexpr unsigned long PassFilter = 0x00000001;
+
+        std::vector<uint8_t> periodicRequest(uint8_t transmissionMode) const {
+            std::vector<uint8_t> request{ 0x2A, transmissionMode };
+            for (const auto& didRequest : _didRequests) {
+                request.push_back(static_cast<uint8_t>(didRequest.didId));
+            }
+            return request;
+        }
+
+        virtual bool isStreaming() const override { return true; }
+
+        virtual void startStreaming(common::ICanChannel& channel, common::ICanChannel& rawChannel) override {
+            _received.assign(_didRequests.size(), false);
+            _receivedCount = 0;
+            // Фильтр ставится до запуска передачи, чтобы не потерять первые кадры.
+            // CAN id ответа тот же, что в flow control фильтре prepareUDSChannel.
+            unsigned long filterId = 0;
+            if (!rawChannel.startMsgFilter(PassFilter, { 0xFFFFFFFF, {} }, { _canId + 0x8, {} }, nullptr, filterId)) {
+                throw std::runtime_error("Failed to set periodic response filter");
+            }
+            _passFilterId = filterId;
+            rawChannel.clearRx();
+            // Запросов больше нет, сессию держит TesterPresent.
+            _keepAliveIds = common::UDSProtocolCommonSteps::keepAlive(channel, _canId);
+            common::UDSRequest startRequest{ _canId, periodicRequest(static_cast<uint8_t>(_rate)), _timing };
+            startRequest.process(channel);
+        }
+
+        virtual void stopStreaming(common::ICanChannel& channel, common::ICanChannel& rawChannel) override {
+            try {
+                common::UDSRequest stopRequest{ _canId, periodicRequest(StopSending), _timing };
+                stopRequest.process(channel);
+            }
+            catch (const std::exception& ex) {
+                LOG_MODULE(ERROR) << "Failed to stop periodic transmission: " << ex.what();
+            }
+            for (const auto msgId : _keepAliveIds) {
+                channel.stopPeriodicMsg(msgId);
+            }
+            _keepAliveIds.clear();
+            if (_passFilterId) {
+                rawChannel.stopMsgFilter(*_passFilterId);
+                _passFilterId.reset();
+            }
+        }
+
+        bool storeDid(const PeriodicFrame& periodicFrame) {
+            for (size_t i = 0; i < _didRequests.size(); ++i) {
+                const auto& didRequest = _didRequests[i];
+                if (static_cast<uint8_t>(didRequest.didId) != periodicFrame.periodicId
+                    || periodicFrame.data.size() < didRequest.size) {
+                    continue;
+                }
+                size_t pos = 0;
+                for (const auto blockIndex : didRequest.blockIndexes) {
+                    const auto& block = _plan.blocks()[blockIndex];
+                    std::copy_n(periodicFrame.data.begin() + pos, block.size, _data.begin() + block.offset);
+                    pos += block.size;
+                }
+                if (!_received[i]) {
+                    _received[i] = true;
+                    ++_receivedCount;
+                }
+                return true;
+            }
+            return false;
+        }
+
+        virtual std::optional<std::vector<uint32_t>>
+            receiveValues(common::ICanChannel& rawChannel,
+                const LogParameters& parameters, unsigned long timeout) override {
+            const auto deadline{ std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout) };
+            common::CanFrame frame;
+            while (_receivedCount < _didRequests.size()) {
+                const auto now{ std::chrono::steady_clock::now() };
+                if (now >= deadline) {
+                    return std::nullopt;
+                }
+                const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+                if (!rawChannel.receive(frame, static_cast<unsigned long>(remaining))) {
+                    return std::nullopt;
+                }
+                if (const auto periodicFrame{ parsePeriodicFrame(frame.data) }) {
+                    storeDid(*periodicFrame);
+                }
+            }
+            _received.assign(_received.size(), false);
+            _receivedCount = 0;
+            std::vector<uint32_t> result(parameters.parameters().size());
+            for (size_t i = 0; i < result.size(); ++i) {
+                result[i] = decodeMsbFirst(_plan.parameterData(i, _data));
+            }
+            return result;
+        }
+
+        const Rate _rate;
+        std::vector<bool> _received;
+        size_t _receivedCount{ 0 };
+        std::vector<unsigned long> _keepAliveIds;
+        std::optional<unsigned long> _passFilterId;
+    };
+
     class UDSSlowLoggerImpl : public LoggerImpl {
     public:
         UDSSlowLoggerImpl(uint32_t canId)
@@ -351,9 +597,20 @@ namespace logger {
         const uint32_t _canId;
     };
 
-    std::unique_ptr<LoggerImpl> createLoggerImpl(common::CarPlatform carPlatform, uint32_t cmId, const std::string& cmInfo)
+    std::unique_ptr<LoggerImpl> createLoggerImpl(common::CarPlatform carPlatform, uint32_t cmId, const std::string& cmInfo,
+                                                 LoggingMode mode)
 	{
 		using common::CarPlatform;
+        if (mode != LoggingMode::Polling) {
+            if (carPlatform != CarPlatform::P3 && carPlatform != CarPlatform::Ford_UDS && carPlatform != CarPlatform::VAG) {
+                throw std::runtime_error("Periodic logging is not supported for this platform");
+            }
+            const auto rate = mode == LoggingMode::PeriodicFast ? UDSPeriodicLoggerImpl::Rate::Fast
+                : mode == LoggingMode::PeriodicMedium ? UDSPeriodicLoggerImpl::Rate::Medium
+                : UDSPeriodicLoggerImpl::Rate::Slow;
+            const common::ECUInfo ecuInfo{ std::get<1>(common::getEcuInfoByEcuId(carPlatform, cmId)) };
+            return std::make_unique<UDSPeriodicLoggerImpl>(ecuInfo.canId, rate);
+        }
         if (cmId == to_underlying(common::D2ECUType::ECM_ME)
             && (carPlatform == CarPlatform::P80 || carPlatform == CarPlatform::P1
 			|| carPlatform == CarPlatform::P2 || carPlatform == CarPlatform::P2_250)) {
@@ -401,14 +658,15 @@ namespace logger {
 		}
 	}
 
-    Logger::Logger(j2534::J2534& j2534, common::CarPlatform carPlatform, uint32_t ecuId, const std::string& cmInfo)
+    Logger::Logger(j2534::J2534& j2534, common::CarPlatform carPlatform, uint32_t ecuId, const std::string& cmInfo,
+                   LoggingMode mode)
         : _j2534ChannelProvider{ j2534, carPlatform }
 		, _carPlatform{ carPlatform }
         , _ecuId{ ecuId }
 		, _cmInfo{ cmInfo }
 		, _loggingThread{}
 		, _stopped{ true }
-        , _loggerImpl(createLoggerImpl(_carPlatform, _ecuId, _cmInfo)) {
+        , _loggerImpl(createLoggerImpl(_carPlatform, _ecuId, _cmInfo, mode)) {
 	}
 
 	Logger::~Logger() { stop(); }
@@ -474,20 +732,43 @@ namespace logger {
 				callback->onStatusChanged(true);
 			}
 		}
-        const size_t maxErrorCount = 10;
-        size_t errorCount = 0;
         auto channel{_j2534ChannelProvider.getChannelForEcu(_ecuId)};
         const auto startTimepoint{ std::chrono::steady_clock::now() };
-        for (size_t timeoffset = 0; errorCount < maxErrorCount; timeoffset += 50) {
-			{
-				std::unique_lock<std::mutex> lock{ _mutex };
-				if (_stopped)
-					break;
+        if (_loggerImpl->isStreaming()) {
+            auto rawChannel{_j2534ChannelProvider.getRawChannelForEcu(_ecuId)};
+            if (rawChannel) {
+                receiveRecords(*channel, *rawChannel, startTimepoint);
+            }
+            else {
+                LOG_MODULE(ERROR) << "Failed to open CAN channel for periodic data";
+            }
+        }
+        else {
+            pollRecords(*channel, startTimepoint);
+        }
+        {
+            std::unique_lock<std::mutex> lock{ _mutex };
+            _stopped = true;
+        }
+        {
+			std::unique_lock<std::mutex> lock{ _callbackMutex };
+            _callbackCond.notify_all();
+            for (const auto callback : _callbacks) {
+				callback->onStatusChanged(false);
 			}
+		}
+	}
+
+    void Logger::pollRecords(common::ICanChannel& channel, std::chrono::steady_clock::time_point startTimepoint) {
+        const size_t maxErrorCount = 10;
+        size_t errorCount = 0;
+        for (size_t timeoffset = 0; errorCount < maxErrorCount; timeoffset += 50) {
+            if (isStopped())
+                break;
             try {
-                channel->clearRx();
-                channel->clearTx();
-                auto logRecord = _loggerImpl->requestMemory(*channel, _parameters);
+                channel.clearRx();
+                channel.clearTx();
+                auto logRecord = _loggerImpl->requestMemory(channel, _parameters);
                 const auto now{ std::chrono::steady_clock::now() };
                 pushRecord(LogRecord(std::chrono::duration_cast<std::chrono::milliseconds>(
                     now - startTimepoint),
@@ -501,18 +782,56 @@ namespace logger {
             _cond.wait_until(lock,
                 startTimepoint + std::chrono::milliseconds(timeoffset));
         }
-        {
-            std::unique_lock<std::mutex> lock{ _mutex };
-            _stopped = true;
+    }
+
+    // Значения приходят от ЭБУ без запросов, поэтому цикл не привязан к
+    // сетке 50 мс: запись добавляется сразу, как только собран полный набор.
+    void Logger::receiveRecords(common::ICanChannel& channel, common::ICanChannel& rawChannel,
+                                std::chrono::steady_clock::time_point startTimepoint) {
+        // Короткое ожидание, чтобы stop() не ждал следующего набора данных.
+        const unsigned long receiveTimeout = 100;
+        // Без данных дольше этого времени передача считается прерванной.
+        const auto maxSilence{ std::chrono::seconds(3) };
+        const size_t maxErrorCount = 10;
+        size_t errorCount = 0;
+        channel.clearRx();
+        try {
+            _loggerImpl->startStreaming(channel, rawChannel);
         }
-        {
-			std::unique_lock<std::mutex> lock{ _callbackMutex };
-            _callbackCond.notify_all();
-            for (const auto callback : _callbacks) {
-				callback->onStatusChanged(false);
-			}
-		}
-	}
+        catch (const std::exception& ex) {
+            LOG_MODULE(ERROR) << "Failed to start periodic transmission: " << ex.what();
+            _loggerImpl->stopStreaming(channel, rawChannel);
+            return;
+        }
+        auto lastRecordTimepoint{ std::chrono::steady_clock::now() };
+        while (errorCount < maxErrorCount && !isStopped()) {
+            try {
+                auto values = _loggerImpl->receiveValues(rawChannel, _parameters, receiveTimeout);
+                const auto now{ std::chrono::steady_clock::now() };
+                if (values) {
+                    pushRecord(LogRecord(std::chrono::duration_cast<std::chrono::milliseconds>(
+                        now - startTimepoint),
+                        std::move(*values)));
+                    lastRecordTimepoint = now;
+                    errorCount = 0;
+                }
+                else if (now - lastRecordTimepoint > maxSilence) {
+                    LOG_MODULE(ERROR) << "No periodic data received";
+                    break;
+                }
+            }
+            catch (const std::exception& ex) {
+                LOG_MODULE(ERROR) << ex.what();
+                ++errorCount;
+            }
+        }
+        _loggerImpl->stopStreaming(channel, rawChannel);
+    }
+
+    bool Logger::isStopped() {
+        std::unique_lock<std::mutex> lock{ _mutex };
+        return _stopped;
+    }
 
 	void Logger::pushRecord(Logger::LogRecord&& record) {
 		std::unique_lock<std::mutex> lock{ _callbackMutex };
@@ -0,0 +1,64 @@
+#include "ParameterReadPlan.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace logger {
+
+ParameterReadPlan::ParameterReadPlan(const LogParameters& parameters, size_t maxBlockSize)
+{
+    if (maxBlockSize == 0) {
+        throw std::invalid_argument("Block size must not be zero");
+    }
+    const auto& params = parameters.parameters();
+    _parameterOffsets.resize(params.size());
+    _parameterSizes.resize(params.size());
+
+    std::vector<size_t> order(params.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&params](size_t lhs, size_t rhs) {
+        return params[lhs].addr() < params[rhs].addr();
+    });
+
+    const auto addBlocks = [this, maxBlockSize](uint64_t begin, uint64_t end) {
+        for (uint64_t addr = begin; addr < end; addr += maxBlockSize) {
+            const auto size = static_cast<size_t>(std::min<uint64_t>(maxBlockSize, end - addr));
+            _blocks.push_back({ static_cast<uint32_t>(addr), size, _dataSize });
+            _dataSize += size;
+        }
+    };
+
+    // Область [begin, end) копится, пока следующий параметр начинается не
+    // дальше её конца. Внутри области поток непрерывен, поэтому смещение
+    // параметра известно сразу, ещё до нарезки области на блоки.
+    uint64_t begin{ 0 };
+    uint64_t end{ 0 };
+    for (const auto index : order) {
+        const uint64_t addr{ params[index].addr() };
+        const uint64_t paramEnd{ addr + params[index].size() };
+        if (begin == end || addr > end) {
+            addBlocks(begin, end);
+            begin = addr;
+            end = paramEnd;
+        }
+        else {
+            end = std::max(end, paramEnd);
+        }
+        _parameterOffsets[index] = _dataSize + static_cast<size_t>(addr - begin);
+        _parameterSizes[index] = params[index].size();
+    }
+    addBlocks(begin, end);
+}
+
+std::span<const uint8_t> ParameterReadPlan::parameterData(size_t index, std::span<const uint8_t> data) const
+{
+    const size_t offset = _parameterOffsets.at(index);
+    const size_t size = _parameterSizes.at(index);
+    if (offset + size > data.size()) {
+        return {};
+    }
+    return data.subspan(offset, size);
+}
+
+} // namespace logger
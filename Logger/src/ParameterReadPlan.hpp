@@ -0,0 +1,43 @@
+#pragma once
+
+#include "logger/LogParameters.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace logger {
+
+// Раскладка параметров лога по минимальному числу запросов к памяти ЭБУ.
+// Параметры сортируются по адресу, смежные и перекрывающиеся области
+// сливаются и режутся на блоки не длиннее maxBlockSize. Данные блоков,
+// прочитанные подряд в порядке blocks(), образуют один поток, в котором
+// у каждого параметра своё смещение.
+class ParameterReadPlan {
+public:
+    struct Block {
+        uint32_t addr;
+        size_t size;
+        size_t offset;  // смещение блока в потоке данных
+    };
+
+    ParameterReadPlan() = default;
+    ParameterReadPlan(const LogParameters& parameters, size_t maxBlockSize);
+
+    const std::vector<Block>& blocks() const { return _blocks; }
+    // Суммарный размер данных всех блоков.
+    size_t dataSize() const { return _dataSize; }
+
+    // Байты параметра index в потоке data. Если поток короче, чем нужно, -
+    // пустой span.
+    std::span<const uint8_t> parameterData(size_t index, std::span<const uint8_t> data) const;
+
+private:
+    std::vector<Block> _blocks;
+    std::vector<size_t> _parameterOffsets;
+    std::vector<size_t> _parameterSizes;
+    size_t _dataSize{ 0 };
+};
+
+} // namespace logger
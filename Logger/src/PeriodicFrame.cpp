@@ -0,0 +1,34 @@
+#include "PeriodicFrame.hpp"
+
+#include <common/Util.hpp>
+
+namespace logger {
+
+std::optional<PeriodicFrame> parsePeriodicFrame(std::span<const uint8_t> frame)
+{
+    if (frame.empty()) {
+        return std::nullopt;
+    }
+    // Single frame: старшая тетрада PCI нулевая, длина до 7 байт.
+    const size_t length = frame[0];
+    if (length >= 1 && length <= 7 && length < frame.size()) {
+        const auto payload{ frame.subspan(1, length) };
+        if (payload[0] == 0x7F) {
+            common::checkUDSError(0x2A, payload.data(), payload.size());
+            return std::nullopt;
+        }
+        // Ответ на TesterPresent.
+        if (payload[0] == 0x7E && payload.size() == 2) {
+            return std::nullopt;
+        }
+        if (payload[0] == 0x6A) {
+            if (payload.size() < 2) {
+                return std::nullopt;
+            }
+            return PeriodicFrame{ payload[1], payload.subspan(2) };
+        }
+    }
+    return PeriodicFrame{ frame[0], frame.subspan(1) };
+}
+
+} // namespace logger
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace logger {
+
+// Один DID периодической передачи (0x2A).
+struct PeriodicFrame {
+    uint8_t periodicId;  // младший байт DID 0xF2xx
+    std::span<const uint8_t> data;
+};
+
+// Разбирает кадр с CAN id ответа ЭБУ, принятый сырым CAN каналом: периодические
+// ответы идут мимо ISO-TP. Тип 1 - [pDID, данные...] без PCI, тип 2 - single
+// frame [PCI, 0x6A, pDID, данные...]. Подтверждения 0x6A и 0x7E без данных
+// пропускаются, отказ на 0x2A бросает UDSError.
+std::optional<PeriodicFrame> parsePeriodicFrame(std::span<const uint8_t> frame);
+
+} // namespace logger
@@ -0,0 +1,92 @@
+#define BOOST_TEST_MODULE Logger
+#include <boost/test/unit_test.hpp>
+
+#include <easylogging++.h>
+INITIALIZE_EASYLOGGINGPP
+
+#include "../src/DidPacker.hpp"
+#include "../src/ParameterReadPlan.hpp"
+#include <logger/LogParameters.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace logger;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+namespace {
+
+constexpr uint16_t didBase = 0xF200;
+
+LogParameter makeParameter(uint32_t addr, size_t size)
+{
+    return LogParameter{ "p", addr, size, DataType::Int, 0xFFFFFFFF, "", false, false, 1.0, 0.0, "" };
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Test: крупные блоки раскладываются первыми, мелкие добивают свободное место
+// ---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(DidPackerFirstFitDecreasing)
+{
+    const LogParameters parameters{ std::vector<LogParameter>{
+        makeParameter(0x1000, 2),
+        makeParameter(0x2000, 6),
+        makeParameter(0x3000, 3),
+        makeParameter(0x4000, 5) } };
+    const ParameterReadPlan plan{ parameters, 8 };
+
+    const auto dids = packDids(plan, 8, didBase);
+
+    BOOST_REQUIRE_EQUAL(dids.size(), 2u);
+    BOOST_CHECK_EQUAL(dids[0].didId, 0xF200);
+    BOOST_CHECK_EQUAL(dids[0].size, 8u);
+    BOOST_CHECK(dids[0].blockIndexes == (std::vector<size_t>{ 1, 0 }));
+    BOOST_CHECK_EQUAL(dids[1].didId, 0xF201);
+    BOOST_CHECK_EQUAL(dids[1].size, 8u);
+    BOOST_CHECK(dids[1].blockIndexes == (std::vector<size_t>{ 3, 2 }));
+}
+
+// ---------------------------------------------------------------------------
+// Test: каждый блок попадает ровно в один DID, размер DID не превышает лимит
+// ---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(DidPackerRespectsMaxDataSize)
+{
+    const LogParameters parameters{ std::vector<LogParameter>{
+        makeParameter(0x1000, 20),
+        makeParameter(0x2000, 4),
+        makeParameter(0x3000, 1),
+        makeParameter(0x3004, 2) } };
+    const ParameterReadPlan plan{ parameters, 8 };
+
+    const auto dids = packDids(plan, 8, didBase);
+
+    std::vector<size_t> seen(plan.blocks().size(), 0);
+    for (size_t i = 0; i < dids.size(); ++i) {
+        BOOST_CHECK_EQUAL(dids[i].didId, didBase + i);
+        BOOST_CHECK_LE(dids[i].size, 8u);
+        size_t size = 0;
+        for (const auto blockIndex : dids[i].blockIndexes) {
+            ++seen.at(blockIndex);
+            size += plan.blocks()[blockIndex].size;
+        }
+        BOOST_CHECK_EQUAL(dids[i].size, size);
+    }
+    for (const auto count : seen) {
+        BOOST_CHECK_EQUAL(count, 1u);
+    }
+    // 8 + 8 + 4 + 4 + 1 + 2 = 27 байт - не меньше четырёх DID по 8 байт.
+    BOOST_CHECK_EQUAL(dids.size(), 4u);
+}
+
+// ---------------------------------------------------------------------------
+// Test: пустой план - ни одного DID
+// ---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(DidPackerEmptyPlan)
+{
+    const ParameterReadPlan plan{ LogParameters{}, 8 };
+    BOOST_CHECK(packDids(plan, 8, didBase).empty());
+}
@@ -0,0 +1,101 @@
+#include <boost/test/unit_test.hpp>
+
+#include "../src/ParameterReadPlan.hpp"
+#include <logger/LogParameters.hpp>
+
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using namespace logger;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+namespace {
+
+LogParameter makeParameter(uint32_t addr, size_t size)
+{
+    return LogParameter{ "p", addr, size, DataType::Int, 0xFFFFFFFF, "", false, false, 1.0, 0.0, "" };
+}
+
+std::vector<uint8_t> makeStream(size_t size)
+{
+    std::vector<uint8_t> data(size);
+    std::iota(data.begin(), data.end(), static_cast<uint8_t>(0));
+    return data;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// Test: смежные и перекрывающиеся параметры читаются одним блоком
+// ---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ParameterReadPlanMergesAdjacentAndOverlapping)
+{
+    const LogParameters parameters{ std::vector<LogParameter>{
+        makeParameter(0x1002, 2),
+        makeParameter(0x1000, 2),
+        makeParameter(0x1001, 4),
+        makeParameter(0x2000, 1) } };
+    const ParameterReadPlan plan{ parameters, 0x40 };
+
+    BOOST_REQUIRE_EQUAL(plan.blocks().size(), 2u);
+    BOOST_CHECK_EQUAL(plan.blocks()[0].addr, 0x1000u);
+    BOOST_CHECK_EQUAL(plan.blocks()[0].size, 5u);
+    BOOST_CHECK_EQUAL(plan.blocks()[0].offset, 0u);
+    BOOST_CHECK_EQUAL(plan.blocks()[1].addr, 0x2000u);
+    BOOST_CHECK_EQUAL(plan.blocks()[1].size, 1u);
+    BOOST_CHECK_EQUAL(plan.blocks()[1].offset, 5u);
+    BOOST_CHECK_EQUAL(plan.dataSize(), 6u);
+
+    const auto data = makeStream(plan.dataSize());
+    BOOST_CHECK(plan.parameterData(0, data).data() == data.data() + 2);
+    BOOST_CHECK(plan.parameterData(1, data).data() == data.data() + 0);
+    BOOST_CHECK(plan.parameterData(2, data).data() == data.data() + 1);
+    BOOST_CHECK_EQUAL(plan.parameterData(2, data).size(), 4u);
+    BOOST_CHECK(plan.parameterData(3, data).data() == data.data() + 5);
+}
+
+// ---------------------------------------------------------------------------
+// Test: длинная область режется на блоки не длиннее maxBlockSize
+// ---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ParameterReadPlanSplitsLongRegions)
+{
+    const LogParameters parameters{ std::vector<LogParameter>{
+        makeParameter(0x1000, 4),
+        makeParameter(0x1004, 4),
+        makeParameter(0x1008, 2) } };
+    const ParameterReadPlan plan{ parameters, 4 };
+
+    BOOST_REQUIRE_EQUAL(plan.blocks().size(), 3u);
+    for (size_t i = 0; i < plan.blocks().size(); ++i) {
+        BOOST_CHECK_EQUAL(plan.blocks()[i].addr, 0x1000u + i * 4);
+        BOOST_CHECK_EQUAL(plan.blocks()[i].offset, i * 4);
+    }
+    BOOST_CHECK_EQUAL(plan.blocks()[2].size, 2u);
+    BOOST_CHECK_EQUAL(plan.dataSize(), 10u);
+
+    const auto data = makeStream(plan.dataSize());
+    BOOST_CHECK(plan.parameterData(1, data).data() == data.data() + 4);
+    BOOST_CHECK(plan.parameterData(2, data).data() == data.data() + 8);
+}
+
+// ---------------------------------------------------------------------------
+// Test: короткий поток и нулевой размер блока
+// ---------------------------------------------------------------------------
+BOOST_AUTO_TEST_CASE(ParameterReadPlanRejectsShortDataAndZeroBlock)
+{
+    const LogParameters parameters{ std::vector<LogParameter>{
+        makeParameter(0x1000, 4),
+        makeParameter(0x2000, 4) } };
+    const ParameterReadPlan plan{ parameters, 0x40 };
+
+    const auto data = makeStream(6);
+    BOOST_CHECK_EQUAL(plan.parameterData(0, data).size(), 4u);
+    BOOST_CHECK(plan.parameterData(1, data).empty());
+    BOOST_CHECK_THROW(plan.parameterData(2, data), std::out_of_range);
+
+    BOOST_CHECK_THROW((ParameterReadPlan{ parameters, 0 }), std::invalid_argument);
+}
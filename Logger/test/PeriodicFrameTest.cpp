@@ -0,0 +1,40 @@
+#include <boost/test/unit_test.hpp>
+
+#include "../src/PeriodicFrame.hpp"
+#include <common/protocols/UDSError.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace logger;
+
+BOOST_AUTO_TEST_CASE(PeriodicFrameWithoutPci)
+{
+    const std::vector<uint8_t> frame{ 0x00, 1, 2, 3, 4, 5, 6, 7 };
+    const auto periodicFrame{ parsePeriodicFrame(frame) };
+    BOOST_REQUIRE(periodicFrame);
+    BOOST_CHECK_EQUAL(periodicFrame->periodicId, 0x00);
+    const std::vector<uint8_t> data{ periodicFrame->data.begin(), periodicFrame->data.end() };
+    BOOST_CHECK(data == (std::vector<uint8_t>{ 1, 2, 3, 4, 5, 6, 7 }));
+}
+
+BOOST_AUTO_TEST_CASE(PeriodicFrameSingleFrame)
+{
+    // Байты после длины PCI - заполнение, в данные не попадают.
+    const std::vector<uint8_t> frame{ 0x05, 0x6A, 0x01, 8, 9, 10, 0xAA, 0xAA };
+    const auto periodicFrame{ parsePeriodicFrame(frame) };
+    BOOST_REQUIRE(periodicFrame);
+    BOOST_CHECK_EQUAL(periodicFrame->periodicId, 0x01);
+    const std::vector<uint8_t> data{ periodicFrame->data.begin(), periodicFrame->data.end() };
+    BOOST_CHECK(data == (std::vector<uint8_t>{ 8, 9, 10 }));
+}
+
+BOOST_AUTO_TEST_CASE(PeriodicFrameSkipsDiagnosticResponses)
+{
+    BOOST_CHECK(!parsePeriodicFrame(std::vector<uint8_t>{ 0x01, 0x6A, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA }));
+    BOOST_CHECK(!parsePeriodicFrame(std::vector<uint8_t>{ 0x02, 0x7E, 0x00, 0xAA, 0xAA, 0xAA, 0xAA, 0xAA }));
+    BOOST_CHECK(!parsePeriodicFrame(std::vector<uint8_t>{ 0x03, 0x7F, 0x22, 0x31, 0xAA, 0xAA, 0xAA, 0xAA }));
+    BOOST_CHECK(!parsePeriodicFrame(std::vector<uint8_t>{}));
+    BOOST_CHECK_THROW(parsePeriodicFrame(std::vector<uint8_t>{ 0x03, 0x7F, 0x2A, 0x31, 0xAA, 0xAA, 0xAA, 0xAA }),
+        common::UDSError);
+}
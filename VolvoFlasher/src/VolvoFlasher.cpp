@@ -7,10 +7,15 @@
 #include <common/protocols/TP20RequestProcessor.hpp>
 #include <common/protocols/TP20Session.hpp>
 #include <common/protocols/UDSProtocolCommonSteps.hpp>
+#include <common/protocols/UDSPinCache.hpp>
 #include <common/protocols/UDSPinFinder.hpp>
 #include <common/protocols/UDSRequest.hpp>
+#include <common/protocols/UDSSession.hpp>
 #include <common/CanAlarmClock.hpp>
+#include <common/CanIdProvider.hpp>
 #include <common/CommonData.hpp>
+#include <common/DiagnosticsSweep.hpp>
+#include <common/J2534ChannelProvider.hpp>
 #include <common/ProtocolType.hpp>
 #include <common/VBFParser.hpp>
 #include <common/VBFUtil.hpp>
@@ -22,12 +27,14 @@
 #include <j2534/J2534Channel.hpp>
 
 #include <flasher/D2Flasher.hpp>
+#include <flasher/D2MultiFlasher.hpp>
 #include <flasher/ReaderBase.hpp>
 #include <flasher/ReaderFactory.hpp>
 #include <flasher/ReaderParametersProviderBase.hpp>
 #include <flasher/SBLProviderVBF.hpp>
 #include <flasher/SBLProviderCommon.hpp>
 #include <flasher/UDSFlasher.hpp>
+#include <flasher/UDSMultiFlasher.hpp>
 #include <flasher/KWPFlasher.hpp>
 
 #include <argparse/argparse.hpp>
@@ -40,6 +47,7 @@
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <thread>
 #include <chrono>
 #include <iomanip>
@@ -49,6 +57,9 @@ INITIALIZE_EASYLOGGINGPP
 
 bool stopRequested = false;
 
+// Найденные и подошедшие PIN по VIN и ЭБУ, чтобы не указывать их каждый раз.
+const char* const PinCacheFileName = "VolvoFlasher.pins";
+
 enum class RunMode
 {
 	None,
@@ -56,13 +67,64 @@ enum class RunMode
 	Read,
 	Wakeup,
 	Pin,
+	Scan,
 	Test
 };
 
+// ЭБУ, прошиваемый вместе с основным за один сон шины.
+struct FlashTarget {
+	uint8_t ecuId;
+	std::string flashPath;
+	std::string sblPath;
+	// 0 - PIN, который уже подходил к этому ЭБУ этой машины (UDSPinCache).
+	uint64_t pin{ 0 };
+};
+
+// "ECU,FILE[,SBL[,PIN]]", ECU и PIN в hex, SBL может быть пустым.
+FlashTarget parseFlashTarget(const std::string& value)
+{
+	std::vector<std::string> fields;
+	for (size_t begin = 0;;) {
+		const auto end = value.find(',', begin);
+		fields.push_back(value.substr(begin, end == std::string::npos ? std::string::npos : end - begin));
+		if (end == std::string::npos) {
+			break;
+		}
+		begin = end + 1;
+	}
+	if (fields.size() < 2 || fields.size() > 4) {
+		throw std::runtime_error("Wrong target '" + value + "', expected ECU,FILE[,SBL[,PIN]]");
+	}
+	FlashTarget target;
+	target.ecuId = static_cast<uint8_t>(std::stoul(fields[0], nullptr, 16));
+	target.flashPath = fields[1];
+	if (fields.size() > 2) {
+		target.sblPath = fields[2];
+	}
+	if (fields.size() > 3) {
+		target.pin = std::stoull(fields[3], nullptr, 16);
+	}
+	return target;
+}
+
+// Ключ шифрования из командной строки в hex, каждый байт - символ строки ключа.
+std::string parseEncryptionKey(const std::string& value)
+{
+	if (value.size() % 2 != 0) {
+		throw std::runtime_error("Wrong key '" + value + "', expected even number of hex digits");
+	}
+	std::string key;
+	for (size_t i = 0; i < value.size(); i += 2) {
+		key.push_back(static_cast<char>(std::stoul(value.substr(i, 2), nullptr, 16)));
+	}
+	return key;
+}
+
 bool getRunOptions(int argc, const char* argv[], std::string& deviceName,
 	unsigned long& baudrate, std::string& flashPath, uint64_t& pin,
 	uint8_t& ecuId, unsigned long& start, unsigned long& datasize,
-	RunMode& runMode, std::string& sblPath, common::CarPlatform& carPlatform, bool& pinUpward, bool& verbose) {
+	RunMode& runMode, std::string& sblPath, common::CarPlatform& carPlatform, bool& pinUpward, bool& verbose, bool& optimalCompression,
+	std::vector<FlashTarget>& flashTargets, std::string& encryptionKey) {
 	argparse::ArgumentParser program("VolvoFlasher", "1.0", argparse::default_arguments::help);
 	program.add_argument("-d", "--device").default_value(std::string{}).help("Device name");
 	program.add_argument("-b", "--baudrate").scan<'u', unsigned long>().default_value(500000u).help("CAN bus speed");
@@ -75,6 +137,9 @@ bool getRunOptions(int argc, const char* argv[], std::string& deviceName,
 	flash_command.add_description("Flash BIN to ECU");
 	flash_command.add_argument("-i", "--input").help("File to flash");
 	flash_command.add_argument("-s", "--sbl").default_value(std::string()).help("File with SBL");
+	flash_command.add_argument("--optimal").default_value(false).implicit_value(true).nargs(0).help("Compress flash with optimal LZSS parsing: slower, but fewer bytes to transfer");
+	flash_command.add_argument("-k", "--key").default_value(std::string()).help("Key in hex for ECUs which accept XOR encrypted flash");
+	flash_command.add_argument("-t", "--target").append().help("One more ECU of the same bus to flash in one session: ECU,FILE[,SBL[,PIN]], without PIN the cached one is used");
 
 	argparse::ArgumentParser read_command("read", "1.0", argparse::default_arguments::help);
 	read_command.add_description("Read BIN from ECU");
@@ -92,16 +157,27 @@ bool getRunOptions(int argc, const char* argv[], std::string& deviceName,
 	argparse::ArgumentParser wakeup_command("wakeup", "1.0", argparse::default_arguments::help);
 	wakeup_command.add_description("Wake up CAN network");
 
+	argparse::ArgumentParser scan_command("scan", "1.0", argparse::default_arguments::help);
+	scan_command.add_description("Read identification and DTC from all ECUs of the platform");
+
 	program.add_subparser(flash_command);
 	program.add_subparser(read_command);
 	program.add_subparser(test_command);
 	program.add_subparser(pin_command);
 	program.add_subparser(wakeup_command);
+	program.add_subparser(scan_command);
 	try {
 		program.parse_args(argc, argv);
 		if (program.is_subcommand_used(flash_command)) {
 			flashPath = flash_command.get("-i");
 			sblPath = flash_command.get("-s");
+			optimalCompression = flash_command.get<bool>("--optimal");
+			encryptionKey = parseEncryptionKey(flash_command.get("-k"));
+			if (const auto targets{ flash_command.present<std::vector<std::string>>("--target") }) {
+				for (const auto& target : *targets) {
+					flashTargets.push_back(parseFlashTarget(target));
+				}
+			}
 			runMode = RunMode::Flash;
 		}
 		else if (program.is_subcommand_used(read_command)) {
@@ -120,6 +196,9 @@ bool getRunOptions(int argc, const char* argv[], std::string& deviceName,
 		else if (program.is_subcommand_used(wakeup_command)) {
 			runMode = RunMode::Wakeup;
 		}
+		else if (program.is_subcommand_used(scan_command)) {
+			runMode = RunMode::Scan;
+		}
 		else {
 			std::cout << program;
 			return false;
@@ -525,7 +604,37 @@ void findPin(j2534::J2534& j2534, uint64_t i = 0)
 	}
 }
 
-void findPin2(j2534::J2534& j2534, common::CarPlatform carPlatform, uint8_t ecuId, uint64_t startPin = 0, bool upward = true)
+// Найденный PIN проверяется авторизацией через сессию запуска: подошедший
+// запоминается в UDSPinCache по VIN, а сессия остаётся открытой.
+bool verifyPin(j2534::J2534& j2534, common::CarPlatform carPlatform, uint8_t ecuId, common::UDSSession& session, uint64_t pin)
+{
+	const auto canIdProvider{ common::createCanIdProviderForEcu(carPlatform, ecuId) };
+	const auto funcCanId{ canIdProvider->getFuncCanId() };
+	const auto physCanId{ canIdProvider->getPhysCanId() };
+	bool verified = false;
+	session.suspend();
+	{
+		common::J2534ChannelProvider channelProvider(j2534, carPlatform);
+		const auto channels{ channelProvider.getAllChannels(ecuId) };
+		auto& channel = *channels[0];
+		session.resolvePin(channel, pin);
+		common::UDSProtocolCommonSteps::fallAsleep(channels, funcCanId);
+		const auto timing{ common::UDSProtocolCommonSteps::readSessionTiming(channel, physCanId, 0x02) };
+		verified = common::UDSProtocolCommonSteps::authorize(channel, physCanId, common::getPinArray(pin));
+		if (verified) {
+			session.opened(timing, pin);
+			session.leave();
+		}
+		else {
+			common::UDSProtocolCommonSteps::wakeUp(channels, funcCanId);
+		}
+	}
+	session.resume();
+	return verified;
+}
+
+void findPin2(j2534::J2534& j2534, common::CarPlatform carPlatform, uint8_t ecuId, uint64_t startPin = 0, bool upward = true,
+	std::shared_ptr<common::UDSSession> session = {})
 {
 	std::chrono::time_point savedTime = std::chrono::steady_clock::now();
 	uint64_t savedPin = startPin;
@@ -564,6 +673,11 @@ void findPin2(j2534::J2534& j2534, common::CarPlatform carPlatform, uint8_t ecuI
 		if (const auto foundPin{ pinFinder.getFoundPin() }) {
 			std::cout << "Found PIN code "
 				<< std::hex << std::setfill('0') << *foundPin << std::endl;
+			if (session) {
+				std::cout << (verifyPin(j2534, carPlatform, ecuId, *session, *foundPin)
+					? "PIN code verified"
+					: "PIN code isn't accepted") << std::endl;
+			}
 		}
 		else {
 			std::cout << "Last checked PIN code "
@@ -691,7 +805,8 @@ void doSomeStuff(std::unique_ptr<j2534::J2534> j2534, uint64_t pin)
 }
 
 void UDSFlash(common::CarPlatform carPlatform, uint8_t ecuId,
-	std::unique_ptr<j2534::J2534> j2534, unsigned long baudrate, uint64_t pin, const std::string& flashPath, const std::string& sblPath)
+	j2534::J2534& j2534, unsigned long baudrate, uint64_t pin, const std::string& flashPath, const std::string& sblPath,
+	bool optimalCompression, const std::string& encryptionKey, std::shared_ptr<common::UDSSession> session)
 {
 	common::VBFParser vbfParser;
 	std::ifstream sblVbf(sblPath, std::ios_base::binary);
@@ -702,8 +817,24 @@ void UDSFlash(common::CarPlatform carPlatform, uint8_t ecuId,
 
     std::array<uint8_t, 5> pinArray = {
         (pin >> 32) & 0xFF, (pin >> 24) & 0xFF, (pin >> 16) & 0xFF, (pin >> 8) & 0xFF, pin & 0xFF };
-    flasher::UDSFlasherConfig config{ pinArray, bootloader, flash };
-    flasher::UDSFlasher flasher{ *j2534, carPlatform, ecuId, std::move(config) };
+    const auto encryptionType{ std::get<1>(ecuInfo).encryptionType };
+    // Проверяется до засыпания шины: без ключа поток прошивки не подготовить.
+    std::map<std::string, std::string> encryptionParams;
+    if (encryptionType == common::EncryptionType::XOR) {
+        if (encryptionKey.empty()) {
+            throw std::runtime_error("ECU accepts XOR encrypted flash only, pass the key with flash --key");
+        }
+        encryptionParams["key"] = encryptionKey;
+    }
+    else if (encryptionType == common::EncryptionType::AES) {
+        throw std::runtime_error("ECU accepts AES encrypted flash only, which isn't supported");
+    }
+    flasher::UDSFlasherConfig config{ pinArray, bootloader, flash,
+        std::get<1>(ecuInfo).compressionType, encryptionType, std::move(encryptionParams) };
+    config.optimalCompression = optimalCompression;
+    // Без -p берётся PIN, который уже подходил к этому ЭБУ этой машины.
+    config.session = std::move(session);
+    flasher::UDSFlasher flasher{ j2534, carPlatform, ecuId, std::move(config) };
 	FlasherCallback callback;
 	flasher.registerCallback(callback);
 	flasher.start();
@@ -757,6 +888,71 @@ void D2Flash(const std::string& flashPath, std::unique_ptr<j2534::J2534> j2534,
 		<< std::endl;
 }
 
+bool runFlasher(flasher::FlasherBase& flasher)
+{
+	FlasherCallback callback;
+	flasher.registerCallback(callback);
+	flasher.start();
+	while (flasher.getCurrentState() != flasher::FlasherState::Done
+		&& flasher.getCurrentState() != flasher::FlasherState::Error) {
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+		std::cout << ".";
+	}
+	const bool success = flasher.getCurrentState() == flasher::FlasherState::Done;
+	std::cout << std::endl << (success ? "Flashing done" : "Flashing error. Try again.") << std::endl;
+	flasher.unregisterCallback(callback);
+	return success;
+}
+
+// Все ЭБУ одной шины прошиваются за один сон, загрузка в них чередуется.
+void UDSMultiFlash(common::CarPlatform carPlatform, const std::vector<FlashTarget>& targets,
+	std::unique_ptr<j2534::J2534> j2534, bool optimalCompression, const std::string& encryptionKey)
+{
+	common::VBFParser vbfParser;
+	flasher::UDSMultiFlasherConfig config;
+	for (const auto& target : targets) {
+		const auto ecuInfo{ std::get<1>(common::getEcuInfoByEcuId(carPlatform, target.ecuId)) };
+		// Ключ -k задан для основного ЭБУ, у остальных он свой.
+		std::map<std::string, std::string> encryptionParams;
+		if (ecuInfo.encryptionType == common::EncryptionType::XOR && &target == &targets.front() && !encryptionKey.empty()) {
+			encryptionParams["key"] = encryptionKey;
+		}
+		else if (ecuInfo.encryptionType != common::EncryptionType::None) {
+			throw std::runtime_error("ECU " + std::to_string(target.ecuId) + " accepts encrypted flash only, flash it alone with --key");
+		}
+		std::ifstream flashVbf(target.flashPath, std::ios_base::binary);
+		flasher::UDSMultiFlasherTarget flasherTarget{ target.ecuId, common::getPinArray(target.pin),
+			common::VBF{}, vbfParser.parse(flashVbf), ecuInfo.compressionType, ecuInfo.encryptionType,
+			std::move(encryptionParams), optimalCompression };
+		if (!target.sblPath.empty()) {
+			std::ifstream sblVbf(target.sblPath, std::ios_base::binary);
+			flasherTarget.bootloader = vbfParser.parse(sblVbf);
+		}
+		config.targets.push_back(std::move(flasherTarget));
+	}
+	flasher::UDSMultiFlasher flasher{ *j2534, carPlatform, std::move(config) };
+	runFlasher(flasher);
+}
+
+// ЭБУ D2 прошиваются по очереди, следующий готовится, пока пишется текущий.
+void D2MultiFlash(const std::vector<FlashTarget>& targets, std::unique_ptr<j2534::J2534> j2534, unsigned long baudrate)
+{
+	const auto carPlatform = baudrate == 500000 ? common::CarPlatform::P2 : common::CarPlatform::P2_250;
+	flasher::SBLProviderCommon sblProviderCommon;
+	flasher::D2MultiFlasherConfig config;
+	for (const auto& target : targets) {
+		// Загрузчик D2 встроенный, PIN не нужен - заданные явно не молча теряются, а отвергаются.
+		if (!target.sblPath.empty() || target.pin != 0) {
+			throw std::runtime_error("ECU " + std::to_string(target.ecuId) + " is flashed with the built-in SBL and without PIN, remove them from the target");
+		}
+		std::ifstream input(target.flashPath, std::ios_base::binary);
+		const std::vector<uint8_t> bin{ std::istreambuf_iterator<char>(input), {} };
+		config.targets.push_back({ target.ecuId, sblProviderCommon.getSBL(carPlatform, target.ecuId, ""), vbfForFlasher(bin) });
+	}
+	flasher::D2MultiFlasher flasher{ *j2534, carPlatform, std::move(config) };
+	runFlasher(flasher);
+}
+
 uint16_t crc16(const uint8_t* data_p, size_t length) {
 	unsigned char x;
 	uint16_t crc = 0xFFFF;
@@ -771,6 +967,23 @@ uint16_t crc16(const uint8_t* data_p, size_t length) {
 
 std::unordered_map<uint16_t, uint8_t> g_crc16_map;
 
+void scanEcus(j2534::J2534& j2534, common::CarPlatform carPlatform)
+{
+	common::J2534ChannelProvider channelProvider{ j2534, carPlatform };
+	const auto report{ common::DiagnosticsSweep{ carPlatform }.run(channelProvider.getAllChannels()) };
+	for (const auto& ecu : report) {
+		std::cout << ecu.ecu.name << " (" << ecu.busName << ", 0x" << std::hex << ecu.ecu.ecuId << std::dec << ")" << std::endl;
+		for (const auto& result : ecu.results) {
+			std::cout << "    " << result.name << ": ";
+			if (!result.error.empty()) {
+				std::cout << result.error << std::endl;
+				continue;
+			}
+			std::cout << common::dumpArray(result.response) << std::endl;
+		}
+	}
+}
+
 void fill_crc_map()
 {
 	for (size_t i = 0; i < 255; ++i)
@@ -781,22 +994,32 @@ void fill_crc_map()
 	}
 }
 
-void readFlash(std::unique_ptr<j2534::J2534> j2534, common::CarPlatform carPlatform, uint8_t ecuId, const std::string& flashPath, unsigned long start, unsigned long datasize)
+void readFlash(j2534::J2534& j2534, common::CarPlatform carPlatform, uint8_t ecuId, const std::string& flashPath, unsigned long start, unsigned long datasize,
+	uint64_t pin, std::shared_ptr<common::UDSSession> session)
 {
     class CLIReaderProvider final : public flasher::ReaderParametersProviderBase {
     public:
         CLIReaderProvider(common::CarPlatform platform, uint32_t id,
-                          uint32_t s, size_t sz)
+                          uint32_t s, size_t sz, uint64_t pin)
             : ReaderParametersProviderBase(platform, id, "", std::make_unique<flasher::SBLProviderCommon>())
-            , _range{ s, sz } {}
+            , _range{ s, sz }
+            , _pin{ pin } {}
         flasher::ReadRanges getReadRanges() const override { return {_range}; }
+        std::optional<flasher::AuthorizationParams> getAuthParams() const override
+        {
+            if (_pin == 0) {
+                return std::nullopt;
+            }
+            return flasher::AuthorizationParams{ _pin };
+        }
     private:
         flasher::ReadRange _range;
+        uint64_t _pin;
     };
 
     auto provider = CLIReaderProvider(carPlatform, ecuId,
-        static_cast<uint32_t>(start), static_cast<size_t>(datasize));
-    auto reader = flasher::ReaderFactory::create(*j2534, provider);
+        static_cast<uint32_t>(start), static_cast<size_t>(datasize), pin);
+    auto reader = flasher::ReaderFactory::create(j2534, provider, std::move(session));
     FlasherCallback callback;
     reader->registerCallback(callback);
     reader->start();
@@ -925,11 +1148,18 @@ int main(int argc, const char* argv[]) {
 	RunMode runMode = RunMode::None;
 	bool scanPinsUpward = true;
 	bool verbose = false;
+	bool optimalCompression = false;
+	std::vector<FlashTarget> flashTargets;
+	std::string encryptionKey;
 	const auto devices = common::getAvailableDevices();
-	if (getRunOptions(argc, argv, deviceName, baudrate, flashPath, pin, ecuId, start, datasize, runMode, sblPath, carPlatform, scanPinsUpward, verbose)) {
+	if (getRunOptions(argc, argv, deviceName, baudrate, flashPath, pin, ecuId, start, datasize, runMode, sblPath, carPlatform, scanPinsUpward, verbose, optimalCompression, flashTargets, encryptionKey)) {
         if (verbose) {
             common::initLogger("application.log", true, true);
         }
+		{
+			std::ifstream pinCache(PinCacheFileName);
+			common::UDSPinCache::load(pinCache);
+		}
 		for (const auto& device : devices) {
 			if (deviceName.empty() ||
 				device.deviceName.find(deviceName) != std::string::npos) {
@@ -941,25 +1171,47 @@ int main(int argc, const char* argv[]) {
 					std::unique_ptr<j2534::J2534> j2534{
 						std::make_unique<j2534::J2534>(device.libraryName) };
 					j2534->PassThruOpen(name);
+					// Одна сессия ЭБУ на запуск, общая для чтения, проверки найденного
+					// PIN и прошивки. Объявлена после j2534, поэтому закрывается раньше.
+					std::shared_ptr<common::UDSSession> session;
+					if ((runMode == RunMode::Read || runMode == RunMode::Flash || runMode == RunMode::Pin)
+						&& flashTargets.empty()
+						&& std::get<0>(common::getEcuInfoByEcuId(carPlatform, ecuId)).protocol == common::ProtocolType::ISO15765) {
+						session = std::make_shared<common::UDSSession>(*j2534, carPlatform, ecuId);
+					}
                     if (runMode == RunMode::Wakeup) {
                         common::CanAlarmClock alarmClock(*j2534);
                         alarmClock.start();
 					}
 					else if (runMode == RunMode::Pin) {
-						findPin2(*j2534, carPlatform, ecuId, pin, scanPinsUpward);
+						findPin2(*j2534, carPlatform, ecuId, pin, scanPinsUpward, session);
 					}
 					else if (runMode == RunMode::Read) {
-						readFlash(std::move(j2534), carPlatform, ecuId, flashPath, start, datasize);
+						readFlash(*j2534, carPlatform, ecuId, flashPath, start, datasize, pin, session);
 					}
 					else if (runMode == RunMode::Flash) {
                         const auto ecuInfo{ common::getEcuInfoByEcuId(carPlatform, ecuId) };
-						if (std::get<0>(ecuInfo).protocol == common::ProtocolType::ISO15765) {
-                            UDSFlash(carPlatform, ecuId, std::move(j2534), baudrate, pin, flashPath, sblPath);
+						if (!flashTargets.empty()) {
+							// -p и -s относятся к основному ЭБУ, у остальных они свои в -t.
+							std::vector<FlashTarget> targets{ { ecuId, flashPath, sblPath, pin } };
+							targets.insert(targets.end(), flashTargets.cbegin(), flashTargets.cend());
+							if (std::get<0>(ecuInfo).protocol == common::ProtocolType::ISO15765) {
+								UDSMultiFlash(carPlatform, targets, std::move(j2534), optimalCompression, encryptionKey);
+							}
+							else {
+								D2MultiFlash(targets, std::move(j2534), baudrate);
+							}
+						}
+						else if (std::get<0>(ecuInfo).protocol == common::ProtocolType::ISO15765) {
+                            UDSFlash(carPlatform, ecuId, *j2534, baudrate, pin, flashPath, sblPath, optimalCompression, encryptionKey, session);
 						}
 						else {
 							D2Flash(flashPath, std::move(j2534), baudrate);
 						}
 					}
+					else if (runMode == RunMode::Scan) {
+						scanEcus(*j2534, carPlatform);
+					}
 					else if (runMode == RunMode::Test) {
 						doSomeStuff(std::move(j2534), pin);
 					}
@@ -978,6 +1230,8 @@ int main(int argc, const char* argv[]) {
 				}
 			}
 		}
+		std::ofstream pinCache(PinCacheFileName);
+		common::UDSPinCache::save(pinCache);
 	}
 	else {
 		std::cout << "Available J2534 devices:" << std::endl;
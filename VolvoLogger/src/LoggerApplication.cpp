@@ -17,8 +17,9 @@ void LoggerApplication::start(unsigned long baudrate,
                               const LogParameters &params,
                               const common::CarPlatform carPlatform,
                               uint32_t cmId,
-                              const std::vector<LoggerCallback *> &callbacks) {
-  _logger = std::make_unique<Logger>(j2534, carPlatform, cmId, std::string());
+                              const std::vector<LoggerCallback *> &callbacks,
+                              LoggingMode mode) {
+  _logger = std::make_unique<Logger>(j2534, carPlatform, cmId, std::string(), mode);
   for (const auto &callback : callbacks) {
     _logger->registerCallback(*callback);
   }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <common/CarPlatform.hpp>
+#include <logger/Logger.hpp>
 
 #include <memory>
 #include <string>
@@ -11,7 +12,6 @@ class J2534;
 }
 
 namespace logger {
-class Logger;
 class LogParameters;
 class LoggerCallback;
 
@@ -23,7 +23,8 @@ public:
              const LogParameters &params,
              common::CarPlatform carPlatform,
              uint32_t cmId,
-             const std::vector<LoggerCallback *> &callbacks);
+             const std::vector<LoggerCallback *> &callbacks,
+             LoggingMode mode = LoggingMode::Polling);
   void stop();
 
   bool isStarted() const;
@@ -41,7 +41,8 @@ private:
 
 static bool getRunOptions(int argc, const char *argv[], std::string &deviceName,
                    unsigned long &baudrate, std::string &paramsFilePath,
-                   std::string &outputPath, unsigned &printCount, common::CarPlatform& carPlatform, uint8_t& cmId, bool& verbose) {
+                   std::string &outputPath, unsigned &printCount, common::CarPlatform& carPlatform, uint8_t& cmId, bool& verbose,
+                   logger::LoggingMode& mode) {
   argparse::ArgumentParser program("VolvoLogger");
   program.add_argument("-d", "--device").default_value(std::string{}).help("Device name");
   program.add_argument("-b", "--baudrate").scan<'u', unsigned>().default_value(500000u).help("CAN bus speed");
@@ -51,6 +52,7 @@ static bool getRunOptions(int argc, const char *argv[], std::string &deviceName,
   program.add_argument("--verbose").default_value(false).implicit_value(true).nargs(0).help("Enable verbose (debug) logging");
   program.add_argument("-f", "--platform").default_value(std::string{"P2"}).help("Car's platform, supported values: P80, P1, P1_UDS, P2, P2_250, P2_UDS, P3, SPA");
   program.add_argument("-e", "--ecu").scan<'x', uint8_t>().default_value(uint8_t(0x7A)).help("ECU id to log");
+  program.add_argument("--periodic").default_value(std::string{}).help("UDS periodic transmission rate instead of polling, supported values: slow, medium, fast");
 
   try {
       program.parse_args(argc, argv);
@@ -62,6 +64,18 @@ static bool getRunOptions(int argc, const char *argv[], std::string &deviceName,
       verbose = program.get<bool>("--verbose");
       carPlatform = common::parseCarPlatform(program.get<std::string>("-f"));
       cmId = program.get<uint8_t>("-e");
+      const auto periodic = common::toLower(program.get<std::string>("--periodic"));
+      if (periodic.empty()) {
+          mode = logger::LoggingMode::Polling;
+      } else if (periodic == "slow") {
+          mode = logger::LoggingMode::PeriodicSlow;
+      } else if (periodic == "medium") {
+          mode = logger::LoggingMode::PeriodicMedium;
+      } else if (periodic == "fast") {
+          mode = logger::LoggingMode::PeriodicFast;
+      } else {
+          throw std::runtime_error("Unsupported periodic rate: " + periodic);
+      }
       return true;
   }
   catch (const std::exception& err) {
@@ -89,9 +103,10 @@ int main(int argc, const char *argv[]) {
   uint8_t cmId;
   unsigned printCount;
   bool verbose = false;
+  logger::LoggingMode mode = logger::LoggingMode::Polling;
   const auto devices = common::getAvailableDevices();
   if (getRunOptions(argc, argv, deviceName, baudrate, paramsFilePath,
-                    outputPath, printCount, carPlatform, cmId, verbose)) {
+                    outputPath, printCount, carPlatform, cmId, verbose, mode)) {
     if (verbose) {
       common::initLogger("application.log", true, true);
     }
@@ -111,7 +126,7 @@ int main(int argc, const char *argv[]) {
           ConsoleLogWriter consoleLogWriter{printCount};
           logger::LoggerApplication::instance().start(
               baudrate, *j2534, params, carPlatform, cmId,
-              {&fileLogWriter, &consoleLogWriter});
+              {&fileLogWriter, &consoleLogWriter}, mode);
           while (logger::LoggerApplication::instance().isStarted()) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
           }